@@ -103,7 +103,12 @@ void Agent::perform_action()
     #ifdef MODE_STRATEGO
         info_bestmove(StateConstants::action_to_uci(evalInfo->bestMove, state->is_chess960()) + " equals " + state->action_to_string(evalInfo->bestMove));
     #else
-        info_bestmove(StateConstants::action_to_uci(evalInfo->bestMove, state->is_chess960()));
+        string bestMove = StateConstants::action_to_uci(evalInfo->bestMove, state->is_chess960());
+        // the expected reply allows the GUI to start pondering
+        if (!evalInfo->pv.empty() && evalInfo->pv[0].size() > 1 && evalInfo->pv[0][0] == evalInfo->bestMove) {
+            bestMove += " ponder " + StateConstants::action_to_uci(evalInfo->pv[0][1], state->is_chess960());
+        }
+        info_bestmove(bestMove);
     #endif
     isRunning = false;
 }
@@ -24,6 +24,7 @@
  */
 
 #include "searchsettings.h"
+#include "constants.h"
 
 SearchSettings::SearchSettings() :
     threads(2),
@@ -51,7 +52,22 @@ SearchSettings::SearchSettings() :
     searchPlayerMode(MODE_TWO_PLAYER),
     virtualStyle(VIRTUAL_VISIT),
     virtualMixThreshold(1000),
-    virtualOffsetStrenght(0.001)
+    virtualOffsetStrenght(0.001),
+    lockFreeUpdates(false),
+    pipelineInference(false),
+    inferenceServers(0),
+    inferenceBatchSize(64),
+    inferenceLatencyUS(1000),
+    hashSizeMB(DEFAULT_HASH_MB),
+    nnCacheSizeMB(0),
+    treeMemoryMB(0),
+    gcThreads(2),
+    gcThrottleUS(0),
+    budgetDescent(false),
+    reuseCollisions(true),
+    rootPartitions(0),
+    randomSeed(0),
+    batchedBackup(false)
 {
 
 }
\ No newline at end of file
@@ -87,6 +87,36 @@ struct SearchSettings
     uint_fast32_t virtualMixThreshold;
     // Defines the strength of the virtual offset
     double virtualOffsetStrenght;
+    // If true, virtual losses and value backups update the child statistics atomically instead of locking the node
+    bool lockFreeUpdates;
+    // If true, each search thread fills the next mini-batch while the previous one is evaluated by the neural network
+    bool pipelineInference;
+    // Number of shared inference servers per device (0: every search thread uses its own network handle)
+    size_t inferenceServers;
+    // Batch size of the network handles which are used by the inference servers
+    unsigned int inferenceBatchSize;
+    // Maximum time in micro seconds which an inference server waits for its batch to fill up
+    size_t inferenceLatencyUS;
+    // Memory size of the transposition table in mega bytes
+    size_t hashSizeMB;
+    // Memory size of the cache for neural network evaluations in mega bytes (0: disabled)
+    size_t nnCacheSizeMB;
+    // Memory budget of the search tree in mega bytes, low-visit subtrees are pruned when it's exceeded (0: unlimited)
+    size_t treeMemoryMB;
+    // Number of threads which free the nodes of the previous search tree
+    size_t gcThreads;
+    // Time in micro seconds which the garbage collector sleeps after freeing a batch of nodes (0: no throttling)
+    size_t gcThrottleUS;
+    // If true, the mini-batch is collected by distributing a budget of visits from the root node instead of one descent per visit
+    bool budgetDescent;
+    // If true, collisions on a leaf which has been evaluated by the neural network by the time of their backup are backed up as additional visits
+    bool reuseCollisions;
+    // Number of thread groups which search disjoint sets of root moves, the root statistics are merged periodically (0, 1: disabled)
+    size_t rootPartitions;
+    // Master seed of the random generators of the search, a fixed seed makes single-threaded searches reproducible (0: random seeds)
+    uint64_t randomSeed;
+    // If true, the trajectories of a mini-batch are merged into a prefix tree for the backup, so that every node is locked once per mini-batch
+    bool batchedBackup;
     SearchSettings();
 
 };
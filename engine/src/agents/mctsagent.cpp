@@ -29,9 +29,11 @@
 #include "../evalinfo.h"
 #include "../constants.h"
 #include "../util/blazeutil.h"
+#include "../util/poolallocator.h"
 #include "../manager/treemanager.h"
 #include "../manager/threadmanager.h"
 #include "../node.h"
+#include "../treecheckpoint.h"
 #include "../util/communication.h"
 
 
@@ -43,20 +45,40 @@ MCTSAgent::MCTSAgent(NeuralNetAPI *netSingle, vector<unique_ptr<NeuralNetAPI>>&
     rootState(nullptr),
     ownNextRoot(nullptr),
     opponentsNextRoot(nullptr),
+    transpositionTable(searchSettings->hashSizeMB),
+    nnCache(searchSettings->nnCacheSizeMB),
+    treePruner(&transpositionTable),
+    rootPartitioner(searchSettings),
     lastValueEval(-1.0f),
     reusedFullTree(false),
     overallNPS(0.0f),
     nbNPSentries(0),
+    gcThread(&transpositionTable, searchSettings, &threadPool),
     threadManager(nullptr),
-    reachedTablebases(false)
+    reachedTablebases(false),
+    isPondering(false),
+    ponderMiss(false)
 {
-    mapWithMutex.hashTable.reserve(1e6);
-
-    for (auto i = 0; i < searchSettings->threads; ++i) {
-        searchThreads.emplace_back(new SearchThread(netBatches[i].get(), searchSettings, &mapWithMutex));
+    if (searchSettings->inferenceServers != 0) {
+        // netBatches holds one large network handle per inference server
+        for (auto& netBatch : netBatches) {
+            inferenceServers.emplace_back(make_unique<InferenceServer>(netBatch.get(), searchSettings->inferenceLatencyUS));
+        }
+    }
+    for (size_t i = 0; i < searchSettings->threads; ++i) {
+        searchThreads.emplace_back(create_search_thread(i, netBatches, &transpositionTable, &treePruner));
     }
     timeManager = make_unique<TimeManager>(searchSettings->randomMoveFactor);
-    generator = default_random_engine(r());
+}
+
+SearchThread* MCTSAgent::create_search_thread(size_t threadIdx, vector<unique_ptr<NeuralNetAPI>>& netBatches,
+                                              TranspositionTable* transpositionTable, TreePruner* treePruner)
+{
+    if (!inferenceServers.empty()) {
+        const size_t serverIdx = threadIdx % inferenceServers.size();
+        return new SearchThread(netBatches[serverIdx].get(), searchSettings, transpositionTable, &nnCache, treePruner, &threadPool, inferenceServers[serverIdx].get());
+    }
+    return new SearchThread(netBatches[threadIdx].get(), searchSettings, transpositionTable, &nnCache, treePruner, &threadPool);
 }
 
 MCTSAgent::~MCTSAgent()
@@ -64,16 +86,26 @@ MCTSAgent::~MCTSAgent()
     for (auto searchThread : searchThreads) {
         delete searchThread;
     }
+    replace_node(gcThread.oldRootNode, nullptr);
+    replace_node(ownNextRoot, nullptr);
+    replace_node(opponentsNextRoot, nullptr);
+    replace_node(rootNode, nullptr);
+}
+
+void MCTSAgent::replace_node(Node*& target, Node* node)
+{
+    release_node(target, &transpositionTable);
+    target = node;
 }
 
 Node* MCTSAgent::get_opponents_next_root() const
 {
-    return opponentsNextRoot.get();
+    return opponentsNextRoot;
 }
 
 Node* MCTSAgent::get_root_node() const
 {
-    return rootNode.get();
+    return rootNode;
 }
 
 string MCTSAgent::get_device_name() const
@@ -114,7 +146,8 @@ bool MCTSAgent::is_running() const
 size_t MCTSAgent::init_root_node(StateObj *state)
 {
     size_t nodesPreSearch;
-    gcThread.oldRootNode = rootNode;
+    // the reference of the former root node is handed over to the garbage collector
+    replace_node(gcThread.oldRootNode, rootNode);
     rootNode = get_root_node_from_tree(state);
 
     if (rootNode != nullptr) {
@@ -134,7 +167,7 @@ size_t MCTSAgent::init_root_node(StateObj *state)
     return nodesPreSearch;
 }
 
-shared_ptr<Node> MCTSAgent::get_root_node_from_tree(StateObj *state)
+Node* MCTSAgent::get_root_node_from_tree(StateObj *state)
 {
     reusedFullTree = false;
 
@@ -146,16 +179,19 @@ shared_ptr<Node> MCTSAgent::get_root_node_from_tree(StateObj *state)
         return nullptr;
     }
 
-    if (same_hash_key(rootNode.get(), state)) {
+    if (same_hash_key(rootNode, state)) {
         info_string("reuse the full tree");
         reusedFullTree = true;
+        rootNode->acquire_reference();
         return rootNode;
     }
 
-    if (same_hash_key(ownNextRoot.get(), state) && ownNextRoot->is_playout_node() && ownNextRoot->get_number_of_nodes() > 0) {
+    if (same_hash_key(ownNextRoot, state) && ownNextRoot->is_playout_node() && ownNextRoot->get_number_of_nodes() > 0) {
+        ownNextRoot->acquire_reference();
         return ownNextRoot;
     }
-    if (same_hash_key(opponentsNextRoot.get(), state) && opponentsNextRoot->is_playout_node() && opponentsNextRoot->get_number_of_nodes() > 0) {
+    if (same_hash_key(opponentsNextRoot, state) && opponentsNextRoot->is_playout_node() && opponentsNextRoot->get_number_of_nodes() > 0) {
+        opponentsNextRoot->acquire_reference();
         return opponentsNextRoot;
     }
     // the node wasn't found, clear the old tree
@@ -167,9 +203,9 @@ shared_ptr<Node> MCTSAgent::get_root_node_from_tree(StateObj *state)
 void MCTSAgent::set_root_node_predictions()
 {
     state->get_state_planes(true, inputPlanes, net->get_version());
-    net->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+    net->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs, 1);
     size_t tbHits = 0;
-    fill_nn_results(0, net->is_policy_map(), valueOutputs, probOutputs, auxiliaryOutputs, rootNode.get(), tbHits,
+    fill_nn_results(0, net->is_policy_map(), valueOutputs, probOutputs, auxiliaryOutputs, rootNode, tbHits,
                     rootState->mirror_policy(state->side_to_move()), searchSettings, rootNode->is_tablebase());
 }
 
@@ -177,10 +213,11 @@ void MCTSAgent::create_new_root_node(StateObj* state)
 {
     info_string("create new tree");
 #ifdef MCTS_STORE_STATES
-    rootNode = make_shared<Node>(state->clone(), searchSettings);
+    rootNode = new Node(state->clone());
 #else
-    rootNode = make_shared<Node>(state, searchSettings);
+    rootNode = new Node(state);
 #endif
+    rootNode->expand(state, searchSettings);
 #ifdef SEARCH_UCT
     unique_ptr<StateObj> newState = unique_ptr<StateObj>(state->clone());
     rootNode->set_value(newState->random_rollout());
@@ -194,8 +231,7 @@ void MCTSAgent::create_new_root_node(StateObj* state)
 void MCTSAgent::delete_old_tree()
 {
     // clear all remaining node of the former root node
-    mapWithMutex.hashTable.clear();
-    assert(mapWithMutex.hashTable.size() == 0);
+    transpositionTable.clear();
 }
 
 void MCTSAgent::sleep_and_log_for(size_t timeMS, size_t updateIntervalMS)
@@ -223,31 +259,56 @@ void MCTSAgent::update_nps_measurement(float curNPS)
     }
 }
 
+void MCTSAgent::save_search_tree(const string& filename)
+{
+    if (rootNode == nullptr) {
+        info_string("there is no search tree to save");
+        return;
+    }
+    if (!save_tree_checkpoint(rootNode, filename)) {
+        info_string("couldn't write the tree checkpoint:", filename);
+        return;
+    }
+    info_string("saved", rootNode->get_visits(), "visits");
+}
+
+void MCTSAgent::load_search_tree(const StateObj* pos, const string& filename)
+{
+    clear_game_history();
+    Node* node = load_tree_checkpoint(pos, filename, &transpositionTable, searchSettings);
+    if (node == nullptr) {
+        return;
+    }
+    replace_node(rootNode, node);
+    info_string("loaded", rootNode->get_visits(), "visits");
+}
+
 void MCTSAgent::apply_move_to_tree(Action move, bool ownMove)
 {
-    if (!reusedFullTree && rootNode != nullptr && rootNode->is_playout_node()) {
+    // the best move of a missed ponder search is never played, the next position will be unrelated to it
+    if (!reusedFullTree && !ponderMiss && rootNode != nullptr && rootNode->is_playout_node()) {
         if (ownMove) {
             info_string("apply move to tree");
-            opponentsNextRoot = pick_next_node(move, rootNode.get());
+            replace_node(opponentsNextRoot, pick_next_node(move, rootNode));
             return;
         }
         else if (opponentsNextRoot != nullptr && opponentsNextRoot->is_playout_node()){
             info_string("apply move to tree");
-            ownNextRoot = pick_next_node(move, opponentsNextRoot.get());
+            replace_node(ownNextRoot, pick_next_node(move, opponentsNextRoot));
             return;
         }
     }
     // the full tree will be deleted next search
-    opponentsNextRoot = nullptr;
-    ownNextRoot = nullptr;
+    replace_node(opponentsNextRoot, nullptr);
+    replace_node(ownNextRoot, nullptr);
 }
 
 void MCTSAgent::clear_game_history()
 {
     delete_old_tree();
-    ownNextRoot = nullptr;
-    opponentsNextRoot = nullptr;
-    rootNode = nullptr;
+    replace_node(ownNextRoot, nullptr);
+    replace_node(opponentsNextRoot, nullptr);
+    replace_node(rootNode, nullptr);
     lastValueEval = -1.0f;
     nbNPSentries = 0;
     overallNPS = 0;
@@ -287,12 +348,17 @@ void MCTSAgent::handle_single_move()
 
 void MCTSAgent::evaluate_board_state()
 {
+    reset_ponder_state();
+    if (searchSettings->randomSeed != 0) {
+        // makes the dirichlet noise and the move sampling after the search reproducible
+        get_generator().seed(derive_seed(searchSettings->randomSeed, 0));
+    }
     rootState = unique_ptr<StateObj>(state->clone());
+    transpositionTable.resize(searchSettings->hashSizeMB);
+    transpositionTable.new_search();
+    nnCache.resize(searchSettings->nnCacheSizeMB);
     evalInfo->nodesPreSearch = init_root_node(state);
-    thread tGCThread = thread(run_gc_thread, &gcThread);
-#ifdef USE_RL
-    tGCThread.join();
-#endif
+    future<void> gcTask = threadPool.submit(bind(run_gc_thread, &gcThread));
     evalInfo->isChess960 = state->is_chess960();
     if (rootNode->get_number_child_nodes() == 1) {
         info_string("Only single move available -> early stopping");
@@ -314,51 +380,97 @@ void MCTSAgent::evaluate_board_state()
         if (!rootNode->is_root_node()) {
             rootNode->make_to_root();
         }
-        info_string("hash size: ", mapWithMutex.hashTable.size());
-        if (mapWithMutex.hashTable.size() > MAX_HASH_SIZE) {
-            info_string("clear hash");
-            mapWithMutex.hashTable.clear();
-        }
+        info_string("hash full: ", transpositionTable.hashfull());
         info_string("run mcts search");
         run_mcts_search();
         update_stats();
+        // a high collision rate indicates that the batch size is too large for the number of threads
+        info_string("collision rate:", get_collision_rate(searchThreads));
+        info_string("reused collisions:", get_reused_collisions(searchThreads));
+        info_string("avg expansion time (ns):", get_avg_expansion_time(searchThreads));
     }
-    update_eval_info(*evalInfo, rootNode.get(), tbHits, maxDepth, searchSettings);
+    wait_for_ponder_end();
+    update_eval_info(*evalInfo, rootNode, tbHits, maxDepth, searchSettings);
     lastValueEval = evalInfo->bestMoveQ[0];
     lastSideToMove = state->side_to_move();
     update_nps_measurement(evalInfo->calculate_nps());
-#ifndef USE_RL
-    tGCThread.join();
-#endif
+    gcTask.get();
 }
 
 void MCTSAgent::run_mcts_search()
 {
-    thread** threads = new thread*[searchSettings->threads];
+    vector<future<void>> searchTasks;
+    treePruner.set_active_threads(searchSettings->threads);
+    treePruner.init_tree_memory(rootNode, searchSettings);
+    // every partition needs at least one search thread and the budget descent distributes its visits over all root child nodes
+    if (searchSettings->rootPartitions > 1 && searchSettings->threads > 1 && !searchSettings->budgetDescent) {
+        rootPartitioner.start(rootNode, min(searchSettings->rootPartitions, searchSettings->threads));
+    }
     for (size_t i = 0; i < searchSettings->threads; ++i) {
-        searchThreads[i]->set_root_node(rootNode.get());
+        // stream 0 belongs to the dirichlet noise of the agent
+        searchThreads[i]->seed_random_generator(derive_seed(searchSettings->randomSeed, i + 1));
+        searchThreads[i]->set_root_partition(&rootPartitioner, rootPartitioner.is_active() ? i % rootPartitioner.get_number_partitions() : 0);
+        searchThreads[i]->set_root_node(rootNode);
         searchThreads[i]->set_root_state(rootState.get());
         searchThreads[i]->set_search_limits(searchLimits);
         searchThreads[i]->set_reached_tablebases(reachedTablebases);
-        threads[i] = new thread(run_search_thread, searchThreads[i]);
+        searchTasks.emplace_back(threadPool.submit(bind(run_search_thread, searchThreads[i])));
     }
     int curMovetime = timeManager->get_time_for_move(searchLimits, rootState->side_to_move(), rootNode->plies_from_null()/2);
-    ThreadManagerData tData(rootNode.get(), searchThreads, evalInfo, lastValueEval);
+    ThreadManagerData tData(rootNode, searchThreads, evalInfo, lastValueEval);
     ThreadManagerInfo tInfo(searchSettings, searchLimits, overallNPS, rootState->side_to_move());
     ThreadManagerParams tParams(curMovetime, 250, is_game_sceneario(searchLimits), can_prolong_search(rootNode->plies_from_null()/2, timeManager->get_thresh_move()));
     threadManager = make_unique<ThreadManager>(&tData, &tInfo, &tParams);
-    unique_ptr<thread> tManager = make_unique<thread>(run_thread_manager, threadManager.get());
+    future<void> managerTask = threadPool.submit(bind(run_thread_manager, threadManager.get()));
     unlock_and_notify();
-    for (size_t i = 0; i < searchSettings->threads; ++i) {
-        threads[i]->join();
+    for (future<void>& searchTask : searchTasks) {
+        searchTask.wait();
     }
+    rootPartitioner.finish();
     threadManager->kill();
-    tManager->join();
-    delete[] threads;
+    managerTask.wait();
+    // rethrow the errors only after all threads have stopped
+    wait_for_tasks(searchTasks);
+    managerTask.get();
+}
+
+void MCTSAgent::reset_ponder_state()
+{
+    unique_lock<mutex> lock(ponderMutex);
+    isPondering = searchLimits->ponder;
+    ponderMiss = false;
+}
+
+void MCTSAgent::wait_for_ponder_end()
+{
+    unique_lock<mutex> lock(ponderMutex);
+    ponderCondition.wait(lock, [&]{return !isPondering;});
+}
+
+void MCTSAgent::ponderhit()
+{
+    unique_lock<mutex> lock(ponderMutex);
+    if (!isPondering) {
+        return;
+    }
+    isPondering = false;
+    if (threadManager != nullptr) {
+        threadManager->ponderhit();
+    }
+    ponderCondition.notify_all();
 }
 
 void MCTSAgent::stop()
 {
+    {
+        // a stop during pondering means that the opponent played a different move
+        unique_lock<mutex> lock(ponderMutex);
+        if (isPondering) {
+            isPondering = false;
+            ponderMiss = true;
+            ponderCondition.notify_all();
+        }
+    }
     if (!isRunning) {
         return;
     }
@@ -376,7 +488,7 @@ void MCTSAgent::print_root_node()
     }
     const vector<size_t> customOrdering = sort_permutation(evalInfo->policyProbSmall, std::greater<float>());
     rootNode->print_node_statistics(rootState.get(), customOrdering, searchSettings);
-    Node* node = rootNode.get();
+    Node* node = rootNode;
    /* for (int i = 0; i< 5; i++) {
         int idx = argmax(rootNode->get_q_values());
         node = node->get_child_node(idx);
@@ -393,7 +505,7 @@ void print_child_nodes_to_file(const Node* parentNode, StateObj* state, size_t p
     }
     size_t childIdx = 0;
     for (auto it = parentNode->get_node_it_begin(); it != parentNode->get_node_it_end(); ++it) {
-        const Node* node = it->get();
+        const Node* node = *it;
         if (node != nullptr) {
             Action action = parentNode->get_action(childIdx);
             outFile << "N" << ++nodeId << " [label = \""
@@ -412,7 +524,7 @@ void print_child_nodes_to_file(const Node* parentNode, StateObj* state, size_t p
     }
     outFile << "}" << endl;
     for (auto it = parentNode->get_node_it_begin(); it != parentNode->get_node_it_end(); ++it) {
-        const Node* node = it->get();
+        const Node* node = *it;
         if (node != nullptr && node->is_playout_node()) {
             unique_ptr<StateObj> state2 = unique_ptr<StateObj>(state->clone());
             Action action = parentNode->get_action(childIdx);
@@ -445,7 +557,7 @@ void MCTSAgent::export_search_tree(size_t maxDepth, const string& filename)
             << "]" << endl << endl;
 
     outFile << "N0 [label = \"root\", xlabel=\"fen: " << rootState->fen() << "\"]" << endl << endl;
-    print_child_nodes_to_file(rootNode.get(), rootState.get(), 0, nodeId, outFile, 1, maxDepth);
+    print_child_nodes_to_file(rootNode, rootState.get(), 0, nodeId, outFile, 1, maxDepth);
     outFile << "}" << endl;
     outFile.close();
 }
@@ -45,6 +45,7 @@
 #include "../manager/timemanager.h"
 #include "../manager/threadmanager.h"
 #include "util/gcthread.h"
+#include "../util/threadpool.h"
 
 using namespace crazyara;
 
@@ -53,17 +54,26 @@ class MCTSAgent : public Agent
 public:
     SearchSettings* searchSettings;  // TODO: add "const" to searchSetting
     vector<SearchThread*> searchThreads;
+    // shared inference services, only used if searchSettings->inferenceServers > 0
+    vector<unique_ptr<InferenceServer>> inferenceServers;
     unique_ptr<TimeManager> timeManager;
 
-    shared_ptr<Node> rootNode;
+    // the agent holds a reference of each of the root node pointers
+    Node* rootNode;
     unique_ptr<StateObj> rootState;
 
     // stores the pointer to the root node which will become the new root
-    shared_ptr<Node> ownNextRoot;
+    Node* ownNextRoot;
     // stores the pointer to the root node which will become the new root for opponents turn
-    shared_ptr<Node> opponentsNextRoot;
-
-    MapWithMutex mapWithMutex;
+    Node* opponentsNextRoot;
+
+    TranspositionTable transpositionTable;
+    // cache of neural network evaluations which is kept across moves and games
+    NNCache nnCache;
+    // keeps the search tree within the memory budget
+    TreePruner treePruner;
+    // splits the root child nodes between groups of search threads if enabled
+    RootPartitioner rootPartitioner;
     float lastValueEval;
     SideToMove lastSideToMove;
 
@@ -77,10 +87,42 @@ public:
     size_t tbHits;
     size_t nbNPSentries;
 
+    // long-lived workers for the search threads, the thread manager and the garbage collector
+    ThreadPool threadPool;
     GCThread gcThread;
 
     unique_ptr<ThreadManager> threadManager;
     bool reachedTablebases;
+
+    // true while a "go ponder" search waits for the ponderhit or stop command
+    bool isPondering;
+    // true if the last search was a ponder search which has been stopped without a ponderhit
+    bool ponderMiss;
+    mutex ponderMutex;
+    condition_variable ponderCondition;
+
+    /**
+     * @brief reset_ponder_state Marks the new search as ponder search if the search limits request it
+     */
+    void reset_ponder_state();
+
+    /**
+     * @brief wait_for_ponder_end Blocks until the ponderhit or stop command has been received for a ponder search.
+     * The best move must not be reported before.
+     */
+    void wait_for_ponder_end();
+
+    /**
+     * @brief create_search_thread Creates a search thread which uses the given transposition table and tree pruner.
+     * The thread shares the inference servers if there are any, otherwise it uses its own network handle.
+     * @param threadIdx Index of the search thread
+     * @param netBatches Network handles of the search threads or of the inference servers
+     * @param transpositionTable Transposition table of the search tree
+     * @param treePruner Tree pruner of the search tree
+     * @return New search thread
+     */
+    SearchThread* create_search_thread(size_t threadIdx, vector<unique_ptr<NeuralNetAPI>>& netBatches,
+                                       TranspositionTable* transpositionTable, TreePruner* treePruner);
 public:
     MCTSAgent(NeuralNetAPI* netSingle,
               vector<unique_ptr<NeuralNetAPI>>& netBatches,
@@ -100,6 +142,12 @@ public:
 
     void stop() override;
 
+    /**
+     * @brief ponderhit Converts the running ponder search into a regular search, the search limits take effect from now on
+     * and the tree of the pondering phase is kept
+     */
+    void ponderhit();
+
     /**
      * @brief print_root_node Prints out the root node statistics (visits, q-value, u-value)
      *  by calling the stdout operator for the Node class
@@ -114,6 +162,20 @@ public:
      */
     void export_search_tree(size_t maxDepth, const string& filename);
 
+    /**
+     * @brief save_search_tree Writes the current search tree into a binary checkpoint file (see treecheckpoint.h)
+     * @param filename File name of the checkpoint
+     */
+    void save_search_tree(const string& filename);
+
+    /**
+     * @brief load_search_tree Replaces the current search tree by the tree of a binary checkpoint file.
+     * The loaded tree is reused by the next search on the same position if Reuse_Tree is enabled.
+     * @param pos Current position which must match the root of the checkpoint
+     * @param filename File name of the checkpoint
+     */
+    void load_search_tree(const StateObj* pos, const string& filename);
+
     void apply_move_to_tree(Action move, bool ownMove) override;
 
     /**
@@ -181,15 +243,22 @@ public:
      * it was either the old root node or an element of the potential root node list.
      * Otherwise a nullptr will be returned. The old tree is deleted except the game nodes.
      * @param pos Requested board position
-     * @return Pointer to root node or nullptr
+     * @return Pointer to root node with a new reference or nullptr
+     */
+    Node* get_root_node_from_tree(StateObj* state);
+
+    /**
+     * @brief replace_node Releases the node which is stored in target and replaces it by the given node
+     * @param target Root node pointer of the agent
+     * @param node Node with a reference for the agent or nullptr
      */
-    shared_ptr<Node> get_root_node_from_tree(StateObj* state);
+    void replace_node(Node*& target, Node* node);
 
     /**
      * @brief create_new_root_node Creates a new root node for the given board position and requests the neural network for evaluation
      * @param pos Board position
      */
-    inline void create_new_root_node(StateObj* state);
+    void create_new_root_node(StateObj* state);
 
     /**
      * @brief delete_old_tree Clear the old tree except the gameNodes (rootNode, opponentNextRoot)
@@ -27,6 +27,7 @@
 #include <string>
 #include <thread>
 #include <fstream>
+#include <unordered_map>
 #include "mctsagentbatch.h"
 #include "../evalinfo.h"
 #include "../constants.h"
@@ -44,13 +45,34 @@ MCTSAgentBatch::MCTSAgentBatch(NeuralNetAPI *netSingle, vector<unique_ptr<Neural
     {
         numberOfAgents = noa;
         splitNodes = sN;
+        // the agent trees use their own tables which share the Hash memory, the table of the base agent isn't used
+        transpositionTable.resize(0);
+        // every tree needs at least one search thread
+        const size_t numberTrees = max(size_t(1), min(size_t(numberOfAgents), searchThreads.size()));
+        for (size_t treeIdx = 0; treeIdx < numberTrees; ++treeIdx) {
+            unique_ptr<AgentTree> agentTree = make_unique<AgentTree>();
+            agentTree->transpositionTable = make_unique<TranspositionTable>(max(size_t(1), searchSettings->hashSizeMB / numberTrees));
+            agentTree->treePruner = make_unique<TreePruner>(agentTree->transpositionTable.get());
+            agentTree->rootNode = nullptr;
+            agentTrees.emplace_back(move(agentTree));
+        }
+        // the search threads of the base agent are replaced by threads which are bound to the agent trees
+        for (size_t threadIdx = 0; threadIdx < searchThreads.size(); ++threadIdx) {
+            AgentTree& agentTree = *agentTrees[threadIdx % numberTrees];
+            delete searchThreads[threadIdx];
+            searchThreads[threadIdx] = create_search_thread(threadIdx, netBatches, agentTree.transpositionTable.get(), agentTree.treePruner.get());
+            agentTree.searchThreads.emplace_back(searchThreads[threadIdx]);
+        }
     }
 
 MCTSAgentBatch::~MCTSAgentBatch()
 {
+    release_agent_trees(agentTrees.size());
+    // the search threads are registered at the transposition tables of the agent trees
     for (auto searchThread : searchThreads) {
         delete searchThread;
     }
+    searchThreads.clear();
 }
 
 string MCTSAgentBatch::get_name() const
@@ -62,144 +84,145 @@ string MCTSAgentBatch::get_name() const
     return ret;
 }
 
-void MCTSAgentBatch::evaluate_board_state()
+void MCTSAgentBatch::create_agent_root(AgentTree& agentTree)
 {
-    vector<EvalInfo> evals;
-    evalInfo->isChess960 = state->is_chess960();
+    agentTree.transpositionTable->resize(max(size_t(1), searchSettings->hashSizeMB / agentTrees.size()));
+    agentTree.transpositionTable->new_search();
+    // create_new_root_node() initializes the root node of the base agent
+    create_new_root_node(state);
+    agentTree.rootNode = rootNode;
+    rootNode = nullptr;
+    if (searchSettings->dirichletEpsilon > 0.009f) {
+        // every agent gets its own noise which diversifies the trees
+        agentTree.rootNode->apply_dirichlet_noise_to_prior_policy(searchSettings);
+        agentTree.rootNode->fully_expand_node();
+    }
+    agentTree.rootNode->make_to_root();
+}
 
-    for (size_t i = 0; i < numberOfAgents; i++)
-    {
-        EvalInfo eval = *evalInfo;
-        auto rt = state->clone();
-        rootState = unique_ptr<StateObj>(rt);
-        eval.nodesPreSearch = init_root_node(rt);
-        
-        info_string(rootState->fen());
-        
-        thread tGCThread = thread(run_gc_thread, &gcThread);
-        
-        if (rootNode->get_number_child_nodes() == 1) {
-            info_string("Only single move available -> early stopping");
-            unlock_and_notify();
-        }
-        else if (rootNode->get_number_child_nodes() == 0) {
-            info_string("The given position has no legal moves");
-            unlock_and_notify();
-        }
-        else {
-            if (searchSettings->dirichletEpsilon > 0.009f) {
-                info_string("apply dirichlet noise");
-                // TODO: Check for dirichlet compability
-                rootNode->apply_dirichlet_noise_to_prior_policy(searchSettings);
-                rootNode->fully_expand_node();
-            }
-
-            if (!rootNode->is_root_node()) {
-                rootNode->make_to_root();
-            }
-            int tmp = searchLimits->nodes;
-            if(splitNodes){  
-                searchLimits->nodes = tmp/numberOfAgents;
-            }
-            info_string("run mcts search");
-            run_mcts_search();
-            update_stats();
-            searchLimits->nodes = tmp;
-        }
-        
-        const size_t targetLength = rootNode->get_number_child_nodes();
-        eval.childNumberVisits = rootNode->get_child_number_visits();
-        eval.qValues = rootNode->get_q_values();
-        if (targetLength == 1) {
-            eval.policyProbSmall = DynamicVector<float>(1);
-            eval.policyProbSmall[0] = 1.0f;
-        }
-        else {
-            ChildIdx bestMoveIdx;
-            rootNode->get_mcts_policy(eval.policyProbSmall, bestMoveIdx, searchSettings);
+void MCTSAgentBatch::run_concurrent_searches(size_t numberTrees, int moveTimeMS, SearchLimits* agentLimits)
+{
+    vector<SearchThread*> roundThreads;
+    for (size_t treeIdx = 0; treeIdx < numberTrees; ++treeIdx) {
+        AgentTree& agentTree = *agentTrees[treeIdx];
+        agentTree.treePruner->set_active_threads(agentTree.searchThreads.size());
+        agentTree.treePruner->init_tree_memory(agentTree.rootNode, searchSettings);
+        for (SearchThread* searchThread : agentTree.searchThreads) {
+            searchThread->seed_random_generator(derive_seed(searchSettings->randomSeed, roundThreads.size() + 1));
+            searchThread->set_root_node(agentTree.rootNode);
+            searchThread->set_root_state(rootState.get());
+            searchThread->set_search_limits(agentLimits);
+            searchThread->set_reached_tablebases(reachedTablebases);
+            roundThreads.emplace_back(searchThread);
         }
-       
-        eval.legalMoves = rootNode->get_legal_actions();
-
-        vector<size_t> indices;
-        uint16_t maxIdx = min(searchSettings->multiPV, rootNode->get_no_visit_idx());
+    }
+    vector<future<void>> searchTasks;
+    for (SearchThread* searchThread : roundThreads) {
+        searchTasks.emplace_back(threadPool.submit(bind(run_search_thread, searchThread)));
+    }
+    ThreadManagerData tData(agentTrees[0]->rootNode, roundThreads, evalInfo, lastValueEval);
+    ThreadManagerInfo tInfo(searchSettings, searchLimits, overallNPS, rootState->side_to_move());
+    // early stopping and search extensions only look at a single tree, so the agents always use the full move time
+    ThreadManagerParams tParams(moveTimeMS, 250, false, false);
+    threadManager = make_unique<ThreadManager>(&tData, &tInfo, &tParams);
+    future<void> managerTask = threadPool.submit(bind(run_thread_manager, threadManager.get()));
+    unlock_and_notify();
+    for (future<void>& searchTask : searchTasks) {
+        searchTask.wait();
+    }
+    threadManager->kill();
+    managerTask.wait();
+    // rethrow the errors only after all threads have stopped
+    wait_for_tasks(searchTasks);
+    managerTask.get();
+}
 
-        if (maxIdx > 1) {
-            sort_eval_lists(eval, indices);
-        }
-        
-        auto p = sort_permutation(eval.legalMoves, std::greater<float>());
-        for (size_t idx = 0; idx < eval.legalMoves.size(); ++idx) {
-        indices.emplace_back(idx);
+void MCTSAgentBatch::release_agent_trees(size_t numberTrees)
+{
+    // the trees are independent, so they can be freed in parallel
+    vector<future<void>> releaseTasks;
+    for (size_t treeIdx = 0; treeIdx < numberTrees; ++treeIdx) {
+        AgentTree* agentTree = agentTrees[treeIdx].get();
+        if (agentTree->rootNode == nullptr) {
+            continue;
         }
-        apply_permutation_in_place(eval.legalMoves, p);
-        apply_permutation_in_place(indices, p);
-
-        eval.init_vectors_for_multi_pv(searchSettings->multiPV);
+        agentTree->transpositionTable->clear();
+        releaseTasks.emplace_back(threadPool.submit([agentTree]() {
+            release_node(agentTree->rootNode, nullptr);
+            agentTree->rootNode = nullptr;
+        }));
+    }
+    wait_for_tasks(releaseTasks);
+}
 
-        if (targetLength == 1 && rootNode->is_blank_root_node()) {
-            // single move with no tree reuse
-            eval.pv[0] = {rootNode->get_action(0)};
-            // there are no q-values available, therefore use the state value evaluation as bestMoveQ
-            eval.bestMoveQ[0] = rootNode->get_value();
-            eval.centipawns[0] = value_to_centipawn(eval.bestMoveQ[0]);
-        }
-        else {
-            for (size_t idx = 0; idx < maxIdx; ++idx) {
-                set_eval_for_single_pv(eval, rootNode.get(), idx, indices, searchSettings);
-            }
-        }
-        eval.selDepth = maxDepth;
-        eval.nodes = rootNode->get_node_count();
-        eval.tbHits = tbHits;
+void MCTSAgentBatch::evaluate_board_state()
+{
+    reset_ponder_state();
+    vector<EvalInfo> evals;
+    evalInfo->isChess960 = state->is_chess960();
+    rootState = unique_ptr<StateObj>(state->clone());
+    info_string(rootState->fen());
 
-        evals.push_back(eval);
-        tGCThread.join();
+    SearchLimits agentLimits = *searchLimits;
+    if (splitNodes) {
+        agentLimits.nodes = searchLimits->nodes / numberOfAgents;
     }
+    const size_t numberRounds = (numberOfAgents + agentTrees.size() - 1) / agentTrees.size();
+    const int moveTimeMS = timeManager->get_time_for_move(searchLimits, rootState->side_to_move(), state->steps_from_null()/2) / numberRounds;
 
-    evalInfo->nodesPreSearch = init_root_node(state);
-    evalInfo->legalMoves = rootNode->get_legal_actions();
-    
-    auto combinedPolicy = evals[0].policyProbSmall;
-    auto combinedChildVisits = evals[0].childNumberVisits;
-    auto combinedQValues = evals[0].qValues;
-
-    for (size_t i = 1; i < numberOfAgents; i++)
-    {
-        for(auto j = 0; j < combinedPolicy.size(); ++j){
-            combinedPolicy[j] += evals[i].policyProbSmall[j];
+    for (size_t firstAgent = 0; firstAgent < size_t(numberOfAgents); firstAgent += agentTrees.size()) {
+        const size_t numberTrees = min(agentTrees.size(), numberOfAgents - firstAgent);
+        for (size_t treeIdx = 0; treeIdx < numberTrees; ++treeIdx) {
+            create_agent_root(*agentTrees[treeIdx]);
+        }
+        const Node* firstRoot = agentTrees[0]->rootNode;
+        if (firstRoot->get_number_child_nodes() <= 1) {
+            info_string(firstRoot->get_number_child_nodes() == 1 ? "Only single move available -> early stopping" : "The given position has no legal moves");
+            unlock_and_notify();
+            evals.emplace_back(*evalInfo);
+            update_eval_info(evals.back(), firstRoot, 0, 0, searchSettings);
+            release_agent_trees(numberTrees);
+            break;
         }
-        for(auto j = 0; j < combinedChildVisits.size(); ++j){
-            combinedChildVisits[j] += evals[i].childNumberVisits[j];
+        info_string("run mcts search");
+        run_concurrent_searches(numberTrees, moveTimeMS, &agentLimits);
+        for (size_t treeIdx = 0; treeIdx < numberTrees; ++treeIdx) {
+            const AgentTree& agentTree = *agentTrees[treeIdx];
+            evals.emplace_back(*evalInfo);
+            update_eval_info(evals.back(), agentTree.rootNode, get_tb_hits(agentTree.searchThreads), get_max_depth(agentTree.searchThreads), searchSettings);
         }
-        for(auto j = 0; j < combinedQValues.size(); ++j){
-            combinedQValues[j] += evals[i].qValues[j];
+        release_agent_trees(numberTrees);
+        if (!isRunning) {
+            // a stop command ends the remaining rounds as well
+            break;
         }
     }
+    wait_for_ponder_end();
 
-    for(auto j = 0; j < combinedPolicy.size(); ++j){
-        combinedPolicy[j] += combinedPolicy[j]/numberOfAgents;
-    }
-    for(auto j = 0; j < combinedChildVisits.size(); ++j){
-        combinedChildVisits[j] += combinedChildVisits[j]/numberOfAgents;
-    }
-    for(auto j = 0; j < combinedQValues.size(); ++j){
-        combinedQValues[j] += combinedQValues[j]/numberOfAgents;
+    // the moves might be in a different order in each tree, so the policies are combined by their action
+    unordered_map<Action, double> combinedPolicy;
+    for (const EvalInfo& eval : evals) {
+        for (size_t idx = 0; idx < eval.legalMoves.size(); ++idx) {
+            combinedPolicy[eval.legalMoves[idx]] += eval.policyProbSmall[idx] / evals.size();
+        }
     }
-
-    vector<float> diffs;
-    for (size_t i = 0; i < numberOfAgents; i++)
-    {   
+    vector<double> diffs;
+    for (const EvalInfo& eval : evals) {
         diffs.push_back(0.0);
-        for(auto j = 0; j< combinedPolicy.size(); ++j){
-            diffs[i] += std::sqrt(std::pow(evals[i].policyProbSmall[j] - combinedPolicy[j],2));
+        for (size_t idx = 0; idx < eval.legalMoves.size(); ++idx) {
+            diffs.back() += std::abs(eval.policyProbSmall[idx] - combinedPolicy[eval.legalMoves[idx]]);
         }
     }
-    std::vector<float>::iterator result = std::min_element(diffs.begin(), diffs.end()); 
-    int stateIdx = std::distance(diffs.begin(), result);
+    const size_t stateIdx = std::distance(diffs.begin(), std::min_element(diffs.begin(), diffs.end()));
 
+    size_t totalNodes = 0;
+    for (const EvalInfo& eval : evals) {
+        totalNodes += eval.nodes;
+    }
     *evalInfo = evals[stateIdx];
+    // the nodes of all agents contribute to the speed measurement
+    evalInfo->nodes = totalNodes;
     update_nps_measurement(evalInfo->calculate_nps());
-    
+
     info_string("Selected State: " + std::to_string(stateIdx));
 }
@@ -22,7 +22,9 @@
  * Created on 05.2021
  * @author: BluemlJ
  *
- * This MCTSAgent starts several MCTSAgents after another and calculates the best move based on all of the MCTSAgents. 
+ * This MCTSAgent runs several independent searches concurrently and calculates the best move based on all of them.
+ * Every agent has its own search tree, transposition table and tree pruner and is expanded by a disjoint subset of the search threads.
+ * If there are fewer search threads than agents, the agents are run in several rounds.
  */
 
 #ifndef MCTSAGENTBATCH_H
@@ -40,10 +42,23 @@
 #include "../manager/timemanager.h"
 #include "../manager/threadmanager.h"
 #include "util/gcthread.h"
+#include "../transpositiontable.h"
+#include "../treepruner.h"
 
 
 using namespace crazyara;
 
+/**
+ * @brief The AgentTree struct holds the search tree of a single agent and the search threads which expand it
+ */
+struct AgentTree
+{
+    unique_ptr<TranspositionTable> transpositionTable;
+    unique_ptr<TreePruner> treePruner;
+    vector<SearchThread*> searchThreads;
+    Node* rootNode;
+};
+
 class MCTSAgentBatch : public MCTSAgent
 {
 public:
@@ -51,6 +66,28 @@ public:
   int numberOfAgents;
   // boolean, deciding if the given nodes are player per tree or are split between the trees
   bool splitNodes;
+  // one tree for each agent which can be searched at the same time
+  vector<unique_ptr<AgentTree>> agentTrees;
+
+private:
+    /**
+     * @brief create_agent_root Creates a new root node for the given agent tree
+     * @param agentTree Agent tree without a root node
+     */
+    void create_agent_root(AgentTree& agentTree);
+
+    /**
+     * @brief run_concurrent_searches Searches the first numberTrees agent trees at the same time until the search limits are reached
+     * @param numberTrees Number of agent trees
+     * @param moveTimeMS Move time for this round, 0 if the search is only limited by nodes or a stop command
+     * @param agentLimits Search limits of each agent
+     */
+    void run_concurrent_searches(size_t numberTrees, int moveTimeMS, SearchLimits* agentLimits);
+
+    /**
+     * @brief release_agent_trees Frees the trees of the first numberTrees agents
+     */
+    void release_agent_trees(size_t numberTrees);
 
 public:
     MCTSAgentBatch(NeuralNetAPI* netSingle,
@@ -60,7 +60,7 @@ void MCTSAgentTrueSight::evaluate_board_state()
 {
     evalInfo->nodesPreSearch = init_root_node(state);
 
-    thread tGCThread = thread(run_gc_thread, &gcThread);
+    future<void> gcTask = threadPool.submit(bind(run_gc_thread, &gcThread));
     evalInfo->isChess960 = state->is_chess960();
     #ifdef MODE_STRATEGO
         rootState = unique_ptr<StateObj>(state->openBoard());
@@ -89,8 +89,8 @@ void MCTSAgentTrueSight::evaluate_board_state()
         run_mcts_search();
         update_stats();
     }
-    update_eval_info(*evalInfo, rootNode.get(), tbHits, maxDepth, searchSettings);
+    update_eval_info(*evalInfo, rootNode, tbHits, maxDepth, searchSettings);
     lastValueEval = evalInfo->bestMoveQ[0];
     update_nps_measurement(evalInfo->calculate_nps());
-    tGCThread.join();
+    gcTask.get();
 }
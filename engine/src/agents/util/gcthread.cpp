@@ -21,10 +21,106 @@
  */
 
 #include "gcthread.h"
+#include <atomic>
+#include <thread>
+#include <chrono>
 
+GCThread::GCThread(TranspositionTable* transpositionTable, const SearchSettings* searchSettings, ThreadPool* threadPool) :
+    oldRootNode(nullptr),
+    transpositionTable(transpositionTable),
+    searchSettings(searchSettings),
+    threadPool(threadPool)
+{
+}
+
+void GCThread::release_node(Node* node, vector<Node*>& childNodes, vector<Node*>& retiredNodes)
+{
+    // the node is removed from the table first, so that no search thread can find it anymore
+    const bool erased = transpositionTable->erase(node->hash_key(), node);
+    if (!node->try_release_last_reference()) {
+        // the node is still part of the current tree, it's inserted again before the reference is dropped
+        if (erased) {
+            transpositionTable->insert(node->hash_key(), node);
+        }
+        if (!node->release_reference()) {
+            return;
+        }
+        // the current tree has released the node in the meantime
+        transpositionTable->erase(node->hash_key(), node);
+    }
+    if (node->is_playout_node()) {
+        node->detach_child_nodes(childNodes);
+    }
+    retiredNodes.emplace_back(node);
+}
+
+void GCThread::free_retired_nodes(vector<Node*>& retiredNodes)
+{
+    if (retiredNodes.empty()) {
+        return;
+    }
+    // a search thread might have found one of the nodes in the table before it was erased
+    transpositionTable->get_epoch_manager().synchronize();
+    for (Node* node : retiredNodes) {
+        delete node;
+    }
+    retiredNodes.clear();
+}
 
+void GCThread::free_subtrees(vector<Node*>& subtrees, atomic<size_t>& nextSubtreeIdx)
+{
+    vector<Node*> pendingNodes;
+    vector<Node*> retiredNodes;
+    size_t releasedNodes = 0;
+    for (size_t subtreeIdx = nextSubtreeIdx++; subtreeIdx < subtrees.size(); subtreeIdx = nextSubtreeIdx++) {
+        pendingNodes.emplace_back(subtrees[subtreeIdx]);
+        while (!pendingNodes.empty()) {
+            Node* node = pendingNodes.back();
+            pendingNodes.pop_back();
+            release_node(node, pendingNodes, retiredNodes);
+            if (retiredNodes.size() == GC_RETIRE_BATCH) {
+                free_retired_nodes(retiredNodes);
+            }
+            if (++releasedNodes % GC_THROTTLE_INTERVAL == 0 && searchSettings->gcThrottleUS != 0) {
+                this_thread::sleep_for(chrono::microseconds(searchSettings->gcThrottleUS));
+            }
+        }
+    }
+    free_retired_nodes(retiredNodes);
+}
+
+void GCThread::free_old_tree()
+{
+    if (oldRootNode == nullptr) {
+        return;
+    }
+    vector<Node*> subtrees;
+    subtrees.emplace_back(oldRootNode);
+    oldRootNode = nullptr;
+    const size_t numberWorkers = max(size_t(1), searchSettings->gcThreads);
+
+    // split the tree breadth first until there are enough independent subtrees for all workers
+    vector<Node*> nextSubtrees;
+    vector<Node*> retiredNodes;
+    while (numberWorkers > 1 && !subtrees.empty() && subtrees.size() < numberWorkers * GC_SUBTREES_PER_WORKER) {
+        for (Node* node : subtrees) {
+            release_node(node, nextSubtrees, retiredNodes);
+        }
+        subtrees.clear();
+        swap(subtrees, nextSubtrees);
+    }
+    free_retired_nodes(retiredNodes);
+
+    atomic<size_t> nextSubtreeIdx(0);
+    vector<future<void>> workers;
+    for (size_t idx = 1; idx < numberWorkers && idx < subtrees.size(); ++idx) {
+        workers.emplace_back(threadPool->submit(bind(&GCThread::free_subtrees, this, ref(subtrees), ref(nextSubtreeIdx))));
+    }
+    free_subtrees(subtrees, nextSubtreeIdx);
+    wait_for_tasks(workers);
+}
 
 void run_gc_thread(GCThread *t)
 {
-    t->oldRootNode = nullptr;
+    t->free_old_tree();
 }
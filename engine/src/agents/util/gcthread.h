@@ -26,19 +26,65 @@
 #define GCTHREAD_H
 
 #include <vector>
+#include <atomic>
 #include "node.h"
+#include "transpositiontable.h"
+#include "util/threadpool.h"
 using namespace std;
 
+// number of freed nodes after which a throttled garbage collector sleeps
+#define GC_THROTTLE_INTERVAL 4096
+// the old tree is split into at least this number of subtrees per worker
+#define GC_SUBTREES_PER_WORKER 8
+// number of unlinked nodes after which a worker waits for the search threads and frees them
+#define GC_RETIRE_BATCH 65536
+
 /**
- * @brief The GCThread class is a garbage collector object which asynchronously frees memory
+ * @brief The GCThread class is a garbage collector object which asynchronously frees memory.
+ * The old tree is freed iteratively by detaching the child nodes of every node which is no longer referenced,
+ * so that no recursive cascade of destructors occurs. Disconnected subtrees are distributed across a small worker pool.
+ * The search runs concurrently and looks up the transposition table without a lock. Therefore, unlinked nodes are
+ * only freed in batches after the epoch manager of the table has been synchronized.
  */
 struct GCThread
 {
-    shared_ptr<Node> oldRootNode;
+    // root node of the former search, the garbage collector owns its reference
+    Node* oldRootNode;
+    // nodes of the old tree are removed from the table before they are freed, so that the search can't pick them up again
+    TranspositionTable* transpositionTable;
+    const SearchSettings* searchSettings;
+    // the additional workers are taken from the thread pool of the agent
+    ThreadPool* threadPool;
 public:
-    void delete_elements() {
-        oldRootNode = nullptr;
-    }
+    GCThread(TranspositionTable* transpositionTable, const SearchSettings* searchSettings, ThreadPool* threadPool);
+
+    /**
+     * @brief free_old_tree Frees all nodes of oldRootNode which aren't referenced by the current tree
+     */
+    void free_old_tree();
+
+private:
+    /**
+     * @brief release_node Releases the reference of the given node. If it was the last reference,
+     * its child nodes are moved to the given list and the node is added to the retired nodes.
+     * @param node Node of which the garbage collector holds a reference
+     * @param childNodes List of nodes which still need to be released
+     * @param retiredNodes List of unlinked nodes which will be freed after the next synchronization
+     */
+    void release_node(Node* node, vector<Node*>& childNodes, vector<Node*>& retiredNodes);
+
+    /**
+     * @brief free_retired_nodes Waits until no search thread can hold a pointer to the retired nodes anymore and frees them
+     * @param retiredNodes List of unlinked nodes
+     */
+    void free_retired_nodes(vector<Node*>& retiredNodes);
+
+    /**
+     * @brief free_subtrees Releases the given subtrees depth first without recursion. Can be run by several workers at once.
+     * @param subtrees List of subtree roots
+     * @param nextSubtreeIdx Index of the next subtree which hasn't been claimed by any worker yet
+     */
+    void free_subtrees(vector<Node*>& subtrees, atomic<size_t>& nextSubtreeIdx);
 };
 
 /**
@@ -0,0 +1,66 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: backuptree.cpp
+ * Created on 18.10.2026
+ * @author: queensgambit
+ */
+
+#include "backuptree.h"
+
+BackupTree::BackupTree() :
+    rootEdge(NO_BACKUP_EDGE)
+{
+}
+
+void BackupTree::insert(const Trajectory& trajectory, float value)
+{
+    size_t parentEdge = NO_BACKUP_EDGE;
+    for (const NodeAndIdx& step : trajectory) {
+        const size_t firstEdge = parentEdge == NO_BACKUP_EDGE ? rootEdge : edges[parentEdge].firstChild;
+        size_t edgeIdx = firstEdge;
+        while (edgeIdx != NO_BACKUP_EDGE && (edges[edgeIdx].node != step.node || edges[edgeIdx].childIdx != step.childIdx)) {
+            edgeIdx = edges[edgeIdx].nextSibling;
+        }
+        if (edgeIdx == NO_BACKUP_EDGE) {
+            edgeIdx = edges.size();
+            edges.emplace_back(step.node, step.childIdx, firstEdge);
+            if (parentEdge == NO_BACKUP_EDGE) {
+                rootEdge = edgeIdx;
+            }
+            else {
+                edges[parentEdge].firstChild = edgeIdx;
+            }
+        }
+        ++edges[edgeIdx].visits;
+        parentEdge = edgeIdx;
+    }
+    edges[parentEdge].leafValueSum += value;
+}
+
+bool passes_transposition(const Trajectory& trajectory)
+{
+    for (size_t idx = 1; idx < trajectory.size(); ++idx) {
+        if (trajectory[idx].node->is_transposition()) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,175 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: backuptree.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Prefix tree which merges the trajectories of a mini-batch for the backup.
+ * Every node of the tree is locked once to update all of its edges with their combined visits and values
+ * instead of once per trajectory which passes it.
+ */
+
+#ifndef BACKUPTREE_H
+#define BACKUPTREE_H
+
+#include <vector>
+#include "node.h"
+
+using namespace std;
+
+// marks the end of an edge list of the backup tree
+#define NO_BACKUP_EDGE size_t(-1)
+
+/**
+ * @brief The BackupEdge struct is an edge of the prefix tree which merges the trajectories of a mini-batch for the backup.
+ * All edges of a sibling list leave the same node.
+ */
+struct BackupEdge
+{
+    Node* node;
+    ChildIdx childIdx;
+    // number of trajectories which pass through this edge
+    uint32_t visits;
+    // value sum of the trajectories which end at this edge from the point of view of the reached child node
+    double leafValueSum;
+    // value sum which is backed up on this edge from the point of view of the node
+    double valueSum;
+    // first edge which leaves the reached child node and next edge which leaves the same node as this edge
+    size_t firstChild;
+    size_t nextSibling;
+    BackupEdge(Node* node, ChildIdx childIdx, size_t nextSibling) :
+        node(node), childIdx(childIdx), visits(0), leafValueSum(0), valueSum(0), firstChild(NO_BACKUP_EDGE), nextSibling(nextSibling) {}
+};
+
+class BackupTree
+{
+private:
+    vector<BackupEdge> edges;
+    // first edge which leaves the root node
+    size_t rootEdge;
+
+    /**
+     * @brief insert Merges the given trajectory into the prefix tree
+     * @param trajectory Trajectory from the root node to the leaf
+     * @param value Value of the leaf node
+     */
+    void insert(const Trajectory& trajectory, float value);
+
+    /**
+     * @brief backup_edges Backpropagates the given sibling list after all edges below it have been backed up
+     * @param firstEdge First edge of the sibling list
+     * @param searchSettings Pointer to the search settings struct
+     * @return Sum of the values which were backed up on the edges of the sibling list
+     */
+    template<bool freeBackup>
+    double backup_edges(size_t firstEdge, const SearchSettings* searchSettings);
+
+public:
+    BackupTree();
+
+    /**
+     * @brief add_trajectory Defers the backup of the given trajectory until backup() is called.
+     * Trajectories which pass a transposition node or use the terminal solver depend on the updates of the preceding trajectories.
+     * They are backed up directly after the deferred trajectories, so that the result equals calling backup_value() for every trajectory in order.
+     * @param value Value of the leaf node
+     * @param searchSettings Pointer to the search settings struct
+     * @param trajectory Trajectory from the root node to the leaf, all virtual losses along it must have been applied
+     * @param solveForTerminal Decides if the terminal solver will be used
+     */
+    template<bool freeBackup>
+    void add_trajectory(float value, const SearchSettings* searchSettings, const Trajectory& trajectory, bool solveForTerminal);
+
+    /**
+     * @brief backup Backpropagates all deferred trajectories and clears the prefix tree
+     * @param searchSettings Pointer to the search settings struct
+     */
+    template<bool freeBackup>
+    void backup(const SearchSettings* searchSettings);
+};
+
+/**
+ * @brief passes_transposition Returns true if a node of the trajectory below the root node is a transposition node.
+ * The values which are backed up through a transposition node depend on its current value.
+ */
+bool passes_transposition(const Trajectory& trajectory);
+
+template<bool freeBackup>
+void BackupTree::add_trajectory(float value, const SearchSettings* searchSettings, const Trajectory& trajectory, bool solveForTerminal)
+{
+    if (!solveForTerminal && !passes_transposition(trajectory)) {
+        // the updates of trajectories without transpositions only depend on the sum of their values
+        insert(trajectory, value);
+        return;
+    }
+    backup<freeBackup>(searchSettings);
+    backup_value<freeBackup>(value, searchSettings, trajectory, solveForTerminal);
+}
+
+template<bool freeBackup>
+void BackupTree::backup(const SearchSettings* searchSettings)
+{
+    if (rootEdge != NO_BACKUP_EDGE) {
+        backup_edges<freeBackup>(rootEdge, searchSettings);
+    }
+    edges.clear();
+    rootEdge = NO_BACKUP_EDGE;
+}
+
+template<bool freeBackup>
+double BackupTree::backup_edges(size_t firstEdge, const SearchSettings* searchSettings)
+{
+    Node* node = edges[firstEdge].node;
+    double siblingValueSum = 0;
+    for (size_t edgeIdx = firstEdge; edgeIdx != NO_BACKUP_EDGE; edgeIdx = edges[edgeIdx].nextSibling) {
+        BackupEdge& edge = edges[edgeIdx];
+        assert(edge.node == node);
+        double valueSum = edge.leafValueSum;
+        if (edge.firstChild != NO_BACKUP_EDGE) {
+            valueSum += backup_edges<freeBackup>(edge.firstChild, searchSettings);
+        }
+        if (searchSettings->searchPlayerMode == MODE_TWO_PLAYER) {
+            valueSum = -valueSum;
+        }
+        edge.valueSum = valueSum;
+        siblingValueSum += valueSum;
+    }
+
+    if (node->has_locked_updates(searchSettings)) {
+        node->lock();
+        for (size_t edgeIdx = firstEdge; edgeIdx != NO_BACKUP_EDGE; edgeIdx = edges[edgeIdx].nextSibling) {
+            const BackupEdge& edge = edges[edgeIdx];
+            node->revert_virtual_losses_and_update(edge.childIdx, edge.visits, edge.valueSum, searchSettings, freeBackup);
+        }
+        node->unlock();
+    }
+    else {
+        // lock-free and partitioned updates handle one visit at a time, equal values lead to the same result as the combined update
+        for (size_t edgeIdx = firstEdge; edgeIdx != NO_BACKUP_EDGE; edgeIdx = edges[edgeIdx].nextSibling) {
+            const BackupEdge& edge = edges[edgeIdx];
+            for (uint32_t visit = 0; visit < edge.visits; ++visit) {
+                node->revert_virtual_loss_and_update<freeBackup>(edge.childIdx, float(edge.valueSum / edge.visits), searchSettings, false);
+            }
+        }
+    }
+    return siblingValueSum;
+}
+
+#endif // BACKUPTREE_H
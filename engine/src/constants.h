@@ -85,7 +85,8 @@ const string engineAuthors = "Johannes Czech and CrazyAra developers (see AUTHOR
 #define Q_INIT -1.0f
 #define DEPTH_INIT 64
 #define Q_TRANSPOS_DIFF 0.01
-#define MAX_HASH_SIZE 100000000
+#define DEFAULT_HASH_MB 256
+#define MAX_HASH_MB 1048576
 #ifdef MODE_CHESS
 #define VALUE_TO_CENTI_PARAM 1.4f
 #else
@@ -106,6 +106,8 @@ Board& Board::operator=(const Board &b)
 #if defined(MODE_CHESS) || defined(MODE_LICHESS)
     lastMoves = b.lastMoves;  // vectors and deques are deeply copied by default
 #endif
+    // the copy cannot undo moves which were done before the copy was made
+    droppedMoves.clear();
     return *this;
 }
 
@@ -227,6 +229,7 @@ void Board::add_move_to_list(Move m)
     }
     lastMoves.push_front(m);
     if (lastMoves.size() > StateConstants::NB_LAST_MOVES()) {
+        droppedMoves.emplace_back(lastMoves.back());
         lastMoves.pop_back();
     }
 }
@@ -249,6 +252,11 @@ void Board::undo_move(Move m)
         // make sure the lastMoves deque is not empty, otherwise crash will occur
         lastMoves.pop_front();
     }
+    if (!droppedMoves.empty()) {
+        // all moves since the list has been full have dropped a move, so the most recent one belongs to this move
+        lastMoves.push_back(droppedMoves.back());
+        droppedMoves.pop_back();
+    }
     Position::undo_move(m);
 }
 
@@ -265,12 +273,14 @@ int Board::get_board_piece_count(Color color, PieceType pieceType) const
 void Board::set(const string &fenStr, bool isChess960, Variant v, StateInfo *si, Thread *th)
 {
     lastMoves.clear();
+    droppedMoves.clear();
     Position::set(fenStr, isChess960, v, si, th);
 }
 
 void Board::set(const string &code, Color c, Variant v, StateInfo *si)
 {
     lastMoves.clear();
+    droppedMoves.clear();
     Position::set(code, c, v, si);
 }
 
@@ -31,6 +31,7 @@
 #ifndef MODE_POMMERMAN
 #include <position.h>
 #include <deque>
+#include <vector>
 #include "syzygy/tbprobe.h"
 #include "../constants.h"
 #include <blaze/Math.h>
@@ -42,6 +43,8 @@ class Board : public Position
 private:
     // up to NB_LAST_MOVES are stored in a list, most recent moves first
     deque<Move> lastMoves;
+    // moves which have been removed from lastMoves by do_move() and are restored by undo_move()
+    vector<Move> droppedMoves;
     /**
      * @brief add_move_to_list Adds a given move to the move list and removes the
      * last element if the list exceeds NB_LAST_MOVES items
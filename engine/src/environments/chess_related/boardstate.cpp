@@ -103,6 +103,7 @@ void BoardState::do_action(Action action)
 void BoardState::undo_action(Action action)
 {
     board.undo_move(Move(action));
+    states->pop_back();
 }
 
 void BoardState::prepare_action()
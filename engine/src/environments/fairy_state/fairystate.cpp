@@ -67,6 +67,7 @@ void FairyState::do_action(Action action) {
 
 void FairyState::undo_action(Action action) {
     board.undo_move(Move(action));
+    states->pop_back();
 }
 
 void FairyState::prepare_action() {
@@ -32,7 +32,8 @@ ThreadManager::ThreadManager(ThreadManagerData* tData, ThreadManagerInfo* tInfo,
     tInfo(tInfo),
     tParams(tParams),
     checkedContinueSearch(0),
-    isRunning(true)
+    isRunning(true),
+    isPondering(tInfo->searchLimits->ponder)
 {
 }
 
@@ -55,8 +56,39 @@ void ThreadManager::await_kill_signal()
     }
 }
 
+void ThreadManager::await_ponderhit()
+{
+    while (true) {
+        unique_lock<mutex> lock(mtx);
+        if (cv.wait_for(lock, chrono::milliseconds(tParams->updateIntervalMS*4), [&]{return terminate || !isPondering;})) {
+            return;
+        }
+        lock.unlock();
+        if (tData->searchThreads.front()->is_running()) {
+            print_info();
+        }
+    }
+}
+
+void ThreadManager::ponderhit()
+{
+    unique_lock<mutex> lock(mtx);
+    isPondering = false;
+    cv.notify_all();
+}
+
+bool ThreadManager::is_pondering() const
+{
+    unique_lock<mutex> lock(mtx);
+    return isPondering;
+}
+
 void run_thread_manager(ThreadManager* t)
 {
+    if (t->is_pondering()) {
+        // the move time only starts to count after the ponderhit
+        t->await_ponderhit();
+    }
     if (t->get_movetime_ms() == 0) {
         t->await_kill_signal();
     }
@@ -197,6 +229,43 @@ size_t get_max_depth(const vector<SearchThread*>& searchThreads)
     return maxDepth;
 }
 
+float get_collision_rate(const vector<SearchThread*>& searchThreads)
+{
+    size_t descents = 0;
+    size_t collisions = 0;
+    for (SearchThread* searchThread : searchThreads) {
+        descents += searchThread->get_descent_count();
+        collisions += searchThread->get_collision_count();
+    }
+    if (descents == 0) {
+        return 0;
+    }
+    return float(collisions) / descents;
+}
+
+size_t get_reused_collisions(const vector<SearchThread*>& searchThreads)
+{
+    size_t reusedCollisions = 0;
+    for (SearchThread* searchThread : searchThreads) {
+        reusedCollisions += searchThread->get_reused_collision_count();
+    }
+    return reusedCollisions;
+}
+
+size_t get_avg_expansion_time(const vector<SearchThread*>& searchThreads)
+{
+    size_t expansions = 0;
+    size_t expansionTimeNS = 0;
+    for (SearchThread* searchThread : searchThreads) {
+        expansions += searchThread->get_expansion_count();
+        expansionTimeNS += searchThread->get_expansion_time_ns();
+    }
+    if (expansions == 0) {
+        return 0;
+    }
+    return expansionTimeNS / expansions;
+}
+
 size_t get_tb_hits(const vector<SearchThread*>& searchThreads)
 {
     size_t tbHits = 0;
@@ -84,6 +84,8 @@ private:
     ThreadManagerParams* tParams;
     int checkedContinueSearch = 0;
     bool isRunning;
+    // true until the ponderhit of a "go ponder" search, guarded by mtx
+    bool isPondering;
     /**
      * @brief check_early_stopping Checks if the search can be ended prematurely based on the current tree statistics (visits & Q-values)
      * @return True, if early stopping is recommended
@@ -126,6 +128,21 @@ public:
      */
     void await_kill_signal();
 
+    /**
+     * @brief await_ponderhit Logs the search progress until ponderhit() or kill() is called
+     */
+    void await_ponderhit();
+
+    /**
+     * @brief ponderhit Ends the pondering phase, so the search limits take effect from now on
+     */
+    void ponderhit();
+
+    /**
+     * @brief is_pondering Returns true if the search hasn't received the ponderhit yet
+     */
+    bool is_pondering() const;
+
     size_t get_movetime_ms() const;
     bool isInGame() const;
 };
@@ -171,5 +188,26 @@ size_t get_avg_depth(const vector<SearchThread*>& searchThreads);
  */
 size_t get_max_depth(const vector<SearchThread*>& searchThreads);
 
+/**
+ * @brief get_collision_rate Returns the share of descents which ended in a collision for all threads
+ * @param searchThreads MCTS search threads
+ * @return collision rate in [0, 1]
+ */
+float get_collision_rate(const vector<SearchThread*>& searchThreads);
+
+/**
+ * @brief get_reused_collisions Returns the number of collisions which were backed up as an additional visit for all threads
+ * @param searchThreads MCTS search threads
+ * @return number of reused collisions
+ */
+size_t get_reused_collisions(const vector<SearchThread*>& searchThreads);
+
+/**
+ * @brief get_avg_expansion_time Returns the average time of a node expansion (legal move generation and terminal checks) for all threads
+ * @param searchThreads MCTS search threads
+ * @return average expansion time in nano seconds
+ */
+size_t get_avg_expansion_time(const vector<SearchThread*>& searchThreads);
+
 
 #endif // THREADMANAGER_H
@@ -37,10 +37,9 @@ TimeManager::TimeManager(float randomMoveFactor, int expectedGameLength, int thr
     expectedGameLength(expectedGameLength),
     threshMove(threshMove),
     timePropMovesToGo(timePropMovesToGo),
-    incrementFactor(incrementFactor)
+    incrementFactor(incrementFactor),
+    randomGenerator(derive_seed(0, 0))
 {
-    auto seed = std::chrono::high_resolution_clock::now().time_since_epoch().count();
-    srand(unsigned(int(seed)));
     assert(threshMove < expectedGameLength);
 }
 
@@ -112,5 +111,5 @@ int TimeManager::apply_random_factor(int curMovetime)
 
 float TimeManager::get_current_random_factor()
 {
-    return (double(rand()) / RAND_MAX) * randomMoveFactor * 2 - randomMoveFactor;
+    return randomGenerator.uniform() * randomMoveFactor * 2 - randomMoveFactor;
 }
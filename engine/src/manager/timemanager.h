@@ -32,6 +32,7 @@
 #include "../agents/config/searchlimits.h"
 #include "state.h"
 #include "constants.h"
+#include "util/randomgen.h"
 
 class TimeManager
 {
@@ -43,6 +44,8 @@ private:
     int threshMove;
     int timePropMovesToGo;
     float incrementFactor;
+    // generator of the random move factor
+    Xoshiro256 randomGenerator;
 
     /**
      * @brief apply_random_factor Applies the current randomly generated move factor on the given movetime.
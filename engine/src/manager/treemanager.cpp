@@ -26,12 +26,16 @@
 #include "treemanager.h"
 #include "../node.h"
 
-shared_ptr<Node> pick_next_node(Action move, const Node* parentNode)
+Node* pick_next_node(Action move, const Node* parentNode)
 {
     if (parentNode != nullptr) {
         for (size_t idx = 0; idx < parentNode->get_no_visit_idx(); ++idx) {
             if (parentNode->get_legal_actions()[idx] == move) {
-                return parentNode->get_child_node_shared(idx);
+                Node* nextNode = parentNode->get_child_node(idx);
+                if (nextNode != nullptr) {
+                    nextNode->acquire_reference();
+                }
+                return nextNode;
             }
         }
     }
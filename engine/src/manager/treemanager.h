@@ -36,8 +36,9 @@
  * @brief pick_next_node Return the next node when doing the given move for the parent node
  * @param move Move
  * @param ownMove Boolean indicating if it was CrazyAra's move
+ * @return Child node with a new reference for the caller or nullptr
  */
-shared_ptr<Node> pick_next_node(Action move, const Node* parentNode);
+Node* pick_next_node(Action move, const Node* parentNode);
 
 /**
  * @brief same_hash_key Checks if the given node isn't a nullptr and
@@ -0,0 +1,166 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: inferenceserver.cpp
+ * Created on 18.10.2026
+ * @author: queensgambit
+ */
+
+#include "inferenceserver.h"
+#include <algorithm>
+#include "stateobj.h"
+
+InferenceServer::InferenceServer(NeuralNetAPI* net, size_t maxLatencyUS):
+    NeuralNetAPIUser(net),
+    queuedEntries(0),
+    activeClients(0),
+    maxLatency(maxLatencyUS),
+    nbAuxiliaryValues(0),
+    isRunning(true)
+{
+    if (auxiliaryOutputs != nullptr) {
+#if defined(TENSORRT) || defined(DYNAMIC_NN_ARCH)
+        nbAuxiliaryValues = net->get_nb_auxiliary_outputs();
+#else
+        nbAuxiliaryValues = StateConstants::NB_AUXILIARY_OUTPUTS();
+#endif
+    }
+    dispatcher = thread(&InferenceServer::run_dispatcher, this);
+}
+
+InferenceServer::~InferenceServer()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        isRunning = false;
+    }
+    cvRequests.notify_one();
+    dispatcher.join();
+}
+
+void InferenceServer::predict(const float* inputPlanes, float* valueOutputs, float* probOutputs, float* auxiliaryOutputs, size_t numberEntries)
+{
+    const size_t batchSize = net->get_batch_size();
+    for (size_t offset = 0; offset < numberEntries; offset += batchSize) {
+        InferenceRequest request;
+        request.inputPlanes = inputPlanes + offset * net->get_nb_input_values_total();
+        request.valueOutputs = valueOutputs + offset;
+        request.probOutputs = probOutputs + offset * net->get_nb_policy_values();
+        request.auxiliaryOutputs = auxiliaryOutputs == nullptr ? nullptr : auxiliaryOutputs + offset * nbAuxiliaryValues;
+        request.numberEntries = min(batchSize, numberEntries - offset);
+        request.arrival = chrono::steady_clock::now();
+        request.done = false;
+
+        unique_lock<mutex> lock(mtx);
+        requestQueue.push_back(&request);
+        queuedEntries += request.numberEntries;
+        cvRequests.notify_one();
+        cvResults.wait(lock, [&request]{ return request.done; });
+    }
+}
+
+void InferenceServer::connect_client()
+{
+    lock_guard<mutex> lock(mtx);
+    ++activeClients;
+}
+
+void InferenceServer::disconnect_client()
+{
+    {
+        lock_guard<mutex> lock(mtx);
+        --activeClients;
+    }
+    // the remaining clients might all be waiting now
+    cvRequests.notify_one();
+}
+
+size_t InferenceServer::get_batch_size() const
+{
+    return net->get_batch_size();
+}
+
+bool InferenceServer::is_batch_ready() const
+{
+    return !isRunning || queuedEntries >= net->get_batch_size() || requestQueue.size() >= activeClients;
+}
+
+void InferenceServer::run_dispatcher()
+{
+    vector<InferenceRequest*> requests;
+    const size_t batchSize = net->get_batch_size();
+
+    while (true) {
+        {
+            unique_lock<mutex> lock(mtx);
+            cvRequests.wait(lock, [this]{ return !isRunning || !requestQueue.empty(); });
+            if (requestQueue.empty()) {
+                // the server was shut down
+                return;
+            }
+            // wait until the batch is full or the oldest request reached its deadline
+            cvRequests.wait_until(lock, requestQueue.front()->arrival + maxLatency, [this]{ return is_batch_ready(); });
+
+            size_t batchEntries = 0;
+            while (!requestQueue.empty() && batchEntries + requestQueue.front()->numberEntries <= batchSize) {
+                batchEntries += requestQueue.front()->numberEntries;
+                requests.emplace_back(requestQueue.front());
+                requestQueue.pop_front();
+            }
+            queuedEntries -= batchEntries;
+        }
+
+        evaluate_requests(requests);
+
+        {
+            lock_guard<mutex> lock(mtx);
+            for (InferenceRequest* request : requests) {
+                request->done = true;
+            }
+        }
+        cvResults.notify_all();
+        requests.clear();
+    }
+}
+
+void InferenceServer::evaluate_requests(const vector<InferenceRequest*>& requests)
+{
+    const size_t nbInputValues = net->get_nb_input_values_total();
+    const size_t nbPolicyValues = net->get_nb_policy_values();
+
+    size_t batchIdx = 0;
+    for (const InferenceRequest* request : requests) {
+        copy_n(request->inputPlanes, request->numberEntries * nbInputValues, inputPlanes + batchIdx * nbInputValues);
+        batchIdx += request->numberEntries;
+    }
+
+    net->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs, batchIdx);
+
+    batchIdx = 0;
+    for (InferenceRequest* request : requests) {
+        copy_n(valueOutputs + batchIdx, request->numberEntries, request->valueOutputs);
+        copy_n(probOutputs + batchIdx * nbPolicyValues, request->numberEntries * nbPolicyValues, request->probOutputs);
+        if (request->auxiliaryOutputs != nullptr) {
+            copy_n(auxiliaryOutputs + batchIdx * nbAuxiliaryValues, request->numberEntries * nbAuxiliaryValues, request->auxiliaryOutputs);
+        }
+        batchIdx += request->numberEntries;
+    }
+}
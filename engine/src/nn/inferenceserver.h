@@ -0,0 +1,129 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: inferenceserver.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Central inference service which combines the mini-batches of several search threads into a single large batch.
+ * The search threads submit their filled input planes and block until the results have been written back.
+ * A dispatcher thread runs the inference as soon as the batch is full, all connected clients are waiting
+ * or the latency deadline of the oldest request has expired.
+ */
+
+#ifndef INFERENCESERVER_H
+#define INFERENCESERVER_H
+
+#include <deque>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include "neuralnetapiuser.h"
+
+/**
+ * @brief The InferenceRequest struct describes a mini-batch of a single search thread which awaits its evaluation
+ */
+struct InferenceRequest
+{
+    const float* inputPlanes;
+    float* valueOutputs;
+    float* probOutputs;
+    float* auxiliaryOutputs;
+    size_t numberEntries;
+    chrono::steady_clock::time_point arrival;
+    bool done;
+};
+
+/**
+ * @brief The InferenceServer class owns a neural network handle with a large batch size which is shared by multiple search threads
+ */
+class InferenceServer : public NeuralNetAPIUser
+{
+private:
+    mutex mtx;
+    // notifies the dispatcher about new requests
+    condition_variable cvRequests;
+    // notifies the waiting search threads about finished requests
+    condition_variable cvResults;
+    deque<InferenceRequest*> requestQueue;
+    size_t queuedEntries;
+    size_t activeClients;
+    chrono::microseconds maxLatency;
+    size_t nbAuxiliaryValues;
+    bool isRunning;
+    thread dispatcher;
+
+    /**
+     * @brief run_dispatcher Main loop of the dispatcher thread which fills the batch and runs the inference
+     */
+    void run_dispatcher();
+
+    /**
+     * @brief is_batch_ready Returns true if the queued requests should be evaluated without further waiting
+     * @return bool
+     */
+    inline bool is_batch_ready() const;
+
+    /**
+     * @brief evaluate_requests Copies the inputs of the given requests into the batch, runs the inference and scatters the results back
+     * @param requests Requests which fit into a single batch
+     */
+    void evaluate_requests(const vector<InferenceRequest*>& requests);
+
+public:
+    /**
+     * @brief InferenceServer
+     * @param net Neural network handle which is exclusively used by this server
+     * @param maxLatencyUS Maximum time in micro seconds which the oldest request waits for the batch to fill up
+     */
+    InferenceServer(NeuralNetAPI* net, size_t maxLatencyUS);
+    ~InferenceServer();
+
+    /**
+     * @brief predict Submits a mini-batch to the server and blocks until its evaluation is finished.
+     * Mini-batches which are larger than the batch size of the server are split into several requests.
+     * @param inputPlanes Input planes of the mini-batch
+     * @param valueOutputs Value output buffer of the mini-batch
+     * @param probOutputs Policy output buffer of the mini-batch
+     * @param auxiliaryOutputs Auxiliary output buffer of the mini-batch (can be nullptr if the network has no auxiliary outputs)
+     * @param numberEntries Number of filled entries in the mini-batch
+     */
+    void predict(const float* inputPlanes, float* valueOutputs, float* probOutputs, float* auxiliaryOutputs, size_t numberEntries);
+
+    /**
+     * @brief connect_client Registers a search thread which is actively submitting requests.
+     * The batch is evaluated immediately if every connected client is waiting for its results.
+     */
+    void connect_client();
+
+    /**
+     * @brief disconnect_client Unregisters a search thread which stopped searching
+     */
+    void disconnect_client();
+
+    /**
+     * @brief get_batch_size Returns the batch size of the underlying neural network
+     * @return Batch size
+     */
+    size_t get_batch_size() const;
+};
+
+#endif // INFERENCESERVER_H
@@ -191,15 +191,17 @@ NDArray MXNetAPI::predict(float* inputPlanes, float& value)
     return probOutputs;
 }
 
-void MXNetAPI::predict(float *inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+void MXNetAPI::predict(float *inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs, size_t numberEntries)
 {
+    // the executor is bound to a constant batch size and MXNet only copies arrays of the full bound size,
+    // the buffers are allocated for the full batch and the caller only reads the first numberEntries results
     executor->arg_dict()["data"].SyncCopyFromCPU(inputPlanes, StateConstants::NB_VALUES_TOTAL() * batchSize);
 
     // Run the forward pass.
     executor->Forward(false);
 
     executor->outputs[0].SyncCopyToCPU(valueOutput, batchSize);
-    executor->outputs[1].SyncCopyToCPU(probOutputs, get_policy_output_length());
+    executor->outputs[1].SyncCopyToCPU(probOutputs, get_nb_policy_values() * batchSize);
 #ifdef DYNAMIC_NN_ARCH
     if (has_auxiliary_outputs()) {
         executor->outputs[2].SyncCopyToCPU(auxiliaryOutputs, get_nb_auxiliary_outputs()*batchSize);
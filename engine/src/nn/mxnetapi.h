@@ -55,7 +55,7 @@ public:
     MXNetAPI(const string& ctx, int deviceID, unsigned int miniBatchSize, const string& modelDirectory,  const string& strPrecision, bool tensorRT);
     ~MXNetAPI();
 
-    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs, size_t numberEntries) override;
 
 protected:
     void load_model() override;
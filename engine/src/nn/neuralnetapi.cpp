@@ -79,6 +79,15 @@ unsigned int NeuralNetAPI::get_batch_size() const
     return batchSize;
 }
 
+unsigned int NeuralNetAPI::get_inference_batch_size(size_t numberEntries) const
+{
+    unsigned int inferenceBatchSize = 1;
+    while (inferenceBatchSize < numberEntries && inferenceBatchSize < batchSize) {
+        inferenceBatchSize *= 2;
+    }
+    return min(inferenceBatchSize, batchSize);
+}
+
 void NeuralNetAPI::initialize_nn_design()
 {
     init_nn_design();
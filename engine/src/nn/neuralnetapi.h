@@ -216,8 +216,10 @@ public:
      * @param value Value prediction for the board by the neural network
      * @param probOutputs Policy array of the raw network output (including illegal moves). It's assumend that the memory has already been allocated.
      * @param auxiliaryOutputs Array of optional auxiliary outputs
+     * @param numberEntries Number of filled entries in the batch. Back-ends with dynamic batch support only evaluate these entries,
+     * the outputs of all further entries are undefined.
      */
-    virtual void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) = 0;
+    virtual void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs, size_t numberEntries) = 0;
 
     /**
      * @brief is_neural_network_valid Runs validation checks of the neural network architecture by comparing input and output shape of the loaded graph to the pre-defined constants.
@@ -291,6 +293,14 @@ protected:
      * @brief initialize_nn_design Template method pattern which calls init_nn_design() and does post processing
      */
     void initialize_nn_design();
+
+    /**
+     * @brief get_inference_batch_size Returns the batch size which is used to evaluate the given number of entries.
+     * The number is rounded up to the next power of two to limit the number of different shapes.
+     * @param numberEntries Number of filled entries in the batch
+     * @return Batch size in the range [numberEntries, batchSize]
+     */
+    unsigned int get_inference_batch_size(size_t numberEntries) const;
 };
 
 /**
@@ -31,69 +31,110 @@
 #include "common.h"
 #endif
 
-NeuralNetAPIUser::NeuralNetAPIUser(NeuralNetAPI *net):
-    net(net),
-    auxiliaryOutputs(nullptr)
+/**
+ * @brief allocate_buffers Allocates the memory of a single buffer set for all predictions and results
+ * @param net Neural network handle which defines the buffer sizes
+ * @param buffers Buffer set which will be allocated
+ * @param batchSize Number of batch entries
+ */
+void allocate_buffers(NeuralNetAPI* net, InferenceBuffers& buffers, size_t batchSize)
 {
-    // allocate memory for all predictions and results
+    buffers.auxiliaryOutputs = nullptr;
 #ifdef TENSORRT
 #ifdef DYNAMIC_NN_ARCH
-    CHECK(cudaMallocHost((void**) &inputPlanes, net->get_batch_size() * net->get_nb_input_values_total() * sizeof(float)));
+    CHECK(cudaMallocHost((void**) &buffers.inputPlanes, batchSize * net->get_nb_input_values_total() * sizeof(float)));
 #else
-     CHECK(cudaMallocHost((void**) &inputPlanes, net->get_batch_size() * StateConstants::NB_VALUES_TOTAL() * sizeof(float)));
+     CHECK(cudaMallocHost((void**) &buffers.inputPlanes, batchSize * StateConstants::NB_VALUES_TOTAL() * sizeof(float)));
 #endif
-    CHECK(cudaMallocHost((void**) &valueOutputs, net->get_batch_size() * sizeof(float)));
-    CHECK(cudaMallocHost((void**) &probOutputs, net->get_batch_size() * net->get_nb_policy_values() * sizeof(float)));
+    CHECK(cudaMallocHost((void**) &buffers.valueOutputs, batchSize * sizeof(float)));
+    CHECK(cudaMallocHost((void**) &buffers.probOutputs, batchSize * net->get_nb_policy_values() * sizeof(float)));
     if (net->has_auxiliary_outputs()) {
-        CHECK(cudaMallocHost((void**) &auxiliaryOutputs, net->get_batch_size() * net->get_nb_auxiliary_outputs() * sizeof(float)));
+        CHECK(cudaMallocHost((void**) &buffers.auxiliaryOutputs, batchSize * net->get_nb_auxiliary_outputs() * sizeof(float)));
     }
 #else
-    inputPlanes = new float[net->get_batch_size() * net->get_nb_input_values_total()];
-    valueOutputs = new float[net->get_batch_size()];
-    probOutputs = new float[net->get_batch_size() * net->get_nb_policy_values()];
+    buffers.inputPlanes = new float[batchSize * net->get_nb_input_values_total()];
+    buffers.valueOutputs = new float[batchSize];
+    buffers.probOutputs = new float[batchSize * net->get_nb_policy_values()];
 #ifdef DYNAMIC_NN_ARCH
     if (net->has_auxiliary_outputs()) {
-        auxiliaryOutputs = new float[net->get_batch_size() * net->get_nb_auxiliary_outputs()];
+        buffers.auxiliaryOutputs = new float[batchSize * net->get_nb_auxiliary_outputs()];
     }
 #else
     if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
-         auxiliaryOutputs = new float[net->get_batch_size() * StateConstants::NB_AUXILIARY_OUTPUTS()];
+         buffers.auxiliaryOutputs = new float[batchSize * StateConstants::NB_AUXILIARY_OUTPUTS()];
     }
 #endif
 #endif
 }
 
-NeuralNetAPIUser::~NeuralNetAPIUser()
+/**
+ * @brief free_buffers Frees the memory of a buffer set which was allocated via allocate_buffers()
+ * @param net Neural network handle
+ * @param buffers Buffer set which will be freed
+ */
+void free_buffers(NeuralNetAPI* net, InferenceBuffers& buffers)
 {
 #ifdef TENSORRT
-    CHECK(cudaFreeHost(inputPlanes));
-    CHECK(cudaFreeHost(valueOutputs));
-    CHECK(cudaFreeHost(probOutputs));
+    CHECK(cudaFreeHost(buffers.inputPlanes));
+    CHECK(cudaFreeHost(buffers.valueOutputs));
+    CHECK(cudaFreeHost(buffers.probOutputs));
 #ifdef DYNAMIC_NN_ARCH
     if (net->has_auxiliary_outputs()) {
 #else
     if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
 #endif
-        CHECK(cudaFreeHost(auxiliaryOutputs));
+        CHECK(cudaFreeHost(buffers.auxiliaryOutputs));
     }
 #else
-    delete [] inputPlanes;
-    delete [] valueOutputs;
-    delete [] probOutputs;
+    delete [] buffers.inputPlanes;
+    delete [] buffers.valueOutputs;
+    delete [] buffers.probOutputs;
 #ifdef DYNAMIC_NN_ARCH
     if (net->has_auxiliary_outputs()) {
 #else
     if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
 #endif
-        delete [] auxiliaryOutputs;
+        delete [] buffers.auxiliaryOutputs;
     }
 #endif
 }
 
+NeuralNetAPIUser::NeuralNetAPIUser(NeuralNetAPI *net, size_t numberBufferSets, size_t batchSize):
+    net(net),
+    auxiliaryOutputs(nullptr),
+    bufferSets(max(numberBufferSets, size_t(1))),
+    activeBufferSet(0)
+{
+    // allocate memory for all predictions and results
+    if (batchSize == 0) {
+        batchSize = net->get_batch_size();
+    }
+    for (InferenceBuffers& buffers : bufferSets) {
+        allocate_buffers(net, buffers, batchSize);
+    }
+    set_active_buffer_set(0);
+}
+
+NeuralNetAPIUser::~NeuralNetAPIUser()
+{
+    for (InferenceBuffers& buffers : bufferSets) {
+        free_buffers(net, buffers);
+    }
+}
+
+void NeuralNetAPIUser::set_active_buffer_set(size_t idx)
+{
+    activeBufferSet = idx;
+    inputPlanes = bufferSets[idx].inputPlanes;
+    valueOutputs = bufferSets[idx].valueOutputs;
+    probOutputs = bufferSets[idx].probOutputs;
+    auxiliaryOutputs = bufferSets[idx].auxiliaryOutputs;
+}
+
 void NeuralNetAPIUser::run_inference(uint_fast16_t iterations)
 {
     for (uint_fast16_t it = 0; it < iterations; ++it) {
-        net->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
+        net->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs, net->get_batch_size());
     }
 }
 
@@ -28,8 +28,20 @@
 #ifndef NEURALNETAPIUSER_H
 #define NEURALNETAPIUSER_H
 
+#include <vector>
 #include "neuralnetapi.h"
 
+/**
+ * @brief The InferenceBuffers struct groups the input planes and all neural network outputs which belong to a single mini-batch.
+ */
+struct InferenceBuffers
+{
+    float* inputPlanes;
+    float* valueOutputs;
+    float* probOutputs;
+    float* auxiliaryOutputs;
+};
+
 /**
  * @brief The NeuralNetAPIUser class is a utility class which handles memory allocation and de-allocation.
  * The results of NN-inference are stored in valueOutputs and probOutputs.
@@ -47,8 +59,25 @@ protected:
     float* probOutputs;
     float* auxiliaryOutputs;
 
+    // all allocated buffer sets, the pointers above always refer to the active buffer set
+    std::vector<InferenceBuffers> bufferSets;
+    size_t activeBufferSet;
+
+    /**
+     * @brief set_active_buffer_set Sets the buffer set which is used by inputPlanes, valueOutputs, probOutputs and auxiliaryOutputs
+     * @param idx Index of the buffer set
+     */
+    void set_active_buffer_set(size_t idx);
+
 public:
-    NeuralNetAPIUser(NeuralNetAPI* net);
+    /**
+     * @brief NeuralNetAPIUser
+     * @param net Neural network handle
+     * @param numberBufferSets Number of independent input / output buffers which are allocated.
+     * Multiple buffer sets allow filling a new mini-batch while a previous one is still being evaluated.
+     * @param batchSize Number of batch entries for each buffer set. The batch size of the network is used if set to 0.
+     */
+    NeuralNetAPIUser(NeuralNetAPI* net, size_t numberBufferSets = 1, size_t batchSize = 0);
     ~NeuralNetAPIUser();
     NeuralNetAPIUser(NeuralNetAPIUser&) = delete;
 
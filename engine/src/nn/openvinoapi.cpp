@@ -31,7 +31,8 @@
 OpenVinoAPI::OpenVinoAPI(int deviceID, unsigned int batchSize, const string &modelDirectory, size_t threadsNNInference):
     NeuralNetAPI("cpu", deviceID, batchSize, modelDirectory, true),
     rawInputData(nullptr),
-    threadsNNInference(threadsNNInference)
+    threadsNNInference(threadsNNInference),
+    dynamicBatch(false)
 {
     modelName = get_onnx_model_name(modelDir, batchSize);
     modelFilePath = modelDir + "/" + modelName;
@@ -64,7 +65,8 @@ void OpenVinoAPI::load_model()
     // load the model architecture
     model = core.read_model(modelFilePath);
     // set the batch size
-    if (model->is_dynamic()) {
+    dynamicBatch = model->is_dynamic();
+    if (dynamicBatch) {
         model->get_parameters()[nnDesign.inputIdx]->set_layout("NCHW");
         ov::set_batch(model, batchSize);
     }
@@ -72,6 +74,10 @@ void OpenVinoAPI::load_model()
 
 void OpenVinoAPI::load_parameters()
 {
+    if (dynamicBatch) {
+        // the network design has been inferred for the full batch size, allow all smaller batch sizes for inference
+        ov::set_batch(model, ov::Dimension(1, batchSize));
+    }
     // load the model to the device
     compiledModel = core.compile_model(model, "CPU", ov::inference_num_threads(threadsNNInference));
 }
@@ -92,10 +98,21 @@ void OpenVinoAPI::bind_executor()
     inferRequest.set_input_tensor(inputTensor);
 }
 
-void OpenVinoAPI::predict(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs)
+void OpenVinoAPI::predict(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs, size_t numberEntries)
 {
-    // copy over the input planes into the raw data cotainer
-    std::copy(inputPlanes, inputPlanes + batchSize * get_nb_input_values_total(), rawInputData);
+    if (dynamicBatch) {
+        const unsigned int inferenceBatchSize = get_inference_batch_size(numberEntries);
+        ov::Shape inputShape = inputTensor.get_shape();
+        if (inputShape[0] != inferenceBatchSize) {
+            // the tensor keeps the memory which has been allocated for the full batch size
+            inputShape[0] = inferenceBatchSize;
+            inputTensor.set_shape(inputShape);
+            rawInputData = (float*)inputTensor.data();
+            inferRequest.set_input_tensor(inputTensor);
+        }
+    }
+    // copy over the input planes into the raw data cotainer, the remaining entries aren't needed
+    std::copy(inputPlanes, inputPlanes + numberEntries * get_nb_input_values_total(), rawInputData);
 
     // run the request synchronously
     inferRequest.infer();
@@ -108,10 +125,10 @@ void OpenVinoAPI::predict(float *inputPlanes, float *valueOutput, float *probOut
     const float* outputBufferPolicy = (const float*)outputTensorPolicy.data();
 
     // copy the outputs to the given pointers
-    std::copy(outputBufferValue, outputBufferValue + batchSize, valueOutput);
-    std::copy(outputBufferPolicy, outputBufferPolicy + get_policy_output_length(), probOutputs);
+    std::copy(outputBufferValue, outputBufferValue + numberEntries, valueOutput);
+    std::copy(outputBufferPolicy, outputBufferPolicy + get_nb_policy_values() * numberEntries, probOutputs);
 
-    for (unsigned int batchIdx = 0; batchIdx < batchSize; ++batchIdx) {
+    for (unsigned int batchIdx = 0; batchIdx < numberEntries; ++batchIdx) {
         apply_softmax(probOutputs + batchIdx * nnDesign.policyOutputShape.v[1], nnDesign.policyOutputShape.v[1]);
     }
 }
@@ -52,6 +52,8 @@ private:
     ov::Tensor inputTensor;
     float* rawInputData;
     size_t threadsNNInference;
+    // true, if the model supports a dynamic batch dimension which allows to evaluate partially filled batches with a smaller batch size
+    bool dynamicBatch;
 public:
     OpenVinoAPI(int deviceID, unsigned int batchSize, const string &modelDirectory, size_t threadsNNInference);
 
@@ -65,7 +67,7 @@ private:
     // helper methods
     void set_nn_value_policy_shape();
 public:
-    void predict(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs) override;
+    void predict(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs, size_t numberEntries) override;
 };
 
 /**
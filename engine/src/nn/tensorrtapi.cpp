@@ -47,7 +47,9 @@ TensorrtAPI::TensorrtAPI(int deviceID, unsigned int batchSize, const string &mod
     idxPolicyOutput(nnDesign.policyOutputIdx + nnDesign.nbInputs),
     idxAuxiliaryOutput(nnDesign.auxiliaryOutputIdx + nnDesign.nbInputs),
     precision(str_to_precision(strPrecision)),
-    generatedTrtFromONNX(false)
+    generatedTrtFromONNX(false),
+    minBatchSize(batchSize),
+    boundBatchSize(batchSize)
 {
     // select the requested device
     cudaSetDevice(deviceID);
@@ -152,6 +154,8 @@ void TensorrtAPI::bind_executor()
     Dims inputDims;
     set_dims(inputDims, nnDesign.inputShape);
     context->setBindingDimensions(0, inputDims);
+    minBatchSize = engine->getProfileDimensions(idxInput, 0, OptProfileSelector::kMIN).d[0];
+    boundBatchSize = batchSize;
 
     // create buffers object with respect to the engine and batch size
     CHECK(cudaStreamCreate(&stream));
@@ -176,12 +180,20 @@ void TensorrtAPI::bind_executor()
     CHECK(cudaMalloc(&deviceMemory[idxPolicyOutput], memorySizes[idxPolicyOutput]));
 }
 
-void TensorrtAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs)
+void TensorrtAPI::predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs, size_t numberEntries)
 {
     // select the requested device
     cudaSetDevice(deviceID);
-    // copy input planes from host to device
-    CHECK(cudaMemcpyAsync(deviceMemory[idxInput], inputPlanes, memorySizes[idxInput],
+    const unsigned int inferenceBatchSize = max(minBatchSize, get_inference_batch_size(numberEntries));
+    if (inferenceBatchSize != boundBatchSize) {
+        Dims inputDims;
+        set_dims(inputDims, nnDesign.inputShape);
+        inputDims.d[0] = inferenceBatchSize;
+        context->setBindingDimensions(idxInput, inputDims);
+        boundBatchSize = inferenceBatchSize;
+    }
+    // copy input planes from host to device, the remaining entries aren't needed
+    CHECK(cudaMemcpyAsync(deviceMemory[idxInput], inputPlanes, memorySizes[idxInput] / batchSize * numberEntries,
                           cudaMemcpyHostToDevice, stream));
 
     // run inference for given data
@@ -189,16 +201,16 @@ void TensorrtAPI::predict(float* inputPlanes, float* valueOutput, float* probOut
 
     // copy output from device back to host
     CHECK(cudaMemcpyAsync(valueOutput, deviceMemory[idxValueOutput],
-                          memorySizes[idxValueOutput], cudaMemcpyDeviceToHost, stream));
+                          memorySizes[idxValueOutput] / batchSize * numberEntries, cudaMemcpyDeviceToHost, stream));
     CHECK(cudaMemcpyAsync(probOutputs, deviceMemory[idxPolicyOutput],
-                          memorySizes[idxPolicyOutput], cudaMemcpyDeviceToHost, stream));
+                          memorySizes[idxPolicyOutput] / batchSize * numberEntries, cudaMemcpyDeviceToHost, stream));
 #ifdef DYNAMIC_NN_ARCH
     if (has_auxiliary_outputs()) {
 #else
     if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
 #endif
         CHECK(cudaMemcpyAsync(auxiliaryOutputs, deviceMemory[idxAuxiliaryOutput],
-                              memorySizes[idxAuxiliaryOutput], cudaMemcpyDeviceToHost, stream));
+                              memorySizes[idxAuxiliaryOutput] / batchSize * numberEntries, cudaMemcpyDeviceToHost, stream));
     }
     cudaStreamSynchronize(stream);
 }
@@ -237,8 +249,10 @@ ICudaEngine* TensorrtAPI::create_cuda_engine_from_onnx()
     IOptimizationProfile* profile = builder->createOptimizationProfile();
 
     Dims inputDims = network->getInput(0)->getDimensions();
-    inputDims.d[0] = batchSize;
+    // a dynamic batch dimension allows to evaluate partially filled batches with a smaller batch size
+    inputDims.d[0] = inputDims.d[0] == -1 ? 1 : batchSize;
     profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kMIN, inputDims);
+    inputDims.d[0] = batchSize;
     profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kOPT, inputDims);
     profile->setDimensions(nnDesign.inputLayerName.c_str(), OptProfileSelector::kMAX, inputDims);
     config->addOptimizationProfile(profile);
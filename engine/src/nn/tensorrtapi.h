@@ -79,6 +79,10 @@ private:
     SampleUniquePtr<nvinfer1::IExecutionContext> context;
     cudaStream_t stream;
     bool generatedTrtFromONNX;
+    // smallest batch size of the optimization profile, equals batchSize for engines with a static batch dimension
+    unsigned int minBatchSize;
+    // batch size which is currently bound to the execution context
+    unsigned int boundBatchSize;
 public:
     /**
      * @brief TensorrtAPI
@@ -91,7 +95,7 @@ public:
     TensorrtAPI(int deviceID, unsigned int batchSize, const string& modelDirectory, const string& strPrecision);
     ~TensorrtAPI();
 
-    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs) override;
+    void predict(float* inputPlanes, float* valueOutput, float* probOutputs, float* auxiliaryOutputs, size_t numberEntries) override;
 
     /**
      * @brief retrieve_indices_by_name Sets the layer name indices by names.
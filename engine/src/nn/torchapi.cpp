@@ -42,8 +42,9 @@ TorchAPI::TorchAPI(const string& ctx, int deviceID, unsigned int miniBatchSize,
     initialize();
 }
 
-void TorchAPI::predict(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs)
+void TorchAPI::predict(float *inputPlanes, float *valueOutput, float *probOutputs, float *auxiliaryOutputs, size_t numberEntries)
 {
+    // the traced module is exported for a constant batch size, so only the copies are restricted to the filled entries
     // Create a vector of inputs.
     std::vector<torch::jit::IValue> inputs = {torch::from_blob(inputPlanes, {batchSize, StateConstants::NB_CHANNELS_TOTAL(), StateConstants::BOARD_HEIGHT(), StateConstants::BOARD_WIDTH()}, device)};
 
@@ -51,16 +52,16 @@ void TorchAPI::predict(float *inputPlanes, float *valueOutput, float *probOutput
     auto output = module.forward(inputs).toList();
 
     const float* torchValuePt = output.get(0).toTensor().data_ptr<float>();
-    std::copy(torchValuePt, torchValuePt+batchSize, valueOutput);
+    std::copy(torchValuePt, torchValuePt+numberEntries, valueOutput);
     const float* torchPolicyPt = torch::softmax(output.get(1).toTensor(), 1).data_ptr<float>();
-    std::copy(torchPolicyPt, torchPolicyPt+get_policy_output_length(), probOutputs);
+    std::copy(torchPolicyPt, torchPolicyPt+get_nb_policy_values()*numberEntries, probOutputs);
 #ifdef DYNAMIC_NN_ARCH
     if (has_auxiliary_outputs()) {
 #else
     if (StateConstants::NB_AUXILIARY_OUTPUTS()) {
 #endif
         const float* torchAuxiliaryPt = output.get(2).toTensor().data_ptr<float>();
-        std::copy(torchAuxiliaryPt, torchAuxiliaryPt+get_nb_auxiliary_outputs()*batchSize, auxiliaryOutputs);
+        std::copy(torchAuxiliaryPt, torchAuxiliaryPt+get_nb_auxiliary_outputs()*numberEntries, auxiliaryOutputs);
     }
 }
 
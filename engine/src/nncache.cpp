@@ -0,0 +1,116 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: nncache.cpp
+ * Created on 18.10.2026
+ * @author: queensgambit
+ */
+
+#include "nncache.h"
+#include <cstring>
+
+/**
+ * @brief compress_float Returns the upper 16 bits of the float representation (bfloat16)
+ */
+inline uint16_t compress_float(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(float));
+    return uint16_t(bits >> 16);
+}
+
+/**
+ * @brief decompress_float Inverse of compress_float()
+ */
+inline float decompress_float(uint16_t compressed)
+{
+    const uint32_t bits = uint32_t(compressed) << 16;
+    float value;
+    memcpy(&value, &bits, sizeof(float));
+    return value;
+}
+
+NNCache::NNCache(size_t sizeMB) :
+    sizeMB(0)
+{
+    resize(sizeMB);
+}
+
+Key NNCache::get_cache_key(Key key, SideToMove sideToMove) const
+{
+    return key ^ (Key(sideToMove) * 0x9E3779B97F4A7C15ULL);
+}
+
+bool NNCache::probe(Key key, SideToMove sideToMove, float& value, DynamicVector<float>& policy)
+{
+    if (entries.empty() || policy.size() > NN_CACHE_MAX_MOVES) {
+        return false;
+    }
+    const Key cacheKey = get_cache_key(key, sideToMove);
+    const size_t entryIdx = cacheKey % entries.size();
+    const Entry& entry = entries[entryIdx];
+    lock_guard<mutex> lock(locks[entryIdx & (NN_CACHE_NUMBER_LOCKS - 1)].mtx);
+    if (entry.key != cacheKey || entry.numberMoves != policy.size()) {
+        return false;
+    }
+    value = entry.value;
+    for (size_t idx = 0; idx < policy.size(); ++idx) {
+        policy[idx] = decompress_float(entry.policy[idx]);
+    }
+    return true;
+}
+
+void NNCache::store(Key key, SideToMove sideToMove, float value, const DynamicVector<float>& policy)
+{
+    if (entries.empty() || policy.size() > NN_CACHE_MAX_MOVES) {
+        return;
+    }
+    const Key cacheKey = get_cache_key(key, sideToMove);
+    const size_t entryIdx = cacheKey % entries.size();
+    Entry& entry = entries[entryIdx];
+    lock_guard<mutex> lock(locks[entryIdx & (NN_CACHE_NUMBER_LOCKS - 1)].mtx);
+    entry.key = cacheKey;
+    entry.value = value;
+    entry.numberMoves = uint16_t(policy.size());
+    for (size_t idx = 0; idx < policy.size(); ++idx) {
+        entry.policy[idx] = compress_float(policy[idx]);
+    }
+}
+
+void NNCache::resize(size_t sizeMB)
+{
+    if (this->sizeMB == sizeMB) {
+        return;
+    }
+    this->sizeMB = sizeMB;
+    entries.clear();
+    entries.shrink_to_fit();
+    // every entry starts with an invalid number of moves, so that the zero key doesn't match
+    Entry emptyEntry;
+    emptyEntry.key = 0;
+    emptyEntry.value = 0;
+    emptyEntry.numberMoves = NN_CACHE_MAX_MOVES + 1;
+    entries.resize(sizeMB * 1024 * 1024 / sizeof(Entry), emptyEntry);
+}
+
+bool NNCache::is_enabled() const
+{
+    return !entries.empty();
+}
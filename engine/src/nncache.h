@@ -0,0 +1,112 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: nncache.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Thread safe cache of a fixed memory size for neural network evaluations which is kept across moves and games.
+ * Each entry stores the value and the policy of all legal moves for a position. The policy is stored with 16 bit
+ * precision (the upper half of the float representation). The cache is direct-mapped, i.e. a new entry always
+ * replaces the previous entry in its slot.
+ */
+
+#ifndef NNCACHE_H
+#define NNCACHE_H
+
+#include <mutex>
+#include <vector>
+#include <blaze/Math.h>
+#include "stateobj.h"
+
+using blaze::DynamicVector;
+using namespace std;
+
+// number of lock stripes as a power of two
+#define NN_CACHE_LOCK_BITS 10
+#define NN_CACHE_NUMBER_LOCKS (1 << NN_CACHE_LOCK_BITS)
+// positions with more legal moves are not cached
+#define NN_CACHE_MAX_MOVES 120
+
+class NNCache
+{
+private:
+    struct Entry {
+        Key key;
+        float value;
+        uint16_t numberMoves;
+        uint16_t policy[NN_CACHE_MAX_MOVES];
+    };
+    // each lock is padded to a full cache line to avoid false sharing between the mutexes
+    struct PaddedMutex {
+        mutex mtx;
+        char padding[64];
+    };
+    vector<Entry> entries;
+    PaddedMutex locks[NN_CACHE_NUMBER_LOCKS];
+    size_t sizeMB;
+
+    /**
+     * @brief get_cache_key Combines the hash key of the position with the side to move
+     */
+    Key get_cache_key(Key key, SideToMove sideToMove) const;
+
+public:
+    /**
+     * @brief NNCache
+     * @param sizeMB Memory size of the cache in mega bytes, 0 disables the cache
+     */
+    NNCache(size_t sizeMB);
+    NNCache(const NNCache&) = delete;
+    NNCache& operator=(const NNCache&) = delete;
+
+    /**
+     * @brief probe Looks up the evaluation for the given position
+     * @param key Hash key of the position
+     * @param sideToMove Side to move of the position
+     * @param value Return value for the value evaluation
+     * @param policy Return value for the policy of all legal moves, its size must equal the number of legal moves
+     * @return True, if the position was found
+     */
+    bool probe(Key key, SideToMove sideToMove, float& value, DynamicVector<float>& policy);
+
+    /**
+     * @brief store Adds the evaluation for the given position
+     * @param key Hash key of the position
+     * @param sideToMove Side to move of the position
+     * @param value Value evaluation
+     * @param policy Policy of all legal moves
+     */
+    void store(Key key, SideToMove sideToMove, float value, const DynamicVector<float>& policy);
+
+    /**
+     * @brief resize Reallocates the cache for the given memory size if it differs from the current size. All entries are removed in this case.
+     * Must not be called during search.
+     * @param sizeMB Memory size of the cache in mega bytes, 0 disables the cache
+     */
+    void resize(size_t sizeMB);
+
+    /**
+     * @brief is_enabled Returns true if the cache has a non-zero size
+     */
+    bool is_enabled() const;
+};
+
+#endif // NNCACHE_H
@@ -26,9 +26,12 @@
 #include "node.h"
 #include <limits.h>
 #include "util/blazeutil.h" // get_dirichlet_noise()
+#include "util/poolallocator.h"
+#include "util/selectionkernel.h"
 #include "constants.h"
 #include "../util/communication.h"
 #include "evalinfo.h"
+#include "rootpartitioner.h"
 
 
 bool Node::is_sorted() const
@@ -43,12 +46,13 @@ double Node::get_q_sum_virtual_loss(ChildIdx childIdx) const
 
 bool Node::is_transposition() const
 {
-    return numberParentNodes != 1;
+    // it's also read by lock-free selections
+    return atomic_load(numberParentNodes) != 1;
 }
 
 void Node::decrement_number_parents()
 {
-    --numberParentNodes;
+    atomic_decrement(numberParentNodes);
 }
 
 uint8_t Node::get_virtual_loss_counter(ChildIdx childIdx) const
@@ -59,7 +63,7 @@ uint8_t Node::get_virtual_loss_counter(ChildIdx childIdx) const
 bool Node::has_transposition_child_node()
 {
     for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-        const Node* childNode = it->get();
+        const Node* childNode = *it;
         if (childNode != nullptr && childNode->is_transposition()) {
             return true;
         }
@@ -79,8 +83,7 @@ void Node::set_auxiliary_outputs(const float* auxiliaryOutputs)
 }
 #endif
 
-Node::Node(StateObj* state, const SearchSettings* searchSettings) :
-    legalActions(state->legal_actions()),
+Node::Node(StateObj* state) :
     key(state->hash_key()),
     valueSum(0),
     d(nullptr),
@@ -88,14 +91,23 @@ Node::Node(StateObj* state, const SearchSettings* searchSettings) :
     state(state),
 #endif
     realVisitsSum(0),
+    referenceCount(1),
     pliesFromNull(state->steps_from_null()),
     numberParentNodes(1),
     isTerminal(false),
     isTablebase(false),
-    hasNNResults(false),
-    sorted(false)
+    expansionState(EXPANSION_PENDING),
+    sorted(false),
+    lockFreeSelection(false)
 {
+    add_tree_memory(get_memory_size());
+}
+
+void Node::expand(StateObj* state, const SearchSettings* searchSettings)
+{
+    const size_t shellMemory = get_memory_size();
     // specify the number of direct child nodes of this node
+    legalActions = state->legal_actions();
     check_for_terminal(state);
 #ifdef MCTS_TB_SUPPORT
     if (searchSettings->useTablebase && !isTerminal) {
@@ -103,6 +115,13 @@ Node::Node(StateObj* state, const SearchSettings* searchSettings) :
     }
 #endif
     policyProbSmall.resize(legalActions.size());
+    add_tree_memory(get_memory_size() - shellMemory);
+    expansionState.store(EXPANDED, memory_order_release);
+}
+
+bool Node::is_expanded() const
+{
+    return expansionState.load(memory_order_acquire) != EXPANSION_PENDING;
 }
 
 bool Node::solved_win(const Node* childNode, const SearchSettings* searchSettings) const
@@ -138,7 +157,7 @@ bool Node::at_least_one_drawn_child() const
 {
     bool atLeastOneDrawnChild = false;
     for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-        const Node* childNode = it->get();
+        const Node* childNode = *it;
         if (!childNode->is_playout_node() || (childNode->d->nodeType != DRAW && childNode->d->nodeType != WIN)) {
             return false;
         }
@@ -267,7 +286,7 @@ void Node::define_end_ply_for_solved_terminal(const Node* childNode)
     if (d->nodeType == LOSS) {
         // choose the longest pv line
         for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-            const Node* curChildNode = it->get();
+            const Node* curChildNode = *it;
             if (curChildNode->d->endInPly + 1 > d->endInPly) {
                 d->endInPly = curChildNode->d->endInPly + 1;
             }
@@ -277,7 +296,7 @@ void Node::define_end_ply_for_solved_terminal(const Node* childNode)
     if (d->nodeType == DRAW) {
         // choose the shortest pv line for draws
         for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-            const Node* curChildNode = it->get();
+            const Node* curChildNode = *it;
             if (curChildNode->d->nodeType == DRAW && curChildNode->d->endInPly + 1 < d->endInPly) {
                 d->endInPly = curChildNode->d->endInPly + 1;
             }
@@ -301,7 +320,7 @@ void Node::mcts_policy_based_on_wins(DynamicVector<double>& mctsPolicy, const Se
     mctsPolicy = 0;
     ChildIdx childIdx = 0;
     for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-        const Node* childNode = it->get();
+        const Node* childNode = *it;
         if (childNode != nullptr && childNode->d != nullptr) {
             switch (searchSettings->searchPlayerMode) {
             case MODE_TWO_PLAYER:
@@ -326,7 +345,7 @@ void Node::mcts_policy_based_on_losses(DynamicVector<double>& mctsPolicy) const
     ChildIdx longestChildIdx = 0;
     size_t endInPly = 0;
     for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-        const Node* childNode = it->get();
+        const Node* childNode = *it;
         if (childNode != nullptr && childNode->d != nullptr) {
             if (childNode->d->endInPly > endInPly) {
                 endInPly = childNode->d->endInPly;
@@ -344,7 +363,7 @@ void Node::prune_losses_in_mcts_policy(DynamicVector<double>& mctsPolicy, const
     if (d->numberUnsolvedChildNodes != get_number_child_nodes() && !is_loss_node_type(d->nodeType)) {
         // set all entries which lead to a WIN of the opponent to zero
         for (size_t childIdx = 0; childIdx < d->noVisitIdx; ++childIdx) {
-            const Node* childNode = d->childNodes[childIdx].get();
+            const Node* childNode = d->childNodes[childIdx];
             if (childNode != nullptr && childNode->is_playout_node()) {
                 switch (searchSettings->searchPlayerMode) {
                 case MODE_TWO_PLAYER:
@@ -364,7 +383,7 @@ void Node::prune_losses_in_mcts_policy(DynamicVector<double>& mctsPolicy, const
 
 bool Node::solve_for_terminal(ChildIdx childIdx, const SearchSettings* searchSettings)
 {
-    const Node* childNode = d->childNodes[childIdx].get();
+    const Node* childNode = d->childNodes[childIdx];
 
     if (!childNode->is_playout_node()) {
         return false;
@@ -419,7 +438,7 @@ bool Node::solve_for_terminal(ChildIdx childIdx, const SearchSettings* searchSet
     if (solved_win(childNode, searchSettings)) {
         d->nodeType = WIN;
         update_solved_terminal<WIN_VALUE>(childNode, childIdx);
-        d->checkmateIdx = childIdx;
+        as_atomic(d->checkmateIdx).store(childIdx, memory_order_relaxed);
         return true;
     }
     if (solved_loss(childNode, searchSettings)) {
@@ -459,6 +478,45 @@ bool Node::is_root_node() const
 
 Node::~Node()
 {
+    release_tree_memory(get_memory_size());
+}
+
+void* Node::operator new(size_t size)
+{
+    assert(size == sizeof(Node));
+    return PoolAllocator<Node>().allocate(1);
+}
+
+void Node::operator delete(void* ptr)
+{
+    PoolAllocator<Node>().deallocate(static_cast<Node*>(ptr), 1);
+}
+
+void Node::acquire_reference()
+{
+    referenceCount.fetch_add(1, memory_order_relaxed);
+}
+
+bool Node::try_acquire_reference()
+{
+    uint32_t count = referenceCount.load(memory_order_relaxed);
+    while (count != 0) {
+        if (referenceCount.compare_exchange_weak(count, count + 1, memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool Node::release_reference()
+{
+    return referenceCount.fetch_sub(1, memory_order_acq_rel) == 1;
+}
+
+bool Node::try_release_last_reference()
+{
+    uint32_t count = 1;
+    return referenceCount.compare_exchange_strong(count, 0, memory_order_acq_rel);
 }
 
 void Node::sort_moves_by_probabilities()
@@ -466,9 +524,33 @@ void Node::sort_moves_by_probabilities()
     auto p = sort_permutation(policyProbSmall, std::greater<float>());
     apply_permutation_in_place(policyProbSmall, p);
     apply_permutation_in_place(legalActions, p);
+    if (d != nullptr) {
+        d->sortedIdx = legalActions.size();
+    }
     sorted = true;
 }
 
+void Node::sort_moves_up_to(size_t childIdx)
+{
+    const size_t numberChildNodes = get_number_child_nodes();
+    if (childIdx < d->sortedIdx || d->sortedIdx >= numberChildNodes) {
+        return;
+    }
+    // the chunk size doubles each time to keep the total costs at O(n log n) for nodes which reveal all their moves
+    const size_t sortEnd = min(numberChildNodes, max(childIdx + 1, max(size_t(PRESERVED_ITEMS), size_t(2 * d->sortedIdx))));
+    vector<pair<float, Action>> moves(numberChildNodes - d->sortedIdx);
+    for (size_t idx = d->sortedIdx; idx < numberChildNodes; ++idx) {
+        moves[idx - d->sortedIdx] = make_pair(policyProbSmall[idx], legalActions[idx]);
+    }
+    partial_sort(moves.begin(), moves.begin() + (sortEnd - d->sortedIdx), moves.end(),
+                 [](const pair<float, Action>& lhs, const pair<float, Action>& rhs) { return lhs.first > rhs.first; });
+    for (size_t idx = d->sortedIdx; idx < numberChildNodes; ++idx) {
+        policyProbSmall[idx] = moves[idx - d->sortedIdx].first;
+        legalActions[idx] = moves[idx - d->sortedIdx].second;
+    }
+    d->sortedIdx = sortEnd;
+}
+
 Action Node::get_action(ChildIdx childIdx) const
 {
     return legalActions[childIdx];
@@ -476,20 +558,40 @@ Action Node::get_action(ChildIdx childIdx) const
 
 Node* Node::get_child_node(ChildIdx childIdx) const
 {
-    return d->childNodes[childIdx].get();
+    return as_atomic(d->childNodes[childIdx]).load(memory_order_acquire);
+}
+
+Node* Node::detach_child_node(ChildIdx childIdx)
+{
+    return as_atomic(d->childNodes[childIdx]).exchange(nullptr, memory_order_acq_rel);
+}
+
+void Node::detach_child_nodes(vector<Node*>& childNodes)
+{
+    for (Node*& childNode : d->childNodes) {
+        Node* detachedNode = as_atomic(childNode).exchange(nullptr, memory_order_acq_rel);
+        if (detachedNode != nullptr) {
+            childNodes.emplace_back(detachedNode);
+        }
+    }
 }
 
-shared_ptr<Node> Node::get_child_node_shared(ChildIdx childIdx) const
+size_t Node::get_memory_size() const
 {
-    return d->childNodes[childIdx];
+    return sizeof(Node) + legalActions.size() * (sizeof(Action) + sizeof(float));
 }
 
-vector<shared_ptr<Node>>::const_iterator Node::get_node_it_begin() const
+size_t Node::get_total_memory_size() const
+{
+    return get_memory_size() + (d == nullptr ? 0 : d->get_memory_size());
+}
+
+vector<Node*>::const_iterator Node::get_node_it_begin() const
 {
     return d->childNodes.begin();
 }
 
-vector<shared_ptr<Node>>::const_iterator Node::get_node_it_end() const
+vector<Node*>::const_iterator Node::get_node_it_end() const
 {
     return d->childNodes.end();
 }
@@ -501,7 +603,7 @@ bool Node::is_terminal() const
 
 bool Node::has_nn_results() const
 {
-    return hasNNResults;
+    return expansionState.load(memory_order_acquire) == EVALUATED;
 }
 
 void Node::apply_virtual_loss_to_child(ChildIdx childIdx, const SearchSettings* searchSettings)
@@ -510,6 +612,20 @@ void Node::apply_virtual_loss_to_child(ChildIdx childIdx, const SearchSettings*
     // make it look like if one has lost X games from this node forward where X is the virtual loss value
     // temporarily reduce the attraction of this node by applying a virtual loss /
     // the effect of virtual loss will be undone if the playout is over
+    if (d->rootPartitioner != nullptr) {
+        d->rootPartitioner->apply_virtual_loss_to_child(childIdx);
+        return;
+    }
+    if (searchSettings->lockFreeUpdates) {
+        apply_virtual_loss_to_child_lock_free(childIdx, searchSettings);
+        return;
+    }
+    apply_virtual_loss_to_child_stats(childIdx, searchSettings);
+    ++d->visitSum;
+}
+
+void Node::apply_virtual_loss_to_child_stats(ChildIdx childIdx, const SearchSettings* searchSettings)
+{
     switch (get_virtual_style(searchSettings, d->childNumberVisits[childIdx])) {
     case VIRTUAL_LOSS:
         d->qValues[childIdx] = (double(d->qValues[childIdx]) * d->childNumberVisits[childIdx] - 1) / double(d->childNumberVisits[childIdx] + 1);
@@ -522,12 +638,132 @@ void Node::apply_virtual_loss_to_child(ChildIdx childIdx, const SearchSettings*
 
     // virtual increase the number of visits
     ++d->childNumberVisits[childIdx];
-    ++d->visitSum;
 
     // increment virtual loss counter
     update_virtual_loss_counter<true>(childIdx);
 }
 
+void Node::revert_virtual_loss_and_update_child_stats(ChildIdx childIdx, float value, const SearchSettings* searchSettings)
+{
+    if (d->childNumberVisits[childIdx] == 1) {
+        // set new Q-value based on return
+        // (the initialization of the Q-value was by Q_INIT which we don't want to recover.)
+        d->qValues[childIdx] = value;
+    }
+    else {
+        // revert virtual loss and update the Q-value
+        assert(d->childNumberVisits[childIdx] != 0);
+        uint_fast32_t childRealVisit;
+        double newQVal;
+        switch (get_virtual_style(searchSettings, d->childNumberVisits[childIdx])) {
+        case VIRTUAL_LOSS:
+            d->qValues[childIdx] = (double(d->qValues[childIdx]) * d->childNumberVisits[childIdx] + 1 + value) / d->childNumberVisits[childIdx];
+            break;
+        case VIRTUAL_VISIT:
+            childRealVisit = get_real_visits(childIdx);
+            d->qValues[childIdx] = (double(d->qValues[childIdx]) * childRealVisit + value) / (childRealVisit + 1);
+            break;
+        case VIRTUAL_OFFSET:
+            childRealVisit = get_real_visits(childIdx);
+            newQVal = double(d->qValues[childIdx]) + d->virtualLossCounter[childIdx] * searchSettings->virtualOffsetStrenght;
+            newQVal = (newQVal * childRealVisit + value) / (childRealVisit + 1.0);
+            d->qValues[childIdx] = newQVal - ((d->virtualLossCounter[childIdx] - 1) * searchSettings->virtualOffsetStrenght);
+        case VIRTUAL_MIX:;
+            // unreachable
+        }
+
+        assert(!isnan(d->qValues[childIdx]));
+    }
+
+    // decrement virtual loss counter
+    update_virtual_loss_counter<false>(childIdx);
+}
+
+bool Node::has_locked_updates(const SearchSettings* searchSettings) const
+{
+    return !searchSettings->lockFreeUpdates && d->rootPartitioner == nullptr;
+}
+
+void Node::revert_virtual_losses_and_update(ChildIdx childIdx, uint32_t visits, double visitValueSum, const SearchSettings* searchSettings, bool freeBackup)
+{
+    valueSum += visitValueSum;
+    realVisitsSum += visits;
+
+    if (d->childNumberVisits[childIdx] == 1) {
+        // set new Q-value based on return
+        d->qValues[childIdx] = visitValueSum;
+    }
+    else {
+        // the visit count of the child stays constant while the visits are backed up one by one,
+        // so the sequential updates can be expressed by a single update based on the sum of their values
+        assert(d->virtualLossCounter[childIdx] >= visits);
+        const uint_fast32_t childRealVisit = get_real_visits(childIdx);
+        double newQVal;
+        switch (get_virtual_style(searchSettings, d->childNumberVisits[childIdx])) {
+        case VIRTUAL_LOSS:
+            d->qValues[childIdx] = (double(d->qValues[childIdx]) * d->childNumberVisits[childIdx] + visits + visitValueSum) / d->childNumberVisits[childIdx];
+            break;
+        case VIRTUAL_VISIT:
+            d->qValues[childIdx] = (double(d->qValues[childIdx]) * childRealVisit + visitValueSum) / (childRealVisit + visits);
+            break;
+        case VIRTUAL_OFFSET:
+            newQVal = double(d->qValues[childIdx]) + d->virtualLossCounter[childIdx] * searchSettings->virtualOffsetStrenght;
+            newQVal = (newQVal * childRealVisit + visitValueSum) / (childRealVisit + visits);
+            d->qValues[childIdx] = newQVal - ((d->virtualLossCounter[childIdx] - visits) * searchSettings->virtualOffsetStrenght);
+        case VIRTUAL_MIX:;
+            // unreachable
+        }
+        assert(!isnan(d->qValues[childIdx]));
+    }
+    d->virtualLossCounter[childIdx] -= visits;
+    if (freeBackup) {
+        d->freeVisits += visits;
+    }
+}
+
+void Node::revert_virtual_loss_of_child_stats(ChildIdx childIdx, const SearchSettings* searchSettings)
+{
+    switch (get_virtual_style(searchSettings, d->childNumberVisits[childIdx])) {
+    case VIRTUAL_LOSS:
+        d->qValues[childIdx] = (double(d->qValues[childIdx]) * d->childNumberVisits[childIdx] + 1) / (d->childNumberVisits[childIdx] - 1);
+        break;
+    case VIRTUAL_OFFSET:
+        d->qValues[childIdx] += searchSettings->virtualOffsetStrenght;
+    case VIRTUAL_MIX:; // ignore
+    case VIRTUAL_VISIT:; // ignore
+    }
+    --d->childNumberVisits[childIdx];
+
+    // decrement virtual loss counter
+    update_virtual_loss_counter<false>(childIdx);
+}
+
+void Node::revert_virtual_loss_and_update_partitioned(ChildIdx childIdx, float value, const SearchSettings* searchSettings, bool freeBackup, bool solveForTerminal)
+{
+    d->rootPartitioner->revert_virtual_loss_and_update(childIdx, value, freeBackup);
+    if (solveForTerminal) {
+        // the solver reads the statistics of all root child nodes which are guarded by the partitions
+        lock();
+        d->rootPartitioner->lock_partitions();
+        solve_for_terminal(childIdx, searchSettings);
+        d->rootPartitioner->unlock_partitions();
+        unlock();
+    }
+}
+
+void Node::merge_stats(int32_t visits, uint32_t realVisits, double value, uint32_t freeVisits)
+{
+    d->visitSum += visits;
+    realVisitsSum += realVisits;
+    valueSum += value;
+    d->freeVisits += freeVisits;
+}
+
+void Node::set_root_partitioner(RootPartitioner* rootPartitioner)
+{
+    d->rootPartitioner = rootPartitioner;
+}
+
 float Node::get_q_value(ChildIdx childIdx) const
 {
     return d->qValues[childIdx];
@@ -561,22 +797,20 @@ vector<ChildIdx> Node::get_q_idx_over_thresh(float qThresh)
 
 void Node::reserve_full_memory()
 {
-    const size_t numberChildNodes = get_number_child_nodes();
-    d->childNumberVisits.reserve(numberChildNodes);
-    d->qValues.reserve(numberChildNodes);
-    d->childNodes.reserve(numberChildNodes);
-    d->virtualLossCounter.reserve(numberChildNodes);
-    d->nodeTypes.reserve(numberChildNodes);
+    d->reserve_child_stats(get_number_child_nodes());
 }
 
 void Node::increment_no_visit_idx()
 {
     if (d->noVisitIdx < get_number_child_nodes()) {
-        ++d->noVisitIdx;
-        if (d->noVisitIdx == PRESERVED_ITEMS) {
+        // the newly revealed move must be the best one of the remaining moves
+        sort_moves_up_to(d->noVisitIdx);
+        if (d->noVisitIdx + 1 == PRESERVED_ITEMS) {
             reserve_full_memory();
         }
         d->add_empty_node();
+        // the statistics of the new child are initialized before lock-free selections can see it
+        as_atomic(d->noVisitIdx).store(d->noVisitIdx + 1, memory_order_release);
     }
 }
 
@@ -587,7 +821,7 @@ void Node::fully_expand_node()
         for (size_t idx = d->noVisitIdx; idx < get_number_child_nodes(); ++idx) {
             d->add_empty_node();
         }
-        d->noVisitIdx = get_number_child_nodes();
+        as_atomic(d->noVisitIdx).store(uint16_t(get_number_child_nodes()), memory_order_release);
         // keep this exact order
         sorted = true;
     }
@@ -612,6 +846,72 @@ float Node::get_value_display() const
     return valueSum / realVisitsSum;
 }
 
+void Node::apply_virtual_loss_to_child_lock_free(ChildIdx childIdx, const SearchSettings* searchSettings)
+{
+    if (!lockFreeSelection.load(memory_order_relaxed)) {
+        // this is only reached while holding the node lock: the statistics of this node may be updated by lock-free backups
+        // from now on, so the per-child memory must not be reallocated anymore
+        reserve_full_memory();
+        // the node may now be selected without its lock, see select_child_node_lock_free()
+        lockFreeSelection.store(sorted, memory_order_release);
+    }
+    float* qValues = d->q_values_memory();
+
+    // claim the visit first, so that concurrent virtual losses on the same child use distinct visit counts
+    const uint32_t childVisits = atomic_increment(d->child_number_visits_memory()[childIdx]);
+    atomic_increment(d->visitSum);
+    atomic_increment(d->virtual_loss_counter_memory()[childIdx]);
+
+    switch (get_virtual_style(searchSettings, childVisits)) {
+    case VIRTUAL_LOSS:
+        atomic_update(qValues[childIdx], [childVisits](float qValue) {
+            return float((double(qValue) * childVisits - 1) / double(childVisits + 1)); });
+        break;
+    case VIRTUAL_OFFSET:
+        atomic_add(qValues[childIdx], -float(searchSettings->virtualOffsetStrenght));
+    case VIRTUAL_VISIT:;  // ignore
+    case VIRTUAL_MIX:;  // unreachable
+    }
+}
+
+void Node::revert_virtual_loss_and_update_lock_free(ChildIdx childIdx, float value, const SearchSettings* searchSettings)
+{
+    atomic_add(valueSum, double(value));
+    atomic_increment(realVisitsSum);
+
+    float* qValues = d->q_values_memory();
+    // claim the real visit by removing the virtual loss
+    const uint32_t childVisits = atomic_load(d->child_number_visits_memory()[childIdx]);
+    const uint8_t virtualLosses = atomic_decrement(d->virtual_loss_counter_memory()[childIdx]);
+    assert(virtualLosses != 0);
+    const uint_fast32_t childRealVisit = childVisits - virtualLosses;
+
+    if (childVisits == 1) {
+        // set new Q-value based on return
+        // (the initialization of the Q-value was by Q_INIT which we don't want to recover.)
+        as_atomic(qValues[childIdx]).store(value, std::memory_order_relaxed);
+        return;
+    }
+    const double offset = searchSettings->virtualOffsetStrenght;
+    switch (get_virtual_style(searchSettings, childVisits)) {
+    case VIRTUAL_LOSS:
+        atomic_update(qValues[childIdx], [childVisits, value](float qValue) {
+            return float((double(qValue) * childVisits + 1 + value) / childVisits); });
+        break;
+    case VIRTUAL_VISIT:
+        atomic_update(qValues[childIdx], [childRealVisit, value](float qValue) {
+            return float((double(qValue) * childRealVisit + value) / (childRealVisit + 1)); });
+        break;
+    case VIRTUAL_OFFSET:
+        atomic_update(qValues[childIdx], [childRealVisit, virtualLosses, offset, value](float qValue) {
+            const double newQVal = double(qValue) + virtualLosses * offset;
+            return float((newQVal * childRealVisit + value) / (childRealVisit + 1.0) - (virtualLosses - 1) * offset); });
+    case VIRTUAL_MIX:;
+        // unreachable
+    }
+    assert(!isnan(atomic_load(qValues[childIdx])));
+}
+
 double Node::get_value_sum() const
 {
     return valueSum;
@@ -634,10 +934,12 @@ size_t Node::get_number_child_nodes() const
 
 void Node::prepare_node_for_visits()
 {
-    sort_moves_by_probabilities();
     if (d == nullptr) {  // mark_tablebase() initializes the NodeData
         init_node_data();
     }
+    // only the first moves are sorted, the remaining ones are sorted when they are revealed
+    sort_moves_up_to(d->noVisitIdx - 1);
+    sorted = true;
 #ifdef MCTS_STORE_STATES
     state->prepare_action();
 #endif
@@ -661,21 +963,30 @@ void backup_collision(const SearchSettings* searchSettings, const Trajectory& tr
 
 void Node::revert_virtual_loss(ChildIdx childIdx, const SearchSettings* searchSettings)
 {
-    lock();
-    switch (get_virtual_style(searchSettings, d->childNumberVisits[childIdx])) {
-    case VIRTUAL_LOSS:
-        d->qValues[childIdx] = (double(d->qValues[childIdx]) * d->childNumberVisits[childIdx] + 1) / (d->childNumberVisits[childIdx] - 1);
-        break;
-    case VIRTUAL_OFFSET:
-        d->qValues[childIdx] += searchSettings->virtualOffsetStrenght;
-    case VIRTUAL_MIX:; // ignore
-    case VIRTUAL_VISIT:; // ignore
+    if (d->rootPartitioner != nullptr) {
+        d->rootPartitioner->revert_virtual_loss(childIdx);
+        return;
     }
-    --d->childNumberVisits[childIdx];
+    if (searchSettings->lockFreeUpdates) {
+        float* qValues = d->q_values_memory();
+        const uint32_t childVisits = atomic_decrement(d->child_number_visits_memory()[childIdx]);
+        atomic_decrement(d->visitSum);
+        atomic_decrement(d->virtual_loss_counter_memory()[childIdx]);
+        switch (get_virtual_style(searchSettings, childVisits)) {
+        case VIRTUAL_LOSS:
+            atomic_update(qValues[childIdx], [childVisits](float qValue) {
+                return float((double(qValue) * childVisits + 1) / (childVisits - 1)); });
+            break;
+        case VIRTUAL_OFFSET:
+            atomic_add(qValues[childIdx], float(searchSettings->virtualOffsetStrenght));
+        case VIRTUAL_MIX:; // ignore
+        case VIRTUAL_VISIT:; // ignore
+        }
+        return;
+    }
+    lock();
+    revert_virtual_loss_of_child_stats(childIdx, searchSettings);
     --d->visitSum;
-
-    // decrement virtual loss counter
-    update_virtual_loss_counter<false>(childIdx);
     unlock();
 }
 
@@ -720,51 +1031,44 @@ void Node::set_value(float value)
     this->valueSum = value * this->realVisitsSum;
 }
 
-Node* Node::add_new_node_to_tree(MapWithMutex* mapWithMutex, StateObj* newState, ChildIdx childIdx, const SearchSettings* searchSettings, bool& transposition)
+Node* Node::add_new_node_to_tree(TranspositionTable* transpositionTable, StateObj* newState, ChildIdx childIdx, const SearchSettings* searchSettings, bool& transposition)
 {
     if (searchSettings->useMCGS) {
-        mapWithMutex->mtx.lock();
-        HashMap::const_iterator it = mapWithMutex->hashTable.find(newState->hash_key());
-        if (it != mapWithMutex->hashTable.end()) {
-            shared_ptr<Node> transpositionNode = it->second.lock();
-            Node* tranpositionNode = get_child_node(childIdx);
-            if (tranpositionNode != nullptr) {
-                if (is_transposition_verified(tranpositionNode, newState)) {
-                    d->childNodes[childIdx] = atomic_load(&transpositionNode);
-                    mapWithMutex->mtx.unlock();
-                    tranpositionNode->lock();
-                    tranpositionNode->add_transposition_parent_node();
-                    tranpositionNode->unlock();
-                    switch (searchSettings->searchPlayerMode) {
-                    case MODE_TWO_PLAYER:
-                        if (tranpositionNode->is_playout_node() && tranpositionNode->get_node_type() == LOSS) {
-                            set_checkmate_idx(childIdx);
-                        }
-                    case MODE_SINGLE_PLAYER:;
+        Node* tranpositionNode = transpositionTable->find(newState->hash_key());
+        if (tranpositionNode != nullptr) {
+            // the node might be freed by the garbage collector of the former tree if it isn't referenced anymore
+            if (is_transposition_verified(tranpositionNode, newState) && tranpositionNode->try_acquire_reference()) {
+                as_atomic(d->childNodes[childIdx]).store(tranpositionNode, memory_order_release);
+                tranpositionNode->lock();
+                tranpositionNode->add_transposition_parent_node();
+                tranpositionNode->unlock();
+                switch (searchSettings->searchPlayerMode) {
+                case MODE_TWO_PLAYER:
+                    if (tranpositionNode->is_playout_node() && tranpositionNode->get_node_type() == LOSS) {
+                        set_checkmate_idx(childIdx);
                     }
-                    transposition = true;
-                    return tranpositionNode;
+                case MODE_SINGLE_PLAYER:;
                 }
+                transposition = true;
+                return tranpositionNode;
             }
         }
-        mapWithMutex->mtx.unlock();
     }
 
     // connect the Node to the parent
-    shared_ptr<Node> newNode = make_shared<Node>(newState, searchSettings);
-    atomic_store(&d->childNodes[childIdx], newNode);
+    // the shell is expanded by the caller after the lock of this node has been released
+    Node* newNode = new Node(newState);
+    as_atomic(d->childNodes[childIdx]).store(newNode, memory_order_release);
     if (searchSettings->useMCGS) {
-        mapWithMutex->mtx.lock();
-        mapWithMutex->hashTable.insert({ d->childNodes[childIdx]->hash_key(), d->childNodes[childIdx] });
-        mapWithMutex->mtx.unlock();
+        transpositionTable->insert(newNode->hash_key(), newNode);
     }
     transposition = false;
-    return d->childNodes[childIdx].get();
+    return newNode;
 }
 
 void Node::add_transposition_parent_node()
 {
-    ++numberParentNodes;
+    atomic_increment(numberParentNodes);
 }
 
 float Node::max_policy_prob()
@@ -832,7 +1136,7 @@ uint32_t Node::get_child_number_visits(ChildIdx childIdx) const
 
 void Node::enable_has_nn_results()
 {
-    hasNNResults = true;
+    expansionState.store(EVALUATED, memory_order_release);
 }
 
 uint16_t Node::plies_from_null() const
@@ -935,7 +1239,7 @@ void Node::mark_as_tablebase()
 
 void Node::make_to_root()
 {
-    numberParentNodes = 0;
+    as_atomic(numberParentNodes).store(0, memory_order_relaxed);
 }
 
 void Node::lock()
@@ -1063,9 +1367,14 @@ DynamicVector<float> Node::get_current_u_values(const SearchSettings* searchSett
 #endif
 }
 
+float Node::get_current_u_factor(const SearchSettings* searchSettings) const
+{
+    return get_current_cput(d->visitSum, searchSettings) * sqrt(float(d->visitSum));
+}
+
 Node* Node::get_child_node(ChildIdx childIdx)
 {
-    return d->childNodes[childIdx].get();
+    return as_atomic(d->childNodes[childIdx]).load(memory_order_acquire);
 }
 
 void Node::get_mcts_policy(DynamicVector<double>& mctsPolicy, ChildIdx& bestMoveIdx, const SearchSettings* searchSettings) const
@@ -1117,7 +1426,7 @@ void Node::get_principal_variation(vector<Action>& pv, const SearchSettings* sea
         size_t childIdx = get_best_action_index(curNode, true, searchSettings);
         pv.push_back(curNode->get_action(childIdx));
         curNode->unlock();
-        curNode = curNode->d->childNodes[childIdx].get();
+        curNode = curNode->d->childNodes[childIdx];
     }
 }
 
@@ -1160,11 +1469,96 @@ ChildIdx Node::select_child_node(const SearchSettings* searchSettings)
         return d->checkmateIdx;
     }
 
-    assert(sum(d->childNumberVisits) == d->visitSum);
     // find the move according to the q- and u-values for each move
     // calculate the current u values
     // it's not worth to save the u values as a node attribute because u is updated every time n_sum changes
+#ifdef SEARCH_UCT
+    assert(sum(d->childNumberVisits) == d->visitSum);
     return argmax(d->qValues + get_current_u_values(searchSettings));
+#else
+    if (searchSettings->lockFreeUpdates) {
+        // the statistics may be updated concurrently by lock-free backups
+        const float* qValues;
+        const uint32_t* childNumberVisits;
+        snapshot_child_stats(d->noVisitIdx, qValues, childNumberVisits);
+        const uint32_t visitSum = atomic_load(d->visitSum);
+        return argmax_q_plus_u(qValues, policyProbSmall.data(), childNumberVisits, d->noVisitIdx, get_current_cput(visitSum, searchSettings) * sqrt(float(visitSum)));
+    }
+    assert(sum(d->childNumberVisits) == d->visitSum);
+    return argmax_q_plus_u(d->qValues.data(), policyProbSmall.data(), d->childNumberVisits.data(), d->noVisitIdx, get_current_u_factor(searchSettings));
+#endif
+}
+
+bool Node::select_child_node_lock_free(const SearchSettings* searchSettings, ChildIdx& childIdx)
+{
+#ifdef SEARCH_UCT
+    return false;
+#else
+    if (!lockFreeSelection.load(memory_order_acquire)) {
+        return false;
+    }
+    const ChildIdx checkmateIdx = atomic_load(d->checkmateIdx);
+    if (checkmateIdx != NO_CHECKMATE) {
+        childIdx = checkmateIdx;
+        return true;
+    }
+    // the statistics of all revealed child nodes are initialized before noVisitIdx is published
+    const size_t noVisitIdx = as_atomic(d->noVisitIdx).load(memory_order_acquire);
+    if (noVisitIdx == 1) {
+        childIdx = 0;
+        return true;
+    }
+    const float* qValues;
+    const uint32_t* childNumberVisits;
+    snapshot_child_stats(noVisitIdx, qValues, childNumberVisits);
+    const uint32_t visitSum = atomic_load(d->visitSum);
+    childIdx = argmax_q_plus_u(qValues, policyProbSmall.data(), childNumberVisits, noVisitIdx, get_current_cput(visitSum, searchSettings) * sqrt(float(visitSum)));
+    // revealing the next child node changes the node structure and requires the lock
+    return childIdx + 1 != noVisitIdx || noVisitIdx == get_number_child_nodes();
+#endif
+}
+
+void Node::snapshot_child_stats(size_t noVisitIdx, const float*& qValues, const uint32_t*& childNumberVisits) const
+{
+    thread_local vector<float> qValuesSnapshot;
+    thread_local vector<uint32_t> childNumberVisitsSnapshot;
+    qValuesSnapshot.resize(noVisitIdx);
+    childNumberVisitsSnapshot.resize(noVisitIdx);
+    // the memory is fully reserved and won't be reallocated by lock-free backups
+    const float* qValuesMemory = d->q_values_memory();
+    const uint32_t* childNumberVisitsMemory = d->child_number_visits_memory();
+    for (size_t idx = 0; idx < noVisitIdx; ++idx) {
+        qValuesSnapshot[idx] = atomic_load(qValuesMemory[idx]);
+        childNumberVisitsSnapshot[idx] = atomic_load(childNumberVisitsMemory[idx]);
+    }
+    qValues = qValuesSnapshot.data();
+    childNumberVisits = childNumberVisitsSnapshot.data();
+}
+
+ChildIdx Node::select_child_node_in_partition(const vector<ChildIdx>& childIndices, uint32_t visitSum, const SearchSettings* searchSettings) const
+{
+    if (has_forced_win() && find(childIndices.begin(), childIndices.end(), d->checkmateIdx) != childIndices.end()) {
+        return d->checkmateIdx;
+    }
+#ifdef SEARCH_UCT
+    const float uFactor = searchSettings->cpuctInit * sqrt(log(float(visitSum)));
+#else
+    const float uFactor = get_current_cput(visitSum, searchSettings) * sqrt(float(visitSum));
+#endif
+    ChildIdx bestIdx = childIndices.front();
+    float bestScore = -numeric_limits<float>::infinity();
+    for (ChildIdx childIdx : childIndices) {
+#ifdef SEARCH_UCT
+        const float score = d->qValues[childIdx] + uFactor / (d->childNumberVisits[childIdx] + FLT_EPSILON);
+#else
+        const float score = d->qValues[childIdx] + uFactor * policyProbSmall[childIdx] / (float(d->childNumberVisits[childIdx]) + 1.0f);
+#endif
+        if (score > bestScore) {
+            bestScore = score;
+            bestIdx = childIdx;
+        }
+    }
+    return bestIdx;
 }
 
 NodeSplit Node::select_child_nodes(const SearchSettings* searchSettings, uint_fast16_t budget)
@@ -1183,11 +1577,28 @@ NodeSplit Node::select_child_nodes(const SearchSettings* searchSettings, uint_fa
         nodeSplit.only_first(d->checkmateIdx, budget);
         return nodeSplit;
     }
-    DynamicVector<float> q_u_sum = d->qValues + get_current_u_values(searchSettings);
     float firstMax;
     float secondMax;
-    assert(q_u_sum.size() > 1);
+    assert(d->noVisitIdx > 1);
+#ifdef SEARCH_UCT
+    DynamicVector<float> q_u_sum = d->qValues + get_current_u_values(searchSettings);
     first_and_second_max(q_u_sum, ChildIdx(d->noVisitIdx), firstMax, secondMax, nodeSplit.firstArg, nodeSplit.secondArg);
+#else
+    size_t firstArg;
+    size_t secondArg;
+    const float* qValues = d->qValues.data();
+    const uint32_t* childNumberVisits = d->childNumberVisits.data();
+    uint32_t visitSum = d->visitSum;
+    if (searchSettings->lockFreeUpdates) {
+        // the statistics may be updated concurrently by lock-free backups
+        snapshot_child_stats(d->noVisitIdx, qValues, childNumberVisits);
+        visitSum = atomic_load(d->visitSum);
+    }
+    first_and_second_argmax_q_plus_u(qValues, policyProbSmall.data(), childNumberVisits, d->noVisitIdx, get_current_cput(visitSum, searchSettings) * sqrt(float(visitSum)),
+                                     firstMax, secondMax, firstArg, secondArg);
+    nodeSplit.firstArg = firstArg;
+    nodeSplit.secondArg = secondArg;
+#endif
 
     float firstShare = 0.5 + std::min(float(firstMax - secondMax), 0.5f);
     nodeSplit.firstBudget = firstShare * budget + 0.5;  // rounding
@@ -1313,7 +1724,7 @@ bool Node::is_transposition_return(double myQvalue) const
 
 void Node::set_checkmate_idx(ChildIdx childIdx) const
 {
-    d->checkmateIdx = childIdx;
+    as_atomic(d->checkmateIdx).store(childIdx, memory_order_relaxed);
 }
 
 bool Node::was_inspected()
@@ -1331,6 +1742,103 @@ uint32_t Node::get_number_of_nodes() const
     return get_visits() - get_free_visits();
 }
 
+void Node::save_checkpoint(CheckpointNode& record, CheckpointMove* moves) const
+{
+    record.key = key;
+    record.valueSum = valueSum;
+    record.realVisitsSum = realVisitsSum;
+    record.numberMoves = get_number_child_nodes();
+    record.pliesFromNull = pliesFromNull;
+    record.flags = (isTerminal ? CHECKPOINT_TERMINAL : 0) | (isTablebase ? CHECKPOINT_TABLEBASE : 0) |
+                   (has_nn_results() ? CHECKPOINT_EVALUATED : 0) | (sorted ? CHECKPOINT_SORTED : 0);
+    record.visitSum = 0;
+    record.freeVisits = 0;
+    record.noVisitIdx = 0;
+    record.sortedIdx = 0;
+    record.checkmateIdx = NO_CHECKMATE;
+    record.endInPly = 0;
+    record.numberUnsolvedChildNodes = 0;
+    record.nodeType = UNSOLVED;
+    if (is_playout_node()) {
+        record.flags |= CHECKPOINT_PLAYOUT_NODE | (d->inspected ? CHECKPOINT_INSPECTED : 0);
+        record.visitSum = d->visitSum;
+        record.freeVisits = d->freeVisits;
+        record.noVisitIdx = d->noVisitIdx;
+        record.sortedIdx = d->sortedIdx;
+        record.checkmateIdx = d->checkmateIdx;
+        record.endInPly = d->endInPly;
+        record.numberUnsolvedChildNodes = d->numberUnsolvedChildNodes;
+        record.nodeType = d->nodeType;
+    }
+    for (size_t idx = 0; idx < get_number_child_nodes(); ++idx) {
+        CheckpointMove& move = moves[idx];
+        move.action = legalActions[idx];
+        move.prior = policyProbSmall[idx];
+        move.qValue = Q_INIT;
+        move.visits = 0;
+        move.childNode = NO_CHECKPOINT_CHILD;
+        move.nodeType = UNSOLVED;
+        if (idx < record.noVisitIdx) {
+            move.qValue = d->qValues[idx];
+            move.visits = d->childNumberVisits[idx];
+            move.nodeType = d->nodeTypes[idx];
+        }
+    }
+}
+
+void Node::load_checkpoint(const CheckpointNode& record, const CheckpointMove* moves)
+{
+    const size_t shellMemory = get_memory_size();
+    legalActions.resize(record.numberMoves);
+    policyProbSmall.resize(record.numberMoves);
+    for (size_t idx = 0; idx < record.numberMoves; ++idx) {
+        legalActions[idx] = moves[idx].action;
+        policyProbSmall[idx] = moves[idx].prior;
+    }
+    add_tree_memory(get_memory_size() - shellMemory);
+    valueSum = record.valueSum;
+    realVisitsSum = record.realVisitsSum;
+    isTerminal = record.flags & CHECKPOINT_TERMINAL;
+    isTablebase = record.flags & CHECKPOINT_TABLEBASE;
+    sorted = record.flags & CHECKPOINT_SORTED;
+
+    if (record.flags & CHECKPOINT_PLAYOUT_NODE) {
+        if (isTerminal) {
+            // terminal nodes don't reveal any child nodes, see mark_as_terminal()
+            d = make_unique<NodeData>();
+        }
+        else {
+            init_node_data();
+            if (record.noVisitIdx >= PRESERVED_ITEMS) {
+                reserve_full_memory();
+            }
+            for (size_t idx = 1; idx < record.noVisitIdx; ++idx) {
+                d->add_empty_node();
+            }
+        }
+        d->visitSum = record.visitSum;
+        d->freeVisits = record.freeVisits;
+        d->noVisitIdx = record.noVisitIdx;
+        d->sortedIdx = record.sortedIdx;
+        d->checkmateIdx = record.checkmateIdx;
+        d->endInPly = record.endInPly;
+        d->numberUnsolvedChildNodes = record.numberUnsolvedChildNodes;
+        d->nodeType = NodeType(record.nodeType);
+        d->inspected = record.flags & CHECKPOINT_INSPECTED;
+        for (size_t idx = 0; idx < record.noVisitIdx; ++idx) {
+            d->qValues[idx] = moves[idx].qValue;
+            d->childNumberVisits[idx] = moves[idx].visits;
+            d->nodeTypes[idx] = NodeType(moves[idx].nodeType);
+        }
+    }
+    expansionState.store(record.flags & CHECKPOINT_EVALUATED ? EVALUATED : EXPANDED, memory_order_release);
+}
+
+void Node::set_child_node(ChildIdx childIdx, Node* childNode)
+{
+    as_atomic(d->childNodes[childIdx]).store(childNode, memory_order_release);
+}
+
 bool is_terminal_value(float value)
 {
     return (value == WIN_VALUE || value == DRAW_VALUE || value == LOSS_VALUE);
@@ -1345,4 +1853,25 @@ bool is_transposition_verified(const Node* node, const StateObj* state) {
     return  node->has_nn_results() &&
         node->plies_from_null() == state->steps_from_null() &&
         state->number_repetitions() == 0;
-}
\ No newline at end of file
+}
+void release_node(Node* node, TranspositionTable* transpositionTable)
+{
+    vector<Node*> pendingNodes;
+    if (node != nullptr) {
+        pendingNodes.emplace_back(node);
+    }
+    while (!pendingNodes.empty()) {
+        Node* curNode = pendingNodes.back();
+        pendingNodes.pop_back();
+        if (!curNode->release_reference()) {
+            continue;
+        }
+        if (transpositionTable != nullptr) {
+            transpositionTable->erase(curNode->hash_key(), curNode);
+        }
+        if (curNode->is_playout_node()) {
+            curNode->detach_child_nodes(pendingNodes);
+        }
+        delete curNode;
+    }
+}
@@ -37,6 +37,9 @@
 
 #include "agents/config/searchsettings.h"
 #include "nodedata.h"
+#include "transpositiontable.h"
+#include "util/atomicutil.h"
+#include "treecheckpoint.h"
 
 
 using blaze::HybridVector;
@@ -52,14 +55,6 @@ struct NodeAndIdx {
         node(node), childIdx(childIdx) {}
 };
 using Trajectory = vector<NodeAndIdx>;
-using HashMap = unordered_map<Key, weak_ptr<Node>>;
-// wrapper for unordered_map with a mutex for thread safe access
-struct MapWithMutex {
-    mutex mtx;
-    HashMap hashTable;
-    ~MapWithMutex() {
-    }
-};
 
 
 struct NodeSplit {
@@ -94,6 +89,13 @@ inline VirtualStyle get_virtual_style(const SearchSettings* searchSettings, uint
     return searchSettings->virtualStyle;
 }
 
+// a node is created as a cheap shell, expanded by the creating thread and finally evaluated by the neural network
+enum ExpansionState : uint8_t {
+    EXPANSION_PENDING,
+    EXPANDED,
+    EVALUATED
+};
+
 class Node
 {
 private:
@@ -113,6 +115,8 @@ private:
 #endif
 
     uint32_t realVisitsSum;
+    // number of owners of this node (parent nodes, root pointers and the garbage collector)
+    atomic<uint32_t> referenceCount;
 
     // identifiers
     uint16_t pliesFromNull;
@@ -120,22 +124,89 @@ private:
     uint16_t numberParentNodes;
     bool isTerminal;
     bool isTablebase;
-    bool hasNNResults;
+    atomic<ExpansionState> expansionState;
     bool sorted;
+    // set once the child statistics are fully reserved and may be read without the node lock
+    atomic<bool> lockFreeSelection;
 
 public:
     /**
-     * @brief Node Primary constructor which is used when expanding a node during search
+     * @brief Node Primary constructor which creates a shell node which only holds the hash key.
+     * The node must be expanded by expand() before other threads may look at its child nodes or its terminal status.
      * @param State Corresponding state object
+     */
+    Node(StateObj* state);
+
+    /**
+     * @brief expand Generates the legal moves and checks if the node is a terminal or tablebase position.
+     * Afterwards, the node is marked as expanded.
+     * @param state Corresponding state object
      * @param searchSettings Pointer to the searchSettings
      */
-    Node(StateObj* state,
-        const SearchSettings* searchSettings);
+    void expand(StateObj* state, const SearchSettings* searchSettings);
 
     /**
-     * @brief ~Node Destructor which frees memory and the board position
+     * @brief is_expanded Returns false while the node is a shell which is still being expanded by its creating thread
+     */
+    bool is_expanded() const;
+
+    /**
+     * @brief save_checkpoint Writes the statistics of this node into a checkpoint record.
+     * The first move index of the record and the child node indices of the moves are filled in by the caller.
+     * @param record Node record
+     * @param moves Array of get_number_child_nodes() move records
+     */
+    void save_checkpoint(CheckpointNode& record, CheckpointMove* moves) const;
+
+    /**
+     * @brief load_checkpoint Restores the statistics of a newly created shell node from a checkpoint record.
+     * The child nodes are connected afterwards by set_child_node().
+     * @param record Node record
+     * @param moves Array of record.numberMoves move records
+     */
+    void load_checkpoint(const CheckpointNode& record, const CheckpointMove* moves);
+
+    /**
+     * @brief set_child_node Connects a child node to an already revealed child index. The reference of the child is handed over to this node.
+     * @param childIdx Child index
+     * @param childNode Child node
+     */
+    void set_child_node(ChildIdx childIdx, Node* childNode);
+
+    /**
+     * @brief ~Node Destructor which frees memory and the board position.
+     * The child nodes aren't released, use release_node() to free a node together with its subtree.
      */
     ~Node();
+    Node(const Node&) = delete;
+    Node& operator=(const Node&) = delete;
+
+    // nodes are served from a memory pool to avoid a heap allocation for every expansion
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
+
+    /**
+     * @brief acquire_reference Adds an owner to the node. The caller must already hold a reference.
+     */
+    void acquire_reference();
+
+    /**
+     * @brief try_acquire_reference Adds an owner to a node which was found without holding a reference, e.g. in the transposition table.
+     * @return False, if the last reference has already been released and the node is about to be freed
+     */
+    bool try_acquire_reference();
+
+    /**
+     * @brief release_reference Removes an owner from the node
+     * @return True, if this was the last reference and the caller is responsible for freeing the node
+     */
+    bool release_reference();
+
+    /**
+     * @brief try_release_last_reference Releases the reference of the caller only if it is the last one
+     * @return True, if the reference was released and the caller is responsible for freeing the node
+     */
+    bool try_release_last_reference();
 
     /**
      * @brief get_current_u_values Calucates and returns the current u-values for this node
@@ -143,6 +214,12 @@ public:
      */
     DynamicVector<float> get_current_u_values(const SearchSettings* searchSettings);
 
+    /**
+     * @brief get_current_u_factor Returns the factor of the exploration term which is shared by all child nodes: cpuct * sqrt(visits)
+     * @return float
+     */
+    float get_current_u_factor(const SearchSettings* searchSettings) const;
+
     /**
      * @brief get_child_node Returns the child node at the given index.
      * A nullptr is returned if the child node wasn't expanded yet and no check is done if the childIdx is smaller than
@@ -153,6 +230,24 @@ public:
 
     ChildIdx select_child_node(const SearchSettings* searchSettings);
 
+    /**
+     * @brief select_child_node_lock_free Selects the child node with the highest Q+U value without taking the node lock.
+     * This is only possible for nodes which are already updated lock-free and if the selection doesn't reveal a new child node.
+     * @param searchSettings Pointer to the search settings struct
+     * @param childIdx Selected child index
+     * @return true, if a child was selected; false, if the selection must be done with select_child_node() while holding the lock
+     */
+    bool select_child_node_lock_free(const SearchSettings* searchSettings, ChildIdx& childIdx);
+
+    /**
+     * @brief select_child_node_in_partition Selects the child node with the highest Q+U value among the given child indices
+     * @param childIndices Candidate child indices
+     * @param visitSum Visit sum which is used for the exploration term instead of the visit sum of this node
+     * @param searchSettings Pointer to the search settings struct
+     * @return Selected child index
+     */
+    ChildIdx select_child_node_in_partition(const vector<ChildIdx>& childIndices, uint32_t visitSum, const SearchSettings* searchSettings) const;
+
     /**
      * @brief select_child_nodes Selects multiple nodes at once
      * @param searchSettings Search settings struct
@@ -199,42 +294,27 @@ public:
     template<bool freeBackup>
     void revert_virtual_loss_and_update(ChildIdx childIdx, float value, const SearchSettings* searchSettings, bool solveForTerminal)
     {
-        lock();
-
-        valueSum += value;
-        ++realVisitsSum;
-
-        if (d->childNumberVisits[childIdx] == 1) {
-            // set new Q-value based on return
-            // (the initialization of the Q-value was by Q_INIT which we don't want to recover.)
-            d->qValues[childIdx] = value;
+        if (d->rootPartitioner != nullptr) {
+            revert_virtual_loss_and_update_partitioned(childIdx, value, searchSettings, freeBackup, solveForTerminal);
+            return;
         }
-        else {
-            // revert virtual loss and update the Q-value
-            assert(d->childNumberVisits[childIdx] != 0);
-            uint_fast32_t childRealVisit;
-            double newQVal;
-            switch (get_virtual_style(searchSettings, d->childNumberVisits[childIdx])) {
-            case VIRTUAL_LOSS:
-                d->qValues[childIdx] = (double(d->qValues[childIdx]) * d->childNumberVisits[childIdx] + 1 + value) / d->childNumberVisits[childIdx];
-                break;
-            case VIRTUAL_VISIT:
-                childRealVisit = get_real_visits(childIdx);
-                d->qValues[childIdx] = (double(d->qValues[childIdx]) * childRealVisit + value) / (childRealVisit + 1);
-                break;
-            case VIRTUAL_OFFSET:
-                newQVal = double(d->qValues[childIdx]) + d->virtualLossCounter[childIdx] * searchSettings->virtualOffsetStrenght;
-                newQVal = (newQVal * childRealVisit + value) / (childRealVisit + 1.0);
-                d->qValues[childIdx] = newQVal - ((d->virtualLossCounter[childIdx] - 1) * searchSettings->virtualOffsetStrenght);
-            case VIRTUAL_MIX:;
-                // unreachable
+        if (searchSettings->lockFreeUpdates) {
+            revert_virtual_loss_and_update_lock_free(childIdx, value, searchSettings);
+            if (freeBackup) {
+                atomic_increment(d->freeVisits);
             }
-
-            assert(!isnan(d->qValues[childIdx]));
+            if (solveForTerminal) {
+                lock();
+                solve_for_terminal(childIdx, searchSettings);
+                unlock();
+            }
+            return;
         }
+        lock();
 
-        // decrement virtual loss counter
-        update_virtual_loss_counter<false>(childIdx);
+        valueSum += value;
+        ++realVisitsSum;
+        revert_virtual_loss_and_update_child_stats(childIdx, value, searchSettings);
 
         if (freeBackup) {
             ++d->freeVisits;
@@ -245,12 +325,80 @@ public:
         unlock();
     }
 
+    /**
+     * @brief revert_virtual_loss_and_update_lock_free Lock-free version of revert_virtual_loss_and_update() which doesn't handle
+     * free visits and the terminal solver. The visit counters are claimed by atomic increments first and the Q-value is updated
+     * by a compare-and-swap loop based on the claimed counters. Concurrent updates of the same child node may therefore
+     * introduce a small averaging error, but all counters remain exact.
+     * @param childIdx Index to the child node to update
+     * @param value Specifies the value evaluation to backpropagate
+     * @param searchSettings Pointer to the search settings struct
+     */
+    void revert_virtual_loss_and_update_lock_free(ChildIdx childIdx, float value, const SearchSettings* searchSettings);
+
     /**
      * @brief revert_virtual_loss Reverts the virtual loss for a target node
      * @param childIdx Index to the child node to update
      */
     void revert_virtual_loss(ChildIdx childIdx, const SearchSettings* searchSettings);
 
+    /**
+     * @brief apply_virtual_loss_to_child_stats Applies a virtual loss to the statistics of the given child only.
+     * The visit sum of this node is left unchanged. The caller must guarantee exclusive access to the child statistics.
+     * @param childIdx Index to the child node to update
+     * @param searchSettings Pointer to the search settings struct
+     */
+    void apply_virtual_loss_to_child_stats(ChildIdx childIdx, const SearchSettings* searchSettings);
+
+    /**
+     * @brief revert_virtual_loss_and_update_child_stats Reverts the virtual loss of the given child and updates its Q-value by the given value.
+     * The value sum and visit counters of this node are left unchanged. The caller must guarantee exclusive access to the child statistics.
+     * @param childIdx Index to the child node to update
+     * @param value Specifies the value evaluation to backpropagate
+     * @param searchSettings Pointer to the search settings struct
+     */
+    void revert_virtual_loss_and_update_child_stats(ChildIdx childIdx, float value, const SearchSettings* searchSettings);
+
+    /**
+     * @brief has_locked_updates Returns true if the statistics of this node are updated while holding the node lock,
+     * false for lock-free updates and root nodes whose child statistics are updated by a root partitioner
+     */
+    bool has_locked_updates(const SearchSettings* searchSettings) const;
+
+    /**
+     * @brief revert_virtual_losses_and_update Reverts multiple virtual losses of the given child and updates its Q-value by the sum of their values at once.
+     * The result is the same as for the corresponding number of revert_virtual_loss_and_update() calls with the average value.
+     * Must be called while holding the node lock and only if has_locked_updates() is true.
+     * @param childIdx Index to the child node to update
+     * @param visits Number of visits to back up
+     * @param visitValueSum Sum of the values of all visits
+     * @param searchSettings Pointer to the search settings struct
+     * @param freeBackup True, if the visits are counted as free visits
+     */
+    void revert_virtual_losses_and_update(ChildIdx childIdx, uint32_t visits, double visitValueSum, const SearchSettings* searchSettings, bool freeBackup);
+
+    /**
+     * @brief revert_virtual_loss_of_child_stats Reverts the virtual loss of the given child only, the visit sum of this node is left unchanged.
+     * The caller must guarantee exclusive access to the child statistics.
+     * @param childIdx Index to the child node to update
+     * @param searchSettings Pointer to the search settings struct
+     */
+    void revert_virtual_loss_of_child_stats(ChildIdx childIdx, const SearchSettings* searchSettings);
+
+    /**
+     * @brief merge_stats Adds statistics of this node which have been collected elsewhere. Must be called while holding the node lock.
+     * @param visits Change of the visit sum including virtual visits
+     * @param realVisits Number of additional real visits
+     * @param value Sum of the additional value backups
+     * @param freeVisits Number of additional free visits
+     */
+    void merge_stats(int32_t visits, uint32_t realVisits, double value, uint32_t freeVisits);
+
+    /**
+     * @brief set_root_partitioner Hands the updates of the child statistics of this node over to the given partitioner (nullptr: regular updates)
+     */
+    void set_root_partitioner(RootPartitioner* rootPartitioner);
+
     bool is_playout_node() const;
 
     /**
@@ -263,10 +411,33 @@ public:
 
     Action get_action(ChildIdx childIdx) const;
     Node* get_child_node(ChildIdx childIdx) const;
-    shared_ptr<Node> get_child_node_shared(ChildIdx childIdx) const;
 
-    vector<shared_ptr<Node>>::const_iterator get_node_it_begin() const;
-    vector<shared_ptr<Node>>::const_iterator get_node_it_end() const;
+    /**
+     * @brief detach_child_node Disconnects the given child node from this node. The statistics of the child node are kept,
+     * so that a later selection of this child re-expands it as a new node.
+     * @param childIdx Child index
+     * @return Detached child node, the reference of this node is handed over to the caller
+     */
+    Node* detach_child_node(ChildIdx childIdx);
+
+    /**
+     * @brief detach_child_nodes Disconnects all expanded child nodes from this node and appends them to the given list
+     * @param childNodes List of detached child nodes, the references of this node are handed over to the caller
+     */
+    void detach_child_nodes(vector<Node*>& childNodes);
+
+    /**
+     * @brief get_memory_size Returns the estimated number of bytes of this node without its node data
+     */
+    size_t get_memory_size() const;
+
+    /**
+     * @brief get_total_memory_size Returns the estimated number of bytes of this node including its node data
+     */
+    size_t get_total_memory_size() const;
+
+    vector<Node*>::const_iterator get_node_it_begin() const;
+    vector<Node*>::const_iterator get_node_it_end() const;
 
 
     bool is_terminal() const;
@@ -285,6 +456,15 @@ public:
 
     void apply_virtual_loss_to_child(ChildIdx childIdx, const SearchSettings* searchSettings);
 
+    /**
+     * @brief apply_virtual_loss_to_child_lock_free Lock-free version of apply_virtual_loss_to_child().
+     * Reserves the full memory for all child nodes on the first call so that the statistics are never reallocated while other threads update them.
+     * The first call must be done while holding the node lock, later calls may follow select_child_node_lock_free() without it.
+     * @param childIdx Index to the child node to update
+     * @param searchSettings Pointer to the search settings struct
+     */
+    void apply_virtual_loss_to_child_lock_free(ChildIdx childIdx, const SearchSettings* searchSettings);
+
     void increment_no_visit_idx();
     void fully_expand_node();
 
@@ -299,6 +479,13 @@ public:
      */
     void sort_moves_by_probabilities();
 
+    /**
+     * @brief sort_moves_up_to Makes sure that the first childIdx+1 moves are sorted in descending order based on their probability value.
+     * The remaining moves are only guaranteed to have a lower probability and are sorted lazily in chunks of growing size.
+     * @param childIdx Index of the last move which must be at its sorted position
+     */
+    void sort_moves_up_to(size_t childIdx);
+
     /**
      * @brief make_to_root Makes the node to the current root node by setting its parent to a nullptr
      */
@@ -360,14 +547,14 @@ public:
     /**
      * @brief add_new_node_to_tree Checks if the given position already exists in the Hash map.
      * If so, connect the parent to this node. Otherwise create a new node.
-     * @param mapWithMutex Hash map with mutex
+     * @param transpositionTable Thread safe hash table of all nodes in the search graph
      * @param newState Corresponding state
      * @param childIdx Child index
      * @param searchSettings Search Settings struct
      * @param transposition Return true, if the transposition request was successfull, else false, i.e. a new node was added
-     * @return the newly added node
+     * @return the transposition node or the newly added shell node which still needs to be expanded
      */
-    Node* add_new_node_to_tree(MapWithMutex* mapWithMutex, StateObj* newState, ChildIdx childIdx, const SearchSettings* searchSettings, bool& transposition);
+    Node* add_new_node_to_tree(TranspositionTable* transpositionTable, StateObj* newState, ChildIdx childIdx, const SearchSettings* searchSettings, bool& transposition);
 
     void add_transposition_parent_node();
 
@@ -556,6 +743,15 @@ private:
      */
     void reserve_full_memory();
 
+    /**
+     * @brief snapshot_child_stats Copies the Q-values and visits of the revealed child nodes with atomic loads,
+     * because they may be updated concurrently by lock-free backups
+     * @param noVisitIdx Number of revealed child nodes
+     * @param qValues Output pointer to the Q-values, valid until the next call of the same thread
+     * @param childNumberVisits Output pointer to the visits, valid until the next call of the same thread
+     */
+    void snapshot_child_stats(size_t noVisitIdx, const float*& qValues, const uint32_t*& childNumberVisits) const;
+
     /**
      * @brief check_for_terminal Checks if the given board position is a terminal node and updates isTerminal
      * @param state Current board position for this node
@@ -584,6 +780,11 @@ private:
      */
     bool solve_for_terminal(ChildIdx childIdx, const SearchSettings* searchSettings);
 
+    /**
+     * @brief revert_virtual_loss_and_update_partitioned Hands a value backup over to the root partitioner and runs the terminal solver if requested
+     */
+    void revert_virtual_loss_and_update_partitioned(ChildIdx childIdx, float value, const SearchSettings* searchSettings, bool freeBackup, bool solveForTerminal);
+
     /**
      * @brief solved_win Checks if the current node is a solved win based on the given child node
      * @param childNode Child nodes which backpropagates the value
@@ -621,7 +822,7 @@ private:
     bool only_child_nodes_of_one_kind() const
     {
         for (auto it = d->childNodes.begin(); it != d->childNodes.end(); ++it) {
-            const Node* childNode = it->get();
+            const Node* childNode = *it;
             if (childNode->d->nodeType != nodeType) {
                 return false;
             }
@@ -797,6 +998,15 @@ NodeType flip_node_type(const enum NodeType nodeType);
  */
 bool is_terminal_value(float value);
 
+/**
+ * @brief release_node Releases a reference of the given node. If it was the last one, the node is erased from the transposition table
+ * and freed together with all child nodes which aren't referenced elsewhere. The subtree is traversed iteratively.
+ * The node is freed right away, so no search thread may access the tree or look up the table at the same time.
+ * @param node Node of which the caller holds a reference, nullptr is ignored
+ * @param transpositionTable Transposition table which might hold entries of the freed nodes
+ */
+void release_node(Node* node, TranspositionTable* transpositionTable);
+
 /**
  * @brief backup_collision Iteratively removes the virtual loss of the collision event that occurred
  * @param rootNode Root node of the tree
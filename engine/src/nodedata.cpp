@@ -24,46 +24,162 @@
  */
 
 #include "nodedata.h"
+#include <atomic>
 #include "util/blazeutil.h"
+#include "util/poolallocator.h"
 #include "constants.h"
 
+// estimated memory of all allocated nodes, it's updated with relaxed ordering because it's only used as a heuristic
+static atomic<size_t> treeMemory(0);
+// estimated memory of the tree which is searched by the current thread
+static thread_local atomic<size_t>* threadTreeMemory = nullptr;
+
+void add_tree_memory(size_t bytes)
+{
+    treeMemory.fetch_add(bytes, memory_order_relaxed);
+    if (threadTreeMemory != nullptr) {
+        threadTreeMemory->fetch_add(bytes, memory_order_relaxed);
+    }
+}
+
+void release_tree_memory(size_t bytes)
+{
+    treeMemory.fetch_sub(bytes, memory_order_relaxed);
+    if (threadTreeMemory != nullptr) {
+        threadTreeMemory->fetch_sub(bytes, memory_order_relaxed);
+    }
+}
+
+size_t get_tree_memory()
+{
+    return treeMemory.load(memory_order_relaxed);
+}
+
+void set_thread_tree_memory(atomic<size_t>* counter)
+{
+    threadTreeMemory = counter;
+}
+
+/**
+ * @brief child_stats_total_size Returns the size of the memory block for all per-child statistics including the child node pointers
+ */
+inline size_t child_stats_total_size(size_t capacity)
+{
+    return child_stats_memory_size(capacity) + capacity * sizeof(Node*);
+}
+
+size_t child_stats_section_size(size_t capacity, size_t elementSize)
+{
+    return (capacity * elementSize + CHILD_STATS_ALIGNMENT - 1) / CHILD_STATS_ALIGNMENT * CHILD_STATS_ALIGNMENT;
+}
+
+size_t child_stats_memory_size(size_t capacity)
+{
+    return child_stats_section_size(capacity, sizeof(float)) +
+           child_stats_section_size(capacity, sizeof(uint32_t)) +
+           child_stats_section_size(capacity, sizeof(uint8_t)) +
+           child_stats_section_size(capacity, sizeof(NodeType));
+}
+
+/**
+ * @brief allocate_child_stats_memory Allocates a memory block which is aligned to CHILD_STATS_ALIGNMENT.
+ * The offset to the start of the raw allocation is stored in the byte in front of the returned pointer.
+ * @param size Number of bytes
+ * @return Aligned pointer
+ */
+char* allocate_child_stats_memory(size_t size)
+{
+    char* raw = static_cast<char*>(::operator new(size + CHILD_STATS_ALIGNMENT));
+    const size_t offset = CHILD_STATS_ALIGNMENT - reinterpret_cast<uintptr_t>(raw) % CHILD_STATS_ALIGNMENT;
+    char* aligned = raw + offset;
+    aligned[-1] = char(offset);
+    return aligned;
+}
+
+/**
+ * @brief free_child_stats_memory Frees a memory block which was allocated by allocate_child_stats_memory()
+ * @param aligned Aligned pointer
+ */
+void free_child_stats_memory(char* aligned)
+{
+    if (aligned != nullptr) {
+        ::operator delete(aligned - uint8_t(aligned[-1]));
+    }
+}
+
+void NodeData::set_child_stats_views(char* memory, size_t capacity, size_t size)
+{
+    char* section = memory;
+    qValues.reset(reinterpret_cast<float*>(section), size);
+    section += child_stats_section_size(capacity, sizeof(float));
+    childNumberVisits.reset(reinterpret_cast<uint32_t*>(section), size);
+    section += child_stats_section_size(capacity, sizeof(uint32_t));
+    virtualLossCounter.reset(reinterpret_cast<uint8_t*>(section), size);
+    section += child_stats_section_size(capacity, sizeof(uint8_t));
+    nodeTypes.reset(reinterpret_cast<NodeType*>(section), size);
+}
+
+void NodeData::reserve_child_stats(size_t capacity)
+{
+    if (capacity <= childStatsCapacity) {
+        return;
+    }
+    const size_t size = qValues.size();
+    char* memory = allocate_child_stats_memory(child_stats_memory_size(capacity));
+    const float* oldQValues = qValues.data();
+    const uint32_t* oldChildNumberVisits = childNumberVisits.data();
+    const uint8_t* oldVirtualLossCounter = virtualLossCounter.data();
+    const NodeType* oldNodeTypes = nodeTypes.data();
+    set_child_stats_views(memory, capacity, size);
+    if (size != 0) {
+        copy_n(oldQValues, size, qValues.data());
+        copy_n(oldChildNumberVisits, size, childNumberVisits.data());
+        copy_n(oldVirtualLossCounter, size, virtualLossCounter.data());
+        copy_n(oldNodeTypes, size, nodeTypes.data());
+    }
+    free_child_stats_memory(childStatsMemory);
+    add_tree_memory(child_stats_total_size(capacity) - child_stats_total_size(childStatsCapacity));
+    childStatsMemory = memory;
+    childStatsCapacity = capacity;
+    childNodes.reserve(capacity);
+}
+
 void NodeData::add_empty_node()
 {
-    append(childNumberVisits, 0U);
-    append(qValues, Q_INIT);
-    append(virtualLossCounter, uint8_t(0));
-    append(nodeTypes, UNSOLVED);
+    const size_t idx = qValues.size();
+    if (idx == childStatsCapacity) {
+        reserve_child_stats(max(size_t(PRESERVED_ITEMS), size_t(2 * childStatsCapacity)));
+    }
+    set_child_stats_views(childStatsMemory, childStatsCapacity, idx + 1);
+    qValues[idx] = Q_INIT;
+    childNumberVisits[idx] = 0U;
+    virtualLossCounter[idx] = uint8_t(0);
+    nodeTypes[idx] = UNSOLVED;
     childNodes.emplace_back(nullptr);
 }
 
 void NodeData::reserve_initial_space()
 {
-    const int initSize = min(PRESERVED_ITEMS, int(numberUnsolvedChildNodes));
-
-    // # visit count of all its child nodes
-    childNumberVisits.reserve(initSize);
-
     // q: combined action value which is calculated by the averaging over all action values
-    // u: exploration metric for each child node
-    // (the q and u values are stacked into 1 list in order to speed-up the argmax() operation
-    qValues.reserve(initSize);
-
-    childNodes.reserve(initSize);
-    virtualLossCounter.reserve(initSize);
-    nodeTypes.reserve(initSize);
+    // childNumberVisits: visit count of all its child nodes
+    reserve_child_stats(min(PRESERVED_ITEMS, int(numberUnsolvedChildNodes)));
     add_empty_node();
 }
 
 NodeData::NodeData() :
+    rootPartitioner(nullptr),
+    childStatsMemory(nullptr),
+    childStatsCapacity(0),
     freeVisits(0),
     visitSum(0),
     checkmateIdx(NO_CHECKMATE),
     endInPly(0),
     noVisitIdx(1),
+    sortedIdx(0),
     nodeType(UNSOLVED),
     inspected(false)
 {
-
+    add_tree_memory(sizeof(NodeData));
 }
 
 NodeData::NodeData(size_t numberChildNodes) :
@@ -73,6 +189,44 @@ NodeData::NodeData(size_t numberChildNodes) :
     reserve_initial_space();
 }
 
+NodeData::~NodeData()
+{
+    free_child_stats_memory(childStatsMemory);
+    release_tree_memory(get_memory_size());
+}
+
+size_t NodeData::get_memory_size() const
+{
+    return sizeof(NodeData) + child_stats_total_size(childStatsCapacity);
+}
+
+float* NodeData::q_values_memory() const
+{
+    return reinterpret_cast<float*>(childStatsMemory);
+}
+
+uint32_t* NodeData::child_number_visits_memory() const
+{
+    return reinterpret_cast<uint32_t*>(childStatsMemory + child_stats_section_size(childStatsCapacity, sizeof(float)));
+}
+
+uint8_t* NodeData::virtual_loss_counter_memory() const
+{
+    return reinterpret_cast<uint8_t*>(childStatsMemory + child_stats_section_size(childStatsCapacity, sizeof(float)) +
+                                      child_stats_section_size(childStatsCapacity, sizeof(uint32_t)));
+}
+
+void* NodeData::operator new(size_t size)
+{
+    assert(size == sizeof(NodeData));
+    return PoolAllocator<NodeData>().allocate(1);
+}
+
+void NodeData::operator delete(void* ptr)
+{
+    PoolAllocator<NodeData>().deallocate(static_cast<NodeData*>(ptr), 1);
+}
+
 auto NodeData::get_q_values()
 {
     return blaze::subvector(qValues, 0, noVisitIdx);
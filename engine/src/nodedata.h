@@ -31,6 +31,7 @@
 #include <iostream>
 #include <set>
 #include <mutex>
+#include <atomic>
 #include <unordered_map>
 #include <blaze/Math.h>
 #include "agents/config/searchsettings.h"
@@ -39,6 +40,12 @@ using blaze::HybridVector;
 using blaze::DynamicVector;
 using namespace std;
 
+// alignment of each per-child statistics array within the memory block of NodeData
+#define CHILD_STATS_ALIGNMENT 64
+
+template <typename T>
+using ChildVector = blaze::CustomVector<T, blaze::unaligned, blaze::unpadded>;
+
 
 enum NodeType : uint8_t {
     WIN,
@@ -82,20 +89,30 @@ bool is_unsolved_or_tablebase(NodeType nodeType);
 
 
 class Node;
+class RootPartitioner;
 
 /**
- * @brief The NodeData struct stores the member variables for all expanded child nodes which have at least been visited two times
+ * @brief The NodeData struct stores the member variables for all expanded child nodes which have at least been visited two times.
+ * The per-child statistics are views into a single memory block in which every array starts at a cache line boundary.
+ * This way, the selection only touches a few cache lines and the arrays can be accessed by vector loads.
  */
 struct NodeData
 {
-    DynamicVector<uint32_t> childNumberVisits;
-    DynamicVector<uint32_t> childNumberVirtualVisits;
-    DynamicVector<float> qValues;
-    vector<shared_ptr<Node>> childNodes;
-    DynamicVector<uint8_t> virtualLossCounter;
-    DynamicVector<NodeType> nodeTypes;
+    ChildVector<float> qValues;
+    ChildVector<uint32_t> childNumberVisits;
+    ChildVector<uint8_t> virtualLossCounter;
+    ChildVector<NodeType> nodeTypes;
+    // every child node holds a reference of this node, the pointers are written atomically
+    vector<Node*> childNodes;
     float qValue_max;
 
+    // set while the child nodes of this root node are searched in partitions, the child statistics are then updated by the partitions
+    RootPartitioner* rootPartitioner;
+
+    // memory block which holds all per-child statistics
+    char* childStatsMemory;
+    uint16_t childStatsCapacity;
+
     uint32_t freeVisits;
     uint32_t visitSum;
 
@@ -103,11 +120,20 @@ struct NodeData
     uint16_t endInPly;
     uint16_t noVisitIdx;
     uint16_t numberUnsolvedChildNodes;
+    // number of leading moves which are already sorted by their probability value
+    uint16_t sortedIdx;
 
     NodeType nodeType;
     bool inspected;
     NodeData();
     NodeData(size_t numberChildNodes);
+    ~NodeData();
+    NodeData(const NodeData&) = delete;
+    NodeData& operator=(const NodeData&) = delete;
+
+    // node data objects are served from a memory pool to avoid a heap allocation for every new playout node
+    static void* operator new(size_t size);
+    static void operator delete(void* ptr);
 
     auto get_q_values();
 
@@ -121,7 +147,85 @@ public:
      * @brief reserve_initial_space Reserves memory for PRESERVED_ITEMS number of child nodes
      */
     void reserve_initial_space();
+
+    /**
+     * @brief reserve_child_stats Reallocates the memory block of the per-child statistics for the given capacity if necessary.
+     * All existing entries are preserved.
+     * @param capacity Number of child nodes which can be stored without a reallocation
+     */
+    void reserve_child_stats(size_t capacity);
+
+    /**
+     * @brief get_memory_size Returns the estimated number of bytes of the node data including the per-child statistics
+     */
+    size_t get_memory_size() const;
+
+    /**
+     * @brief q_values_memory Returns the Q-values within the memory block of the per-child statistics.
+     * Unlike the views, the arrays of the memory block may be accessed by lock-free updates while the lock holder reveals
+     * further child nodes, because the block isn't reallocated anymore once it has been reserved for all child nodes.
+     */
+    float* q_values_memory() const;
+
+    /**
+     * @brief child_number_visits_memory Returns the visit counts within the memory block, see q_values_memory()
+     */
+    uint32_t* child_number_visits_memory() const;
+
+    /**
+     * @brief virtual_loss_counter_memory Returns the virtual loss counters within the memory block, see q_values_memory()
+     */
+    uint8_t* virtual_loss_counter_memory() const;
+
+private:
+    /**
+     * @brief set_child_stats_views Sets the per-child statistics views to the given memory block
+     * @param memory Aligned memory block
+     * @param capacity Capacity of the memory block in number of child nodes
+     * @param size Number of child nodes which are currently in use
+     */
+    void set_child_stats_views(char* memory, size_t capacity, size_t size);
 };
 
+/**
+ * @brief child_stats_section_size Returns the number of bytes of a single per-child statistics array rounded up to the alignment
+ * @param capacity Number of child nodes
+ * @param elementSize Size of a single element in bytes
+ * @return Number of bytes
+ */
+size_t child_stats_section_size(size_t capacity, size_t elementSize);
+
+/**
+ * @brief child_stats_memory_size Returns the size of the memory block for all per-child statistics
+ * @param capacity Number of child nodes
+ * @return Number of bytes
+ */
+size_t child_stats_memory_size(size_t capacity);
+
+/**
+ * @brief add_tree_memory Adds the given number of bytes to the estimated memory of all allocated nodes
+ * @param bytes Number of bytes
+ */
+void add_tree_memory(size_t bytes);
+
+/**
+ * @brief release_tree_memory Subtracts the given number of bytes from the estimated memory of all allocated nodes
+ * @param bytes Number of bytes
+ */
+void release_tree_memory(size_t bytes);
+
+/**
+ * @brief get_tree_memory Returns the estimated number of bytes which are used by all allocated nodes and their node data
+ * @return Number of bytes
+ */
+size_t get_tree_memory();
+
+/**
+ * @brief set_thread_tree_memory Sets a counter to which the node memory that is allocated and released by the calling thread is added as well.
+ * It estimates the memory of the single tree which is searched by the thread.
+ * @param counter Memory counter of the tree or nullptr
+ */
+void set_thread_tree_memory(atomic<size_t>* counter);
+
 
 #endif // NODEDATA_H
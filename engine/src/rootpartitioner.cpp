@@ -0,0 +1,172 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: rootpartitioner.cpp
+ * Created on 18.10.2026
+ * @author: queensgambit
+ */
+
+#include "rootpartitioner.h"
+
+RootPartition::RootPartition() :
+    pendingVisits(0),
+    pendingRealVisits(0),
+    pendingValueSum(0),
+    pendingFreeVisits(0),
+    pendingBackups(0)
+{
+}
+
+RootPartitioner::RootPartitioner(const SearchSettings* searchSettings) :
+    searchSettings(searchSettings),
+    rootNode(nullptr),
+    rootVisits(0)
+{
+}
+
+void RootPartitioner::start(Node* rootNode, size_t numberPartitions)
+{
+    rootNode->lock();
+    if (!rootNode->is_sorted()) {
+        rootNode->prepare_node_for_visits();
+    }
+    const size_t numberChildNodes = rootNode->get_number_child_nodes();
+    if (!rootNode->is_fully_expanded()) {
+        rootNode->sort_moves_up_to(numberChildNodes - 1);
+        rootNode->fully_expand_node();
+    }
+    numberPartitions = min(numberPartitions, numberChildNodes);
+    partitions.clear();
+    for (size_t partitionIdx = 0; partitionIdx < numberPartitions; ++partitionIdx) {
+        partitions.emplace_back(make_unique<RootPartition>());
+    }
+    childPartitions.resize(numberChildNodes);
+    for (ChildIdx childIdx = 0; childIdx < numberChildNodes; ++childIdx) {
+        childPartitions[childIdx] = childIdx % numberPartitions;
+        partitions[childIdx % numberPartitions]->childIndices.emplace_back(childIdx);
+    }
+    rootNode->set_root_partitioner(this);
+    rootVisits.store(rootNode->get_visits(), memory_order_relaxed);
+    rootNode->unlock();
+    this->rootNode = rootNode;
+}
+
+void RootPartitioner::finish()
+{
+    if (rootNode == nullptr) {
+        return;
+    }
+    for (unique_ptr<RootPartition>& partition : partitions) {
+        unique_lock<mutex> lock(partition->mtx);
+        merge_pending_stats(*partition, lock);
+    }
+    rootNode->lock();
+    rootNode->set_root_partitioner(nullptr);
+    rootNode->unlock();
+    rootNode = nullptr;
+}
+
+bool RootPartitioner::is_active() const
+{
+    return rootNode != nullptr;
+}
+
+size_t RootPartitioner::get_number_partitions() const
+{
+    return partitions.size();
+}
+
+ChildIdx RootPartitioner::select_child_node(size_t partitionIdx)
+{
+    RootPartition& partition = *partitions[partitionIdx];
+    lock_guard<mutex> lock(partition.mtx);
+    // the visits of the other partitions are only known up to their last merge
+    const uint32_t visitSum = max(int32_t(rootVisits.load(memory_order_relaxed)) + partition.pendingVisits, 1);
+    const ChildIdx childIdx = rootNode->select_child_node_in_partition(partition.childIndices, visitSum, searchSettings);
+    rootNode->apply_virtual_loss_to_child_stats(childIdx, searchSettings);
+    ++partition.pendingVisits;
+    return childIdx;
+}
+
+void RootPartitioner::apply_virtual_loss_to_child(ChildIdx childIdx)
+{
+    // this is called while holding the lock of the root node, so no merge is done here
+    RootPartition& partition = *partitions[childPartitions[childIdx]];
+    lock_guard<mutex> lock(partition.mtx);
+    rootNode->apply_virtual_loss_to_child_stats(childIdx, searchSettings);
+    ++partition.pendingVisits;
+}
+
+void RootPartitioner::revert_virtual_loss_and_update(ChildIdx childIdx, float value, bool freeBackup)
+{
+    RootPartition& partition = *partitions[childPartitions[childIdx]];
+    unique_lock<mutex> lock(partition.mtx);
+    rootNode->revert_virtual_loss_and_update_child_stats(childIdx, value, searchSettings);
+    ++partition.pendingRealVisits;
+    partition.pendingValueSum += value;
+    if (freeBackup) {
+        ++partition.pendingFreeVisits;
+    }
+    if (++partition.pendingBackups >= ROOT_PARTITION_MERGE_INTERVAL) {
+        merge_pending_stats(partition, lock);
+    }
+}
+
+void RootPartitioner::revert_virtual_loss(ChildIdx childIdx)
+{
+    RootPartition& partition = *partitions[childPartitions[childIdx]];
+    lock_guard<mutex> lock(partition.mtx);
+    rootNode->revert_virtual_loss_of_child_stats(childIdx, searchSettings);
+    --partition.pendingVisits;
+}
+
+void RootPartitioner::merge_pending_stats(RootPartition& partition, unique_lock<mutex>& lock)
+{
+    const int32_t visits = partition.pendingVisits;
+    const uint32_t realVisits = partition.pendingRealVisits;
+    const double valueSum = partition.pendingValueSum;
+    const uint32_t freeVisits = partition.pendingFreeVisits;
+    partition.pendingVisits = 0;
+    partition.pendingRealVisits = 0;
+    partition.pendingValueSum = 0;
+    partition.pendingFreeVisits = 0;
+    partition.pendingBackups = 0;
+    lock.unlock();
+
+    rootNode->lock();
+    rootNode->merge_stats(visits, realVisits, valueSum, freeVisits);
+    rootVisits.store(rootNode->get_visits(), memory_order_relaxed);
+    rootNode->unlock();
+}
+
+void RootPartitioner::lock_partitions()
+{
+    // the partitions are always locked in the same order, so concurrent calls can't deadlock
+    for (unique_ptr<RootPartition>& partition : partitions) {
+        partition->mtx.lock();
+    }
+}
+
+void RootPartitioner::unlock_partitions()
+{
+    for (unique_ptr<RootPartition>& partition : partitions) {
+        partition->mtx.unlock();
+    }
+}
@@ -0,0 +1,142 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: rootpartitioner.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Splits the child nodes of the root node into disjoint partitions which are searched by separate groups of search threads.
+ * Each partition guards the statistics of its root child nodes by its own mutex, so that the threads of different groups
+ * don't contend for the lock of the root node on every descent and backup. The changes of the root's own visit and value sums
+ * are collected per partition and merged into the root node periodically under a single lock.
+ */
+
+#ifndef ROOTPARTITIONER_H
+#define ROOTPARTITIONER_H
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "node.h"
+
+using namespace std;
+
+// number of backups after which a partition merges its pending statistics into the root node
+#define ROOT_PARTITION_MERGE_INTERVAL 32
+
+struct RootPartition
+{
+    mutex mtx;
+    // root child indices which are only selected by the threads of this partition
+    vector<ChildIdx> childIndices;
+    // changes of the root node statistics which haven't been merged into the root node yet
+    int32_t pendingVisits;
+    uint32_t pendingRealVisits;
+    double pendingValueSum;
+    uint32_t pendingFreeVisits;
+    size_t pendingBackups;
+    RootPartition();
+};
+
+class RootPartitioner
+{
+private:
+    const SearchSettings* searchSettings;
+    Node* rootNode;
+    vector<unique_ptr<RootPartition>> partitions;
+    // partition index of every root child
+    vector<uint16_t> childPartitions;
+    // visit sum of the root node after the last merge, the root node itself is only updated under its lock
+    atomic<uint32_t> rootVisits;
+
+    /**
+     * @brief merge_pending_stats Merges the pending statistics of the given partition into the root node
+     * @param partition Partition
+     * @param lock Lock of the partition, it's released before the root node is locked
+     */
+    void merge_pending_stats(RootPartition& partition, unique_lock<mutex>& lock);
+
+public:
+    RootPartitioner(const SearchSettings* searchSettings);
+    RootPartitioner(const RootPartitioner&) = delete;
+    RootPartitioner& operator=(const RootPartitioner&) = delete;
+
+    /**
+     * @brief start Fully expands the given root node and deals its child nodes to the partitions in descending order of their prior,
+     * so that every partition receives promising moves. Must be called before the search threads are started.
+     * @param rootNode Root node of the search which has been evaluated already
+     * @param numberPartitions Number of partitions, at most one partition per root child is used
+     */
+    void start(Node* rootNode, size_t numberPartitions);
+
+    /**
+     * @brief finish Merges all pending statistics into the root node and restores the regular updates of the root node.
+     * Must be called after all search threads have stopped.
+     */
+    void finish();
+
+    /**
+     * @brief is_active Returns true between start() and finish()
+     */
+    bool is_active() const;
+
+    size_t get_number_partitions() const;
+
+    /**
+     * @brief select_child_node Selects the next root child of the given partition and applies a virtual loss to it
+     * @param partitionIdx Partition of the calling search thread
+     * @return Root child index
+     */
+    ChildIdx select_child_node(size_t partitionIdx);
+
+    /**
+     * @brief apply_virtual_loss_to_child Applies a virtual loss to a root child which was selected outside of its partition, e.g. by a random playout
+     * @param childIdx Root child index
+     */
+    void apply_virtual_loss_to_child(ChildIdx childIdx);
+
+    /**
+     * @brief revert_virtual_loss_and_update Reverts the virtual loss of the given root child and updates its Q-value
+     * @param childIdx Root child index
+     * @param value Value from the point of view of the root node
+     * @param freeBackup True, if the backup is counted as a free visit
+     */
+    void revert_virtual_loss_and_update(ChildIdx childIdx, float value, bool freeBackup);
+
+    /**
+     * @brief revert_virtual_loss Reverts the virtual loss of the given root child
+     * @param childIdx Root child index
+     */
+    void revert_virtual_loss(ChildIdx childIdx);
+
+    /**
+     * @brief lock_partitions Locks all partitions, so that the statistics of all root child nodes can be read consistently.
+     * Must be called while holding the lock of the root node to keep the lock order of apply_virtual_loss_to_child().
+     */
+    void lock_partitions();
+
+    /**
+     * @brief unlock_partitions Unlocks all partitions which were locked by lock_partitions()
+     */
+    void unlock_partitions();
+};
+
+#endif // ROOTPARTITIONER_H
@@ -32,6 +32,7 @@
 
 #include <stdlib.h>
 #include <climits>
+#include <chrono>
 #include "util/blazeutil.h"
 
 
@@ -40,14 +41,21 @@ size_t SearchThread::get_max_depth() const
     return depthMax;
 }
 
-SearchThread::SearchThread(NeuralNetAPI *netBatch, const SearchSettings* searchSettings, MapWithMutex* mapWithMutex):
-    NeuralNetAPIUser(netBatch),
+SearchThread::SearchThread(NeuralNetAPI *netBatch, const SearchSettings* searchSettings, TranspositionTable* transpositionTable, NNCache* nnCache, TreePruner* treePruner, ThreadPool* threadPool, InferenceServer* inferenceServer):
+    NeuralNetAPIUser(netBatch, searchSettings->pipelineInference ? 2 : 1, inferenceServer != nullptr ? searchSettings->batchSize : 0),
     rootNode(nullptr), rootState(nullptr), newState(nullptr),  // will be be set via setter methods
     newNodes(make_unique<FixedVector<Node*>>(searchSettings->batchSize)),
     newNodeSideToMove(make_unique<FixedVector<SideToMove>>(searchSettings->batchSize)),
     transpositionValues(make_unique<FixedVector<float>>(searchSettings->batchSize*2)),
-    isRunning(true), mapWithMutex(mapWithMutex), searchSettings(searchSettings),
-    tbHits(0), depthSum(0), depthMax(0), visitsPreSearch(0),
+    pendingNodes(make_unique<FixedVector<Node*>>(searchSettings->batchSize)),
+    pendingNodeSideToMove(make_unique<FixedVector<SideToMove>>(searchSettings->batchSize)),
+    pendingBufferSet(0),
+    threadPool(threadPool),
+    inferenceServer(inferenceServer),
+    isRunning(true), transpositionTable(transpositionTable), nnCache(nnCache), treePruner(treePruner),
+    rootPartitioner(nullptr), rootPartitionIdx(0), randomGenerator(derive_seed(0, 0)),
+    epochSlot(transpositionTable->get_epoch_manager().register_thread()), searchSettings(searchSettings),
+    tbHits(0), depthSum(0), depthMax(0), descentCount(0), collisionCount(0), reusedCollisionCount(0), expansionCount(0), expansionTimeNS(0), visitsPreSearch(0),
     terminalNodeCache(searchSettings->batchSize*2),
     reachedTablebases(false)
 {
@@ -61,6 +69,11 @@ SearchThread::SearchThread(NeuralNetAPI *netBatch, const SearchSettings* searchS
     actionsBuffer.reserve(DEPTH_INIT);
 }
 
+SearchThread::~SearchThread()
+{
+    transpositionTable->get_epoch_manager().unregister_thread(epochSlot);
+}
+
 void SearchThread::set_root_node(Node *value)
 {
     rootNode = value;
@@ -87,15 +100,31 @@ void SearchThread::set_reached_tablebases(bool value)
     reachedTablebases = value;
 }
 
+InferenceServer* SearchThread::get_inference_server() const
+{
+    return inferenceServer;
+}
+
+void SearchThread::set_root_partition(RootPartitioner* rootPartitioner, size_t partitionIdx)
+{
+    this->rootPartitioner = rootPartitioner;
+    rootPartitionIdx = partitionIdx;
+}
+
+void SearchThread::seed_random_generator(uint64_t seed)
+{
+    randomGenerator.seed(seed);
+}
+
 Node* SearchThread::add_new_node_to_tree(StateObj* newState, Node* parentNode, ChildIdx childIdx, NodeBackup& nodeBackup)
 {
     bool transposition;
-    Node* newNode = parentNode->add_new_node_to_tree(mapWithMutex, newState, childIdx, searchSettings, transposition);
-    if (newNode->is_terminal()) {
-        nodeBackup = NODE_TERMINAL;
-        return newNode;
-    }
+    Node* newNode = parentNode->add_new_node_to_tree(transpositionTable, newState, childIdx, searchSettings, transposition);
     if (transposition) {
+        if (newNode->is_terminal()) {
+            nodeBackup = NODE_TERMINAL;
+            return newNode;
+        }
         const float qValue =  parentNode->get_child_node(childIdx)->get_value();
         transpositionValues->add_element(qValue);
         nodeBackup = NODE_TRANSPOSITION;
@@ -120,10 +149,10 @@ SearchLimits *SearchThread::get_search_limits() const
     return searchLimits;
 }
 
-void random_playout(Node* currentNode, ChildIdx& childIdx)
+void random_playout(Node* currentNode, ChildIdx& childIdx, Xoshiro256& randomGenerator)
 {
     if (currentNode->is_fully_expanded()) {
-        const size_t idx = rand() % currentNode->get_number_child_nodes();
+        const size_t idx = randomGenerator.below(currentNode->get_number_child_nodes());
         if (currentNode->get_child_node(idx) == nullptr || !currentNode->get_child_node(idx)->is_playout_node()) {
             childIdx = idx;
             return;
@@ -143,7 +172,7 @@ void random_playout(Node* currentNode, ChildIdx& childIdx)
 
 Node* SearchThread::get_starting_node(Node* currentNode, NodeDescription& description, ChildIdx& childIdx)
 {
-    size_t depth = get_random_depth();
+    size_t depth = get_random_depth(randomGenerator);
     for (uint curDepth = 0; curDepth < depth; ++curDepth) {
         currentNode->lock();
         childIdx = get_best_action_index(currentNode, true, searchSettings);
@@ -167,126 +196,298 @@ Node* SearchThread::get_new_child_to_evaluate(NodeDescription& description)
     Node* nextNode;
 
     ChildIdx childIdx = uint16_t(-1);
-    if (searchSettings->epsilonGreedyCounter && rootNode->is_playout_node() && rand() % searchSettings->epsilonGreedyCounter == 0) {
+    if (searchSettings->epsilonGreedyCounter && rootNode->is_playout_node() && randomGenerator.below(searchSettings->epsilonGreedyCounter) == 0) {
         currentNode = get_starting_node(currentNode, description, childIdx);
         currentNode->lock();
-        random_playout(currentNode, childIdx);
+        random_playout(currentNode, childIdx, randomGenerator);
         currentNode->unlock();
     }
-    else if (searchSettings->epsilonChecksCounter && rootNode->is_playout_node() && rand() % searchSettings->epsilonChecksCounter == 0) {
+    else if (searchSettings->epsilonChecksCounter && rootNode->is_playout_node() && randomGenerator.below(searchSettings->epsilonChecksCounter) == 0) {
         currentNode = get_starting_node(currentNode, description, childIdx);
         currentNode->lock();
         childIdx = select_enhanced_move(currentNode);
         if (childIdx ==  uint16_t(-1)) {
-            random_playout(currentNode, childIdx);
+            random_playout(currentNode, childIdx, randomGenerator);
         }
         currentNode->unlock();
     }
 
     while (true) {
-        currentNode->lock();
-        if (childIdx == uint16_t(-1)) {
-            childIdx = currentNode->select_child_node(searchSettings);
+        if (currentNode == rootNode && childIdx == uint16_t(-1) && rootPartitioner != nullptr && rootPartitioner->is_active()) {
+            childIdx = rootPartitioner->select_child_node(rootPartitionIdx);
+            trajectoryBuffer.emplace_back(NodeAndIdx(currentNode, childIdx));
+            description.depth++;
+            nextNode = visit_partitioned_root_child(childIdx, description);
+        }
+        else if (childIdx == uint16_t(-1) && searchSettings->lockFreeUpdates &&
+                 (nextNode = visit_child_lock_free(currentNode, childIdx, description)) != nullptr) {
+            // the current node wasn't locked
+        }
+        else {
+            currentNode->lock();
+            if (childIdx == uint16_t(-1)) {
+                childIdx = currentNode->select_child_node(searchSettings);
+            }
+            currentNode->apply_virtual_loss_to_child(childIdx, searchSettings);
+            trajectoryBuffer.emplace_back(NodeAndIdx(currentNode, childIdx));
+            description.depth++;
+            nextNode = visit_child(currentNode, childIdx, description);
+        }
+        if (description.type != NODE_UNKNOWN) {
+            return nextNode;
         }
-        currentNode->apply_virtual_loss_to_child(childIdx, searchSettings);
-        trajectoryBuffer.emplace_back(NodeAndIdx(currentNode, childIdx));
+#ifndef MCTS_STORE_STATES
+        actionsBuffer.emplace_back(currentNode->get_action(childIdx));
+#endif
+        currentNode = nextNode;
+        childIdx = uint16_t(-1);
+    }
+}
 
-        nextNode = currentNode->get_child_node(childIdx);
-        description.depth++;
-        if (nextNode == nullptr) {
+Node* SearchThread::visit_child(Node* currentNode, ChildIdx childIdx, NodeDescription& description)
+{
+    Node* nextNode = currentNode->get_child_node(childIdx);
+    if (nextNode == nullptr) {
 #ifdef MCTS_STORE_STATES
-            StateObj* newState = currentNode->get_state()->clone();
+        StateObj* newState = currentNode->get_state()->clone();
+#elif defined(SF_DEPENDENCY)
+        // the search state stays at the new leaf and is moved to the next leaf by the following descent
+        StateObj* newState = get_synced_search_state();
+        searchStateActions.emplace_back(currentNode->get_action(childIdx));
 #else
-            newState = unique_ptr<StateObj>(rootState->clone());
-            assert(actionsBuffer.size() == description.depth-1);
-            for (Action action : actionsBuffer) {
-                newState->do_action(action);
-            }
+        newState = unique_ptr<StateObj>(rootState->clone());
+        assert(actionsBuffer.size() == description.depth-1);
+        for (Action action : actionsBuffer) {
+            newState->do_action(action);
+        }
 #endif
-            newState->do_action(currentNode->get_action(childIdx));
+        newState->do_action(currentNode->get_action(childIdx));
+        // a pruned child node is re-expanded without revealing a new child
+        if (childIdx + 1 == currentNode->get_no_visit_idx()) {
             currentNode->increment_no_visit_idx();
-#ifdef MCTS_STORE_STATES
-            nextNode = add_new_node_to_tree(newState, currentNode, childIdx, description.type);
+        }
+#if defined(MCTS_STORE_STATES) || defined(SF_DEPENDENCY)
+        nextNode = add_new_node_to_tree(newState, currentNode, childIdx, description.type);
 #else
-            nextNode = add_new_node_to_tree(newState.get(), currentNode, childIdx, description.type);
+        nextNode = add_new_node_to_tree(newState.get(), currentNode, childIdx, description.type);
 #endif
-            currentNode->unlock();
+        currentNode->unlock();
 
-            if (description.type == NODE_NEW_NODE) {
-#ifdef SEARCH_UCT
-                Node* nextNode = currentNode->get_child_node(childIdx);
-                nextNode->set_value(newState->random_rollout());
-                nextNode->enable_has_nn_results();
-                if (searchSettings->useTranspositionTable && !nextNode->is_terminal()) {
-                    mapWithMutex->mtx.lock();
-                    mapWithMutex->hashTable.insert({nextNode->hash_key(), nextNode});
-                    mapWithMutex->mtx.unlock();
-                }
+        if (description.type == NODE_NEW_NODE) {
+            // the move generation and the terminal checks don't block the parent node
+#if defined(MCTS_STORE_STATES) || defined(SF_DEPENDENCY)
+            expand_node(nextNode, newState);
 #else
-                // fill a new board in the input_planes vector
-                // we shift the index by nbNNInputValues each time
-                newState->get_state_planes(true, inputPlanes + newNodes->size() * net->get_nb_input_values_total(), net->get_version());
-                // save a reference newly created list in the temporary list for node creation
-                // it will later be updated with the evaluation of the NN
-                newNodeSideToMove->add_element(newState->side_to_move());
+            expand_node(nextNode, newState.get());
 #endif
+            if (nextNode->is_terminal()) {
+                description.type = NODE_TERMINAL;
+                return nextNode;
             }
-            return nextNode;
-        }
-        if (nextNode->is_terminal()) {
-            description.type = NODE_TERMINAL;
-            currentNode->unlock();
-            return nextNode;
-        }
-        if (!nextNode->has_nn_results()) {
-            description.type = NODE_COLLISION;
-            currentNode->unlock();
-            return nextNode;
-        }
-        if (nextNode->is_transposition()) {
-            nextNode->lock();
-            const uint_fast32_t transposVisits = currentNode->get_real_visits(childIdx);
-            const double transposQValue = currentNode->get_transposition_q_value(searchSettings, childIdx, transposVisits);
-
-            if (nextNode->is_transposition_return(transposQValue)) {
-                const float backupValue = get_transposition_backup_value(transposVisits, transposQValue, nextNode->get_value());
-                nextNode->unlock();
-                description.type = NODE_TRANSPOSITION;
-                transpositionValues->add_element(backupValue);
-                currentNode->unlock();
+#ifdef SEARCH_UCT
+            Node* nextNode = currentNode->get_child_node(childIdx);
+            nextNode->set_value(newState->random_rollout());
+            nextNode->enable_has_nn_results();
+            if (searchSettings->useTranspositionTable && !nextNode->is_terminal()) {
+                transpositionTable->insert(nextNode->hash_key(), nextNode);
+            }
+#else
+            if (probe_nn_cache(nextNode, newState->side_to_move())) {
+                description.type = NODE_NN_CACHE;
                 return nextNode;
             }
-            nextNode->unlock();
+            // fill a new board in the input_planes vector
+            // we shift the index by nbNNInputValues each time
+            newState->get_state_planes(true, inputPlanes + newNodes->size() * net->get_nb_input_values_total(), net->get_version());
+            // save a reference newly created list in the temporary list for node creation
+            // it will later be updated with the evaluation of the NN
+            newNodeSideToMove->add_element(newState->side_to_move());
+#endif
         }
+        return nextNode;
+    }
+    if (!nextNode->is_expanded()) {
+        // another thread is expanding the node right now
+        description.type = NODE_COLLISION;
         currentNode->unlock();
-#ifndef MCTS_STORE_STATES
-        actionsBuffer.emplace_back(currentNode->get_action(childIdx));
-#endif
-        currentNode = nextNode;
-        childIdx = uint16_t(-1);
+        return nextNode;
+    }
+    if (nextNode->is_terminal()) {
+        description.type = NODE_TERMINAL;
+        currentNode->unlock();
+        return nextNode;
+    }
+    if (!nextNode->has_nn_results()) {
+        description.type = NODE_COLLISION;
+        currentNode->unlock();
+        return nextNode;
+    }
+    if (nextNode->is_transposition()) {
+        nextNode->lock();
+        const uint_fast32_t transposVisits = currentNode->get_real_visits(childIdx);
+        const double transposQValue = currentNode->get_transposition_q_value(searchSettings, childIdx, transposVisits);
+
+        if (nextNode->is_transposition_return(transposQValue)) {
+            const float backupValue = get_transposition_backup_value(transposVisits, transposQValue, nextNode->get_value());
+            nextNode->unlock();
+            description.type = NODE_TRANSPOSITION;
+            transpositionValues->add_element(backupValue);
+            currentNode->unlock();
+            return nextNode;
+        }
+        nextNode->unlock();
     }
+    currentNode->unlock();
+    description.type = NODE_UNKNOWN;
+    return nextNode;
 }
 
+Node* SearchThread::visit_child_lock_free(Node* currentNode, ChildIdx& childIdx, NodeDescription& description)
+{
+    ChildIdx selectedIdx;
+    if (!currentNode->select_child_node_lock_free(searchSettings, selectedIdx)) {
+        return nullptr;
+    }
+    Node* nextNode = currentNode->get_child_node(selectedIdx);
+    // new nodes, collisions, terminals and transpositions are handled by visit_child()
+    if (nextNode == nullptr || !nextNode->has_nn_results() || nextNode->is_terminal() || nextNode->is_transposition()) {
+        return nullptr;
+    }
+    childIdx = selectedIdx;
+    currentNode->apply_virtual_loss_to_child(childIdx, searchSettings);
+    trajectoryBuffer.emplace_back(NodeAndIdx(currentNode, childIdx));
+    description.depth++;
+    description.type = NODE_UNKNOWN;
+    return nextNode;
+}
+
+Node* SearchThread::visit_partitioned_root_child(ChildIdx childIdx, NodeDescription& description)
+{
+    Node* nextNode = rootNode->get_child_node(childIdx);
+    if (nextNode == nullptr || nextNode->is_transposition()) {
+        rootNode->lock();
+        return visit_child(rootNode, childIdx, description);
+    }
+    if (!nextNode->is_expanded()) {
+        description.type = NODE_COLLISION;
+    }
+    else if (nextNode->is_terminal()) {
+        description.type = NODE_TERMINAL;
+    }
+    else if (!nextNode->has_nn_results()) {
+        description.type = NODE_COLLISION;
+    }
+    else {
+        description.type = NODE_UNKNOWN;
+    }
+    return nextNode;
+}
+
+#ifndef SEARCH_UCT
+bool SearchThread::probe_nn_cache(Node* node, SideToMove sideToMove)
+{
+    // auxiliary outputs and tablebase values can't be restored from the cache
+    if (!nnCache->is_enabled() || net->has_auxiliary_outputs() || node->is_tablebase()) {
+        return false;
+    }
+    float value;
+    if (!nnCache->probe(node->hash_key(), sideToMove, value, node->get_policy_prob_small())) {
+        return false;
+    }
+    node_post_process_policy(node, searchSettings->nodePolicyTemperature, searchSettings);
+    node->set_value(value);
+    node->enable_has_nn_results();
+    return true;
+}
+#endif
+
 void SearchThread::set_root_state(StateObj* value)
 {
     rootState = value;
+#if defined(SF_DEPENDENCY) && !defined(MCTS_STORE_STATES)
+    searchState = unique_ptr<StateObj>(rootState->clone());
+    searchStateActions.clear();
+#endif
+}
+
+#if defined(SF_DEPENDENCY) && !defined(MCTS_STORE_STATES)
+StateObj* SearchThread::get_synced_search_state()
+{
+    size_t commonDepth = 0;
+    while (commonDepth < searchStateActions.size() && commonDepth < actionsBuffer.size() &&
+           searchStateActions[commonDepth] == actionsBuffer[commonDepth]) {
+        ++commonDepth;
+    }
+    while (searchStateActions.size() > commonDepth) {
+        searchState->undo_action(searchStateActions.back());
+        searchStateActions.pop_back();
+    }
+    for (size_t idx = commonDepth; idx < actionsBuffer.size(); ++idx) {
+        searchState->do_action(actionsBuffer[idx]);
+        searchStateActions.emplace_back(actionsBuffer[idx]);
+    }
+    return searchState.get();
 }
+#endif
 
 size_t SearchThread::get_tb_hits() const
 {
     return tbHits;
 }
 
+void SearchThread::expand_node(Node* node, StateObj* state)
+{
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    node->expand(state, searchSettings);
+    expansionTimeNS += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+    ++expansionCount;
+}
+
+size_t SearchThread::get_expansion_count() const
+{
+    return expansionCount;
+}
+
+size_t SearchThread::get_expansion_time_ns() const
+{
+    return expansionTimeNS;
+}
+
+size_t SearchThread::get_descent_count() const
+{
+    return descentCount;
+}
+
+size_t SearchThread::get_collision_count() const
+{
+    return collisionCount;
+}
+
+size_t SearchThread::get_reused_collision_count() const
+{
+    return reusedCollisionCount;
+}
+
 void SearchThread::reset_stats()
 {
     tbHits = 0;
     depthMax = 0;
     depthSum = 0;
+    descentCount = 0;
+    collisionCount = 0;
+    reusedCollisionCount = 0;
+    expansionCount = 0;
+    expansionTimeNS = 0;
 }
 
-void fill_nn_results(size_t batchIdx, bool isPolicyMap, const float* valueOutputs, const float* probOutputs, const float* auxiliaryOutputs, Node *node, size_t& tbHits, bool mirrorPolicy, const SearchSettings* searchSettings, bool isRootNodeTB)
+void fill_nn_results(size_t batchIdx, bool isPolicyMap, const float* valueOutputs, const float* probOutputs, const float* auxiliaryOutputs, Node *node, size_t& tbHits, bool mirrorPolicy, const SearchSettings* searchSettings, bool isRootNodeTB,
+                     NNCache* nnCache, SideToMove sideToMove)
 {
     node->set_probabilities_for_moves(get_policy_data_batch(batchIdx, probOutputs, isPolicyMap), mirrorPolicy);
+    if (nnCache != nullptr && nnCache->is_enabled() && !node->is_tablebase()) {
+        // the raw policy is stored, the temperature is applied again after each cache hit
+        nnCache->store(node->hash_key(), sideToMove, valueOutputs[batchIdx], node->get_policy_prob_small());
+    }
     node_post_process_policy(node, searchSettings->nodePolicyTemperature, searchSettings);
     node_assign_value(node, valueOutputs, tbHits, batchIdx, isRootNodeTB);
 #ifdef MCTS_STORE_STATES
@@ -295,13 +496,13 @@ void fill_nn_results(size_t batchIdx, bool isPolicyMap, const float* valueOutput
     node->enable_has_nn_results();
 }
 
-void SearchThread::set_nn_results_to_child_nodes()
+void SearchThread::set_nn_results_to_child_nodes(FixedVector<Node*>& nodes, FixedVector<SideToMove>& sideToMove, const InferenceBuffers& buffers)
 {
     size_t batchIdx = 0;
-    for (auto node: *newNodes) {
-        fill_nn_results(batchIdx, net->is_policy_map(), valueOutputs, probOutputs, auxiliaryOutputs, node,
-                        tbHits, rootState->mirror_policy(newNodeSideToMove->get_element(batchIdx)),
-                        searchSettings, rootNode->is_tablebase());
+    for (auto node: nodes) {
+        fill_nn_results(batchIdx, net->is_policy_map(), buffers.valueOutputs, buffers.probOutputs, buffers.auxiliaryOutputs, node,
+                        tbHits, rootState->mirror_policy(sideToMove.get_element(batchIdx)),
+                        searchSettings, rootNode->is_tablebase(), nnCache, sideToMove.get_element(batchIdx));
         ++batchIdx;
     }
 }
@@ -315,9 +516,25 @@ void SearchThread::backup_value_outputs()
 
 void SearchThread::backup_collisions() {
     for (size_t idx = 0; idx < collisionTrajectories.size(); ++idx) {
-        backup_collision(searchSettings, collisionTrajectories[idx]);
+        Node* leafNode = collisionNodes[idx];
+        if (searchSettings->reuseCollisions && leafNode->has_nn_results()) {
+            // the visit reuses the value of the leaf and doesn't count as a neural network evaluation
+            backup_value<true>(leafNode->get_value(), searchSettings, collisionTrajectories[idx], false);
+            ++reusedCollisionCount;
+        }
+        else {
+            backup_collision(searchSettings, collisionTrajectories[idx]);
+        }
     }
     collisionTrajectories.clear();
+    collisionNodes.clear();
+}
+
+void SearchThread::add_collision(Node* leafNode)
+{
+    collisionTrajectories.emplace_back(trajectoryBuffer);
+    collisionNodes.emplace_back(leafNode);
+    ++collisionCount;
 }
 
 bool SearchThread::nodes_limits_ok()
@@ -341,6 +558,100 @@ size_t SearchThread::get_avg_depth()
     return size_t(double(depthSum) / (rootNode->get_visits() - visitsPreSearch) + 0.5);
 }
 
+void SearchThread::handle_leaf(Node* newNode, const NodeDescription& description, size_t& numTerminalNodes)
+{
+    depthSum += description.depth;
+    depthMax = max(depthMax, description.depth);
+    ++descentCount;
+
+    if(description.type == NODE_TERMINAL) {
+        ++numTerminalNodes;
+        backup_value<true>(newNode->get_value(), searchSettings, trajectoryBuffer, searchSettings->mctsSolver);
+    }
+    else if (description.type == NODE_COLLISION) {
+        // store a pointer to the collision node in order to revert the virtual loss of the forward propagation
+        add_collision(newNode);
+    }
+    else if (description.type == NODE_TRANSPOSITION) {
+        transpositionTrajectories.emplace_back(trajectoryBuffer);
+    }
+    else if (description.type == NODE_NN_CACHE) {
+        // cache hits don't fill the batch, so they are bounded like terminal nodes
+        ++numTerminalNodes;
+        backup_value<false>(newNode->get_value(), searchSettings, trajectoryBuffer, false);
+    }
+    else {  // NODE_NEW_NODE
+        newNodes->add_element(newNode);
+        newTrajectories.emplace_back(trajectoryBuffer);
+    }
+}
+
+void SearchThread::handle_leaf_with_budget(Node* newNode, const NodeDescription& description, Budget budget, size_t& numTerminalNodes)
+{
+    handle_leaf(newNode, description, numTerminalNodes);
+    for (Budget visit = 1; visit < budget; ++visit) {
+        ++descentCount;
+        switch (description.type) {
+        case NODE_TERMINAL:
+            // terminal values are known, so every visit can be backed up
+            backup_value<true>(newNode->get_value(), searchSettings, trajectoryBuffer, searchSettings->mctsSolver);
+            break;
+        case NODE_NN_CACHE:
+            backup_value<false>(newNode->get_value(), searchSettings, trajectoryBuffer, false);
+            break;
+        case NODE_TRANSPOSITION:
+            // every visit adds at most one value, so the budget never exceeds the capacity
+            transpositionValues->add_element(transpositionValues->get_element(transpositionValues->size() - 1));
+            transpositionTrajectories.emplace_back(trajectoryBuffer);
+            break;
+        default:
+            // the remaining visits wait for the evaluation of the leaf like collisions
+            add_collision(newNode);
+        }
+    }
+}
+
+void SearchThread::descend_with_budget(Node* currentNode, Budget budget, size_t depth, size_t& numTerminalNodes)
+{
+    currentNode->lock();
+    const NodeSplit nodeSplit = currentNode->select_child_nodes(searchSettings, budget);
+    // the virtual losses of the whole budget are applied at once, so that other threads are steered away immediately
+    for (Budget visit = 0; visit < nodeSplit.firstBudget; ++visit) {
+        currentNode->apply_virtual_loss_to_child(nodeSplit.firstArg, searchSettings);
+    }
+    for (Budget visit = 0; visit < nodeSplit.secondBudget; ++visit) {
+        currentNode->apply_virtual_loss_to_child(nodeSplit.secondArg, searchSettings);
+    }
+    currentNode->unlock();
+
+    visit_child_with_budget(currentNode, nodeSplit.firstArg, nodeSplit.firstBudget, depth, numTerminalNodes);
+    if (nodeSplit.secondBudget != 0) {
+        visit_child_with_budget(currentNode, nodeSplit.secondArg, nodeSplit.secondBudget, depth, numTerminalNodes);
+    }
+}
+
+void SearchThread::visit_child_with_budget(Node* currentNode, ChildIdx childIdx, Budget budget, size_t depth, size_t& numTerminalNodes)
+{
+    NodeDescription description;
+    description.depth = depth + 1;
+    trajectoryBuffer.emplace_back(NodeAndIdx(currentNode, childIdx));
+    currentNode->lock();
+    Node* nextNode = visit_child(currentNode, childIdx, description);
+    if (description.type == NODE_UNKNOWN) {
+#ifndef MCTS_STORE_STATES
+        actionsBuffer.emplace_back(currentNode->get_action(childIdx));
+#endif
+        descend_with_budget(nextNode, budget, depth + 1, numTerminalNodes);
+#ifndef MCTS_STORE_STATES
+        actionsBuffer.pop_back();
+#endif
+    }
+    else {
+        handle_leaf_with_budget(nextNode, description, budget, numTerminalNodes);
+    }
+    trajectoryBuffer.pop_back();
+}
+
 void SearchThread::create_mini_batch()
 {
     // select nodes to add to the mini-batch
@@ -348,54 +659,135 @@ void SearchThread::create_mini_batch()
     size_t numTerminalNodes = 0;
 
     while (!newNodes->is_full() &&
-           collisionTrajectories.size() != searchSettings->batchSize &&
+           collisionTrajectories.size() < searchSettings->batchSize &&
            !transpositionValues->is_full() &&
            numTerminalNodes < terminalNodeCache) {
 
         trajectoryBuffer.clear();
         actionsBuffer.clear();
-        Node* newNode = get_new_child_to_evaluate(description);
-        depthSum += description.depth;
-        depthMax = max(depthMax, description.depth);
-
-        if(description.type == NODE_TERMINAL) {
-            ++numTerminalNodes;
-            backup_value<true>(newNode->get_value(), searchSettings, trajectoryBuffer, searchSettings->mctsSolver);
-        }
-        else if (description.type == NODE_COLLISION) {
-            // store a pointer to the collision node in order to revert the virtual loss of the forward propagation
-            collisionTrajectories.emplace_back(trajectoryBuffer);
-        }
-        else if (description.type == NODE_TRANSPOSITION) {
-            transpositionTrajectories.emplace_back(trajectoryBuffer);
-        }
-        else {  // NODE_NEW_NODE
-            newNodes->add_element(newNode);
-            newTrajectories.emplace_back(trajectoryBuffer);
+        if (searchSettings->budgetDescent) {
+            // every leaf can add at most one new node and one transposition value
+            const Budget budget = min(newNodes->capacity() - newNodes->size(), transpositionValues->capacity() - transpositionValues->size());
+            descend_with_budget(rootNode, budget, 0, numTerminalNodes);
+            continue;
         }
+        Node* newNode = get_new_child_to_evaluate(description);
+        handle_leaf(newNode, description, numTerminalNodes);
     }
 }
 
 void SearchThread::thread_iteration()
 {
+    // the nodes which are found in the transposition table can't be freed by the garbage collector during the iteration
+    EpochGuard epochGuard(transpositionTable->get_epoch_manager(), epochSlot);
+#ifndef SEARCH_UCT
+    // the number of buffer sets is fixed at construction, the option might have been changed afterwards
+    if (searchSettings->pipelineInference && bufferSets.size() > 1) {
+        thread_iteration_pipelined();
+        return;
+    }
+#endif
     create_mini_batch();
 #ifndef SEARCH_UCT
     if (newNodes->size() != 0) {
-        net->predict(inputPlanes, valueOutputs, probOutputs, auxiliaryOutputs);
-        set_nn_results_to_child_nodes();
+        predict_batch(bufferSets[activeBufferSet], newNodes->size());
+        set_nn_results_to_child_nodes(*newNodes, *newNodeSideToMove, bufferSets[activeBufferSet]);
     }
 #endif
     backup_value_outputs();
     backup_collisions();
 }
 
+void SearchThread::thread_iteration_pipelined()
+{
+    // the nodes of the pending mini-batch don't have NN results yet and are treated as collisions
+    create_mini_batch();
+    // terminals and transpositions don't depend on the neural network
+    backup_values(transpositionValues.get(), transpositionTrajectories);
+
+    const bool hasPendingBatch = pendingInference.valid();
+    if (hasPendingBatch) {
+        pendingInference.get();
+    }
+    if (newNodes->size() != 0) {
+        // only a single inference is running at a time because the backends are not thread-safe
+        const InferenceBuffers& buffers = bufferSets[activeBufferSet];
+        const size_t numberEntries = newNodes->size();
+        // the pool keeps its workers parked between the mini-batches instead of starting a new thread for every inference
+        pendingInference = threadPool->submit([this, buffers, numberEntries]() {
+            predict_batch(buffers, numberEntries);
+        });
+    }
+    if (hasPendingBatch) {
+        process_pending_batch();
+    }
+    // collisions on the nodes of the pending mini-batch can now be reused as visits
+    backup_collisions();
+    if (newNodes->size() != 0) {
+        swap(newNodes, pendingNodes);
+        swap(newNodeSideToMove, pendingNodeSideToMove);
+        swap(newTrajectories, pendingTrajectories);
+        pendingBufferSet = activeBufferSet;
+        set_active_buffer_set((activeBufferSet + 1) % bufferSets.size());
+    }
+}
+
+void SearchThread::predict_batch(const InferenceBuffers& buffers, size_t numberEntries)
+{
+    if (inferenceServer != nullptr) {
+        inferenceServer->predict(buffers.inputPlanes, buffers.valueOutputs, buffers.probOutputs, buffers.auxiliaryOutputs, numberEntries);
+        return;
+    }
+    net->predict(buffers.inputPlanes, buffers.valueOutputs, buffers.probOutputs, buffers.auxiliaryOutputs, numberEntries);
+}
+
+void SearchThread::process_pending_batch()
+{
+    set_nn_results_to_child_nodes(*pendingNodes, *pendingNodeSideToMove, bufferSets[pendingBufferSet]);
+    backup_values(*pendingNodes, pendingTrajectories);
+    pendingNodeSideToMove->reset_idx();
+}
+
+void SearchThread::prune_tree_if_necessary()
+{
+    if (treePruner->is_prune_due(searchSettings)) {
+        // the pending mini-batch holds pointers into the tree
+        finish_pending_batch();
+        treePruner->sync_and_prune(rootNode, searchSettings);
+    }
+}
+
+TreePruner* SearchThread::get_tree_pruner() const
+{
+    return treePruner;
+}
+
+void SearchThread::finish_pending_batch()
+{
+    if (pendingInference.valid()) {
+        pendingInference.get();
+        process_pending_batch();
+    }
+}
+
 void run_search_thread(SearchThread *t)
 {
     t->set_is_running(true);
     t->reset_stats();
+    t->get_tree_pruner()->connect_thread();
+    InferenceServer* inferenceServer = t->get_inference_server();
+    if (inferenceServer != nullptr) {
+        inferenceServer->connect_client();
+    }
     while(t->is_running() && t->nodes_limits_ok() && t->is_root_node_unsolved()) {
+        t->prune_tree_if_necessary();
         t->thread_iteration();
     }
+    t->finish_pending_batch();
+    t->get_tree_pruner()->disconnect_thread();
+    if (inferenceServer != nullptr) {
+        inferenceServer->disconnect_client();
+    }
     t->set_is_running(false);
 }
 
@@ -404,11 +796,17 @@ void SearchThread::backup_values(FixedVector<Node*>& nodes, vector<Trajectory>&
         Node* node = nodes.get_element(idx);
 #ifdef MCTS_TB_SUPPORT
         const bool solveForTerminal = searchSettings->mctsSolver && node->is_tablebase();
-        backup_value<false>(node->get_value(), searchSettings, trajectories[idx], solveForTerminal);
 #else
-        backup_value<false>(node->get_value(), searchSettings, trajectories[idx], false);
+        const bool solveForTerminal = false;
 #endif
+        if (searchSettings->batchedBackup) {
+            backupTree.add_trajectory<false>(node->get_value(), searchSettings, trajectories[idx], solveForTerminal);
+        }
+        else {
+            backup_value<false>(node->get_value(), searchSettings, trajectories[idx], solveForTerminal);
+        }
     }
+    backupTree.backup<false>(searchSettings);
     nodes.reset_idx();
     trajectories.clear();
 }
@@ -416,21 +814,33 @@ void SearchThread::backup_values(FixedVector<Node*>& nodes, vector<Trajectory>&
 void SearchThread::backup_values(FixedVector<float>* values, vector<Trajectory>& trajectories) {
     for (size_t idx = 0; idx < values->size(); ++idx) {
         const float value = values->get_element(idx);
-        backup_value<true>(value, searchSettings, trajectories[idx], false);
+        if (searchSettings->batchedBackup) {
+            backupTree.add_trajectory<true>(value, searchSettings, trajectories[idx], false);
+        }
+        else {
+            backup_value<true>(value, searchSettings, trajectories[idx], false);
+        }
     }
+    backupTree.backup<true>(searchSettings);
     values->reset_idx();
     trajectories.clear();
 }
 
-ChildIdx SearchThread::select_enhanced_move(Node* currentNode) const {
+ChildIdx SearchThread::select_enhanced_move(Node* currentNode) {
     if (currentNode->is_playout_node() && !currentNode->was_inspected() && !currentNode->is_terminal()) {
 
         // iterate over the current state
+#if defined(SF_DEPENDENCY) && !defined(MCTS_STORE_STATES)
+        StateObj* pos = get_synced_search_state();
+#else
         unique_ptr<StateObj> pos = unique_ptr<StateObj>(rootState->clone());
         for (Action action : actionsBuffer) {
             pos->do_action(action);
         }
+#endif
 
+        // revealing moves must not reorder the remaining moves while they are scanned
+        currentNode->sort_moves_up_to(currentNode->get_number_child_nodes() - 1);
         // make sure a check has been explored at least once
         for (size_t childIdx = currentNode->get_no_visit_idx(); childIdx < currentNode->get_number_child_nodes(); ++childIdx) {
             if (pos->gives_check(currentNode->get_action(childIdx))) {
@@ -468,8 +878,8 @@ void node_post_process_policy(Node *node, float temperature, const SearchSetting
     node->apply_temperature_to_prior_policy(temperature);
 }
 
-size_t get_random_depth()
+size_t get_random_depth(Xoshiro256& randomGenerator)
 {
-    const int randInt = rand() % 100 + 1;
+    const int randInt = randomGenerator.below(100) + 1;
     return std::ceil(-std::log2(1 - randInt / 100.0) - 1);
 }
@@ -28,12 +28,20 @@
 #ifndef SEARCHTHREAD_H
 #define SEARCHTHREAD_H
 
+#include <future>
 #include "node.h"
 #include "constants.h"
 #include "neuralnetapi.h"
 #include "config/searchlimits.h"
 #include "util/fixedvector.h"
 #include "nn/neuralnetapiuser.h"
+#include "nn/inferenceserver.h"
+#include "nncache.h"
+#include "treepruner.h"
+#include "rootpartitioner.h"
+#include "backuptree.h"
+#include "util/randomgen.h"
+#include "util/threadpool.h"
 
 
 enum NodeBackup : uint8_t {
@@ -41,6 +49,7 @@ enum NodeBackup : uint8_t {
     NODE_TERMINAL,
     NODE_TRANSPOSITION,
     NODE_NEW_NODE,
+    NODE_NN_CACHE,
     NODE_UNKNOWN,
 };
 
@@ -66,18 +75,56 @@ private:
     vector<Trajectory> newTrajectories;
     vector<Trajectory> transpositionTrajectories;
     vector<Trajectory> collisionTrajectories;
+    // leaf node of each collision trajectory, the collision is backed up as an additional visit if the leaf has been evaluated in the meantime
+    vector<Node*> collisionNodes;
 
     Trajectory trajectoryBuffer;
+    // prefix tree of the trajectories of the current backup
+    BackupTree backupTree;
     vector<Action> actionsBuffer;
+#if defined(SF_DEPENDENCY) && !defined(MCTS_STORE_STATES)
+    // copy of the root state which follows the descents by do_action() and undo_action()
+    unique_ptr<StateObj> searchState;
+    // actions which are currently applied to searchState starting from the root state
+    vector<Action> searchStateActions;
+#endif
+
+    // mini-batch which is currently evaluated by the neural network (only used for pipelined inference)
+    unique_ptr<FixedVector<Node*>> pendingNodes;
+    unique_ptr<FixedVector<SideToMove>> pendingNodeSideToMove;
+    vector<Trajectory> pendingTrajectories;
+    size_t pendingBufferSet;
+    future<void> pendingInference;
+    // worker pool which runs the inference of the pending mini-batch
+    ThreadPool* threadPool;
+
+    // optional shared inference service, if nullptr the thread uses its own network handle
+    InferenceServer* inferenceServer;
 
     bool isRunning;
 
-    MapWithMutex* mapWithMutex;
+    TranspositionTable* transpositionTable;
+    NNCache* nnCache;
+    TreePruner* treePruner;
+    // optional partitioner of the root child nodes and the partition which is searched by this thread
+    RootPartitioner* rootPartitioner;
+    size_t rootPartitionIdx;
+    // generator for the random explorations of this thread, it's reseeded before every search
+    Xoshiro256 randomGenerator;
+    // slot of this thread in the epoch manager of the transposition table
+    size_t epochSlot;
     const SearchSettings* searchSettings;
     SearchLimits* searchLimits;
     size_t tbHits;
     size_t depthSum;
     size_t depthMax;
+    // number of descents of the current search, the number of them which ended in a collision and how many collisions were reused as visits
+    size_t descentCount;
+    size_t collisionCount;
+    size_t reusedCollisionCount;
+    // number of node expansions of the current search and the time which was spent on them
+    size_t expansionCount;
+    size_t expansionTimeNS;
     size_t visitsPreSearch;
     uint_fast32_t terminalNodeCache;  // TODO: better add "const" classifier here is possible
     bool reachedTablebases;
@@ -86,9 +133,16 @@ public:
      * @brief SearchThread
      * @param netBatch Network API object which provides the prediction of the neural network
      * @param searchSettings Given settings for this search run
-     * @param MapWithMutex Handle to the hash table
+     * @param transpositionTable Handle to the hash table
+     * @param nnCache Handle to the cache of neural network evaluations
+     * @param treePruner Handle to the pruner which keeps the tree within the memory budget
+     * @param threadPool Worker pool of the agent which runs the pipelined inference
+     * @param inferenceServer Optional shared inference service. If given, netBatch is only used to query the network properties.
      */
-    SearchThread(NeuralNetAPI* netBatch, const SearchSettings* searchSettings, MapWithMutex* mapWithMutex);
+    SearchThread(NeuralNetAPI* netBatch, const SearchSettings* searchSettings, TranspositionTable* transpositionTable, NNCache* nnCache, TreePruner* treePruner, ThreadPool* threadPool, InferenceServer* inferenceServer = nullptr);
+    ~SearchThread();
+    SearchThread(const SearchThread&) = delete;
+    SearchThread& operator=(const SearchThread&) = delete;
 
     /**
      * @brief create_mini_batch Creates a mini-batch of new unexplored nodes.
@@ -103,6 +157,23 @@ public:
      */
     void thread_iteration();
 
+    /**
+     * @brief thread_iteration_pipelined Fills a new mini-batch while the previous mini-batch is still evaluated by the neural network.
+     * The results of the previous mini-batch are assigned and backpropagated while the new mini-batch is being evaluated.
+     */
+    void thread_iteration_pipelined();
+
+    /**
+     * @brief finish_pending_batch Waits for a pending neural network evaluation and backpropagates its results.
+     * Does nothing if no mini-batch is pending.
+     */
+    void finish_pending_batch();
+
+    /**
+     * @brief prune_tree_if_necessary Frees low-visit subtrees together with the other search threads if the tree exceeds its memory budget
+     */
+    void prune_tree_if_necessary();
+
     /**
      * @brief nodes_limits_ok Checks if the searchLimits based on the amount of nodes to search has been reached.
      * In the case the number of nodes is set to zero the limit condition is ignored
@@ -129,6 +200,21 @@ public:
     bool is_running() const;
     void set_is_running(bool value);
     void set_reached_tablebases(bool value);
+    InferenceServer* get_inference_server() const;
+    TreePruner* get_tree_pruner() const;
+
+    /**
+     * @brief set_root_partition Restricts the selection at the root node to the given partition of the root child nodes
+     * @param rootPartitioner Root partitioner, the partitioning is only used while it's active (nullptr: disabled)
+     * @param partitionIdx Partition which is searched by this thread
+     */
+    void set_root_partition(RootPartitioner* rootPartitioner, size_t partitionIdx);
+
+    /**
+     * @brief seed_random_generator Reseeds the random generator of this thread, a fixed seed makes a single-threaded search reproducible
+     * @param seed Seed
+     */
+    void seed_random_generator(uint64_t seed);
 
     /**
      * @brief add_new_node_to_tree Adds a new node to the search by either creating a new node or duplicating an exisiting node in case of transposition usage
@@ -152,13 +238,53 @@ public:
 
     size_t get_max_depth() const;
 
+    /**
+     * @brief get_expansion_count Returns the number of nodes which were expanded during the current search
+     */
+    size_t get_expansion_count() const;
+
+    /**
+     * @brief get_expansion_time_ns Returns the time in nano seconds which was spent on node expansions during the current search
+     */
+    size_t get_expansion_time_ns() const;
+
+    /**
+     * @brief get_descent_count Returns the number of descents of the current search
+     */
+    size_t get_descent_count() const;
+
+    /**
+     * @brief get_collision_count Returns the number of descents of the current search which ended in a collision
+     */
+    size_t get_collision_count() const;
+
+    /**
+     * @brief get_reused_collision_count Returns the number of collisions which were backed up as an additional visit of their leaf node
+     */
+    size_t get_reused_collision_count() const;
+
     Node* get_starting_node(Node* currentNode, NodeDescription& description, ChildIdx& childIdx);
 
 private:
     /**
      * @brief set_nn_results_to_child_nodes Sets the neural network value evaluation and policy prediction vector for every newly expanded nodes
+     * @param nodes Newly expanded nodes of the mini-batch
+     * @param sideToMove Side to move for each newly expanded node
+     * @param buffers Buffer set which holds the neural network outputs of the mini-batch
+     */
+    void set_nn_results_to_child_nodes(FixedVector<Node*>& nodes, FixedVector<SideToMove>& sideToMove, const InferenceBuffers& buffers);
+
+    /**
+     * @brief predict_batch Runs the neural network inference for the given buffer set either directly or via the inference server
+     * @param buffers Buffer set of the mini-batch
+     * @param numberEntries Number of filled entries in the mini-batch
+     */
+    void predict_batch(const InferenceBuffers& buffers, size_t numberEntries);
+
+    /**
+     * @brief process_pending_batch Assigns the neural network results of the pending mini-batch and backpropagates them
      */
-    void set_nn_results_to_child_nodes();
+    void process_pending_batch();
 
     /**
      * @brief backup_value_outputs Backpropagates all newly received value evaluations from the neural network accross the visited search paths
@@ -166,10 +292,18 @@ private:
     void backup_value_outputs();
 
     /**
-     * @brief backup_collisions Reverts the applied virtual loss for all rollouts which ended in a collision event
+     * @brief backup_collisions Backs up all rollouts which ended in a collision event.
+     * If the leaf node has received its neural network evaluation in the meantime, the rollout is backed up with the leaf's value
+     * as an additional visit (multi-visit), otherwise only the applied virtual loss is reverted.
      */
     void backup_collisions();
 
+    /**
+     * @brief add_collision Adds the current trajectory buffer as a collision event at the given leaf node
+     * @param leafNode Leaf node which was pending for its neural network evaluation
+     */
+    void add_collision(Node* leafNode);
+
     /**
      * @brief get_new_child_to_evaluate Traverses the search tree beginning from the root node and returns the prarent node and child index for the next node to expand.
      * @param description Output struct which holds information what type of node it is
@@ -177,6 +311,71 @@ private:
      */
     Node* get_new_child_to_evaluate(NodeDescription& description);
 
+    /**
+     * @brief expand_node Expands a newly created shell node and measures the time of the expansion
+     * @param node Shell node
+     * @param state Corresponding state object
+     */
+    void expand_node(Node* node, StateObj* state);
+
+    /**
+     * @brief visit_child Handles the given child after its virtual loss has been applied and it was added to the trajectory buffer.
+     * The current node must be locked and is unlocked by this method.
+     * @param currentNode Current node
+     * @param childIdx Selected child index
+     * @param description Output struct which holds the type of the reached node. NODE_UNKNOWN means that the descent continues at the returned node.
+     * @return Child node
+     */
+    Node* visit_child(Node* currentNode, ChildIdx childIdx, NodeDescription& description);
+
+    /**
+     * @brief visit_partitioned_root_child Handles the given root child after it has been selected in the partition of this thread.
+     * The root node is only locked if the child node needs to be created or is a transposition.
+     * @param childIdx Selected root child index
+     * @param description Output struct which holds the type of the reached node. NODE_UNKNOWN means that the descent continues at the returned node.
+     * @return Child node
+     */
+    Node* visit_partitioned_root_child(ChildIdx childIdx, NodeDescription& description);
+
+    /**
+     * @brief visit_child_lock_free Selects a child node and applies its virtual loss without locking the current node (lock-free updates only).
+     * This only succeeds if the selection doesn't reveal a new child and the child node is an evaluated, non-terminal node without transpositions.
+     * @param currentNode Current node
+     * @param childIdx Selected child index
+     * @param description Output struct which holds the type of the reached node
+     * @return Child node or nullptr if the child must be selected and visited while holding the lock
+     */
+    Node* visit_child_lock_free(Node* currentNode, ChildIdx& childIdx, NodeDescription& description);
+
+    /**
+     * @brief handle_leaf Adds the final node of a descent to the mini-batch or backpropagates it directly
+     * @param newNode Final node of the descent
+     * @param description Type and depth of the final node
+     * @param numTerminalNodes Counter for the number of nodes which were backpropagated without the neural network
+     */
+    void handle_leaf(Node* newNode, const NodeDescription& description, size_t& numTerminalNodes);
+
+    /**
+     * @brief handle_leaf_with_budget Handles a leaf which was reached with multiple visits. Terminal nodes, cache hits and transpositions are
+     * backed up for every visit, all other leaves use one visit and the remaining visits are handled as collisions.
+     */
+    void handle_leaf_with_budget(Node* newNode, const NodeDescription& description, Budget budget, size_t& numTerminalNodes);
+
+    /**
+     * @brief descend_with_budget Distributes a budget of visits from the given node to its best two child nodes and continues recursively
+     * until the visits reach leaf nodes. This replaces one descent per visit by a single traversal.
+     * @param currentNode Node which has NN results
+     * @param budget Number of visits
+     * @param depth Depth of the current node
+     * @param numTerminalNodes Counter for the number of nodes which were backpropagated without the neural network
+     */
+    void descend_with_budget(Node* currentNode, Budget budget, size_t depth, size_t& numTerminalNodes);
+
+    /**
+     * @brief visit_child_with_budget Continues the budget descent at the given child node, its virtual losses must have been applied already
+     */
+    void visit_child_with_budget(Node* currentNode, ChildIdx childIdx, Budget budget, size_t depth, size_t& numTerminalNodes);
+
     void backup_values(FixedVector<Node*>& nodes, vector<Trajectory>& trajectories);
     void backup_values(FixedVector<float>* values, vector<Trajectory>& trajectories);
 
@@ -185,7 +384,26 @@ private:
      * @param currentNode Current node during forward simulation
      * @return uint_16_t(-1) for no action else custom idx
      */
-    ChildIdx select_enhanced_move(Node* currentNode) const;
+    ChildIdx select_enhanced_move(Node* currentNode);
+
+#if defined(SF_DEPENDENCY) && !defined(MCTS_STORE_STATES)
+    /**
+     * @brief get_synced_search_state Brings the search state to the position after all actions of the actionsBuffer.
+     * Only the actions after the first difference to the previous descent are undone and applied.
+     * @return Pointer to the search state
+     */
+    StateObj* get_synced_search_state();
+#endif
+
+#ifndef SEARCH_UCT
+    /**
+     * @brief probe_nn_cache Assigns the policy and value of a new node from the neural network cache
+     * @param node New node which hasn't been evaluated yet
+     * @param sideToMove Side to move of the new node
+     * @return True, if the evaluation was found in the cache
+     */
+    bool probe_nn_cache(Node* node, SideToMove sideToMove);
+#endif
 
     /**
      * @brief get_current_transposition_q_value Returns the Q-value which connects to the transposition node
@@ -199,7 +417,8 @@ private:
 
 void run_search_thread(SearchThread *t);
 
-void fill_nn_results(size_t batchIdx, bool isPolicyMap, const float* valueOutputs, const float* probOutputs, const float* auxiliaryOutputs, Node *node, size_t& tbHits, bool mirrorPolicy, const SearchSettings* searchSettings, bool isRootNodeTB);
+void fill_nn_results(size_t batchIdx, bool isPolicyMap, const float* valueOutputs, const float* probOutputs, const float* auxiliaryOutputs, Node *node, size_t& tbHits, bool mirrorPolicy, const SearchSettings* searchSettings, bool isRootNodeTB,
+                     NNCache* nnCache = nullptr, SideToMove sideToMove = 0);
 void node_post_process_policy(Node *node, float temperature, const SearchSettings* searchSettings);
 void node_assign_value(Node *node, const float* valueOutputs, size_t& tbHits, size_t batchIdx, bool isRootNodeTB);
 
@@ -207,8 +426,9 @@ void node_assign_value(Node *node, const float* valueOutputs, size_t& tbHits, si
  * @brief random_root_playout Uses random move exploration (epsilon greedy) from the given position. The probability for doing a random move decays by depth.
  * @param currentNode Current node during trajectory
  * @param childIdx Return child index (maybe unchanged)
+ * @param randomGenerator Random generator of the search thread
  */
-inline void random_playout(Node* currentNode, ChildIdx& childIdx);
+inline void random_playout(Node* currentNode, ChildIdx& childIdx, Xoshiro256& randomGenerator);
 
 /**
  * @brief get_random_depth
@@ -220,8 +440,9 @@ inline void random_playout(Node* currentNode, ChildIdx& childIdx);
  * DEPTH 4: 95 - 97
  * DEPTH 5: 98 - 99
  * DEPTH 6: 100
+ * @param randomGenerator Random generator of the search thread
  * @return random depth while the probability of choosing higher depths decreases exponetially
  */
-size_t get_random_depth();
+size_t get_random_depth(Xoshiro256& randomGenerator);
 
 #endif // SEARCHTHREAD_H
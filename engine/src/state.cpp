@@ -25,6 +25,7 @@
 
 #include "state.h"
 #include "constants.h"
+#include "util/randomgen.h"
 
 TerminalType invert_terminal_type(TerminalType terminalType) {
     switch (terminalType) {
@@ -75,7 +76,7 @@ TerminalType State::random_rollout(float& customValueTerminal)
             }
             return invert_terminal_type(terminalType);
         }
-        const size_t actionIdx = rand() % numberActions;
+        const size_t actionIdx = get_generator().below(numberActions);
         const Action action = actions[actionIdx];
         this->do_action(action);
     }
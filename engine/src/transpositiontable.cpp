@@ -0,0 +1,163 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: transpositiontable.cpp
+ * Created on 18.10.2026
+ * @author: queensgambit
+ */
+
+#include "transpositiontable.h"
+#include "node.h"
+#include "util/atomicutil.h"
+
+TranspositionTable::TranspositionTable(size_t sizeMB) :
+    sizeMB(0),
+    generation(0)
+{
+    resize(sizeMB);
+}
+
+size_t TranspositionTable::get_bucket_idx(Key key) const
+{
+    return size_t(uint64_t(key) % buckets.size());
+}
+
+mutex& TranspositionTable::get_lock(size_t bucketIdx)
+{
+    return locks[bucketIdx & (TT_NUMBER_LOCKS - 1)].mtx;
+}
+
+size_t TranspositionTable::get_replacement_idx(Bucket& bucket) const
+{
+    size_t replaceIdx = 0;
+    double minWorth = numeric_limits<double>::max();
+    for (size_t idx = 0; idx < TT_BUCKET_SIZE; ++idx) {
+        const Node* node = bucket.nodes[idx];
+        if (node == nullptr) {
+            return idx;
+        }
+        const uint8_t age = generation - bucket.generations[idx];
+        const double worth = double(node->get_real_visits()) / (age + 1);
+        if (worth < minWorth) {
+            minWorth = worth;
+            replaceIdx = idx;
+        }
+    }
+    return replaceIdx;
+}
+
+Node* TranspositionTable::find(Key key)
+{
+    Bucket& bucket = buckets[get_bucket_idx(key)];
+    for (size_t idx = 0; idx < TT_BUCKET_SIZE; ++idx) {
+        if (atomic_load(bucket.keys[idx]) == key) {
+            Node* node = as_atomic(bucket.nodes[idx]).load(memory_order_acquire);
+            // the key and the node are written separately, so the entry might have been replaced in between
+            if (node != nullptr && node->hash_key() == key) {
+                as_atomic(bucket.generations[idx]).store(generation, memory_order_relaxed);
+                return node;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void TranspositionTable::insert(Key key, Node* node)
+{
+    const size_t bucketIdx = get_bucket_idx(key);
+    Bucket& bucket = buckets[bucketIdx];
+    lock_guard<mutex> lock(get_lock(bucketIdx));
+    size_t entryIdx = TT_BUCKET_SIZE;
+    for (size_t idx = 0; idx < TT_BUCKET_SIZE; ++idx) {
+        if (bucket.keys[idx] == key) {
+            if (bucket.nodes[idx] != nullptr) {
+                return;
+            }
+            entryIdx = idx;
+            break;
+        }
+    }
+    if (entryIdx == TT_BUCKET_SIZE) {
+        entryIdx = get_replacement_idx(bucket);
+    }
+    as_atomic(bucket.keys[entryIdx]).store(key, memory_order_relaxed);
+    as_atomic(bucket.nodes[entryIdx]).store(node, memory_order_release);
+    as_atomic(bucket.generations[entryIdx]).store(generation, memory_order_relaxed);
+}
+
+bool TranspositionTable::erase(Key key, const Node* node)
+{
+    const size_t bucketIdx = get_bucket_idx(key);
+    Bucket& bucket = buckets[bucketIdx];
+    lock_guard<mutex> lock(get_lock(bucketIdx));
+    for (size_t idx = 0; idx < TT_BUCKET_SIZE; ++idx) {
+        if (bucket.keys[idx] == key && bucket.nodes[idx] == node) {
+            as_atomic(bucket.nodes[idx]).store(nullptr, memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void TranspositionTable::resize(size_t sizeMB)
+{
+    if (this->sizeMB == sizeMB && !buckets.empty()) {
+        return;
+    }
+    this->sizeMB = sizeMB;
+    const size_t numberBuckets = max(size_t(1), sizeMB * 1024 * 1024 / sizeof(Bucket));
+    buckets.clear();
+    buckets.shrink_to_fit();
+    buckets.resize(numberBuckets);
+    clear();
+}
+
+EpochManager& TranspositionTable::get_epoch_manager()
+{
+    return epochManager;
+}
+
+void TranspositionTable::new_search()
+{
+    ++generation;
+}
+
+void TranspositionTable::clear()
+{
+    for (Bucket& bucket : buckets) {
+        for (size_t idx = 0; idx < TT_BUCKET_SIZE; ++idx) {
+            bucket.keys[idx] = 0;
+            bucket.nodes[idx] = nullptr;
+            bucket.generations[idx] = 0;
+        }
+    }
+}
+
+size_t TranspositionTable::hashfull() const
+{
+    const size_t numberSamples = min(size_t(1000), buckets.size());
+    size_t numberFilled = 0;
+    for (size_t bucketIdx = 0; bucketIdx < numberSamples; ++bucketIdx) {
+        for (size_t idx = 0; idx < TT_BUCKET_SIZE; ++idx) {
+            numberFilled += buckets[bucketIdx].nodes[idx] != nullptr;
+        }
+    }
+    return numberFilled * 1000 / (numberSamples * TT_BUCKET_SIZE);
+}
@@ -0,0 +1,151 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: transpositiontable.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Thread safe hash table of a fixed memory size which maps the hash keys of the positions in the search graph to their nodes.
+ * The table consists of cache line sized buckets with TT_BUCKET_SIZE entries each. If a bucket is full, the entry which
+ * is worth the least based on its number of visits and its age gets replaced. Modifications are guarded by a fixed number of striped mutexes.
+ * Lookups don't take a lock. The entries hold raw pointers, so a node must be erased from the table before it's freed.
+ * Nodes which might still be read by a lookup are only freed after the epoch manager of the table has been synchronized.
+ */
+
+#ifndef TRANSPOSITIONTABLE_H
+#define TRANSPOSITIONTABLE_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "stateobj.h"
+#include "util/epochmanager.h"
+
+using namespace std;
+
+class Node;
+
+// number of lock stripes as a power of two
+#define TT_LOCK_BITS 10
+#define TT_NUMBER_LOCKS (1 << TT_LOCK_BITS)
+// number of entries within a single cache line sized bucket
+#define TT_BUCKET_SIZE 3
+
+class TranspositionTable
+{
+private:
+    struct alignas(64) Bucket {
+        Key keys[TT_BUCKET_SIZE];
+        Node* nodes[TT_BUCKET_SIZE];
+        // search generation in which the entry was last inserted or found
+        uint8_t generations[TT_BUCKET_SIZE];
+    };
+    // each lock is padded to a full cache line to avoid false sharing between the mutexes
+    struct PaddedMutex {
+        mutex mtx;
+        char padding[64];
+    };
+    vector<Bucket> buckets;
+    PaddedMutex locks[TT_NUMBER_LOCKS];
+    size_t sizeMB;
+    uint8_t generation;
+    // readers of the table which must have finished before an erased node can be freed
+    EpochManager epochManager;
+
+    /**
+     * @brief get_bucket_idx Returns the index of the bucket which is responsible for the given key
+     */
+    size_t get_bucket_idx(Key key) const;
+
+    /**
+     * @brief get_lock Returns the mutex which guards the given bucket
+     */
+    mutex& get_lock(size_t bucketIdx);
+
+    /**
+     * @brief get_replacement_idx Returns the index of the entry within the bucket which will be replaced by a new entry.
+     * Empty entries are used first, otherwise the entry with the least visits per age.
+     * @param bucket Bucket which must be locked by the caller
+     * @return Entry index
+     */
+    size_t get_replacement_idx(Bucket& bucket) const;
+
+public:
+    /**
+     * @brief TranspositionTable
+     * @param sizeMB Memory size of the table in mega bytes
+     */
+    TranspositionTable(size_t sizeMB);
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable& operator=(const TranspositionTable&) = delete;
+
+    /**
+     * @brief find Returns the node for the given key or nullptr if the key is unknown. The lookup doesn't take a lock.
+     * The caller must be inside of a critical section of get_epoch_manager() and
+     * has to acquire a reference by Node::try_acquire_reference() before it keeps the node beyond the critical section.
+     * @param key Hash key of a position
+     * @return Node pointer
+     */
+    Node* find(Key key);
+
+    /**
+     * @brief insert Adds the given node to the table. An existing entry for the same key is kept.
+     * @param key Hash key of the node
+     * @param node Node which will be stored without taking a reference
+     */
+    void insert(Key key, Node* node);
+
+    /**
+     * @brief erase Removes the entry of the given node if it's stored in the table
+     * @param key Hash key of the node
+     * @param node Node which is compared against the stored entry
+     * @return True, if the entry was removed
+     */
+    bool erase(Key key, const Node* node);
+
+    /**
+     * @brief resize Reallocates the table for the given memory size if it differs from the current size. All entries are removed in this case.
+     * Must not be called during search.
+     * @param sizeMB Memory size of the table in mega bytes
+     */
+    void resize(size_t sizeMB);
+
+    /**
+     * @brief new_search Increments the search generation which is used to age the entries
+     */
+    void new_search();
+
+    /**
+     * @brief clear Removes all entries
+     */
+    void clear();
+
+    /**
+     * @brief get_epoch_manager Returns the epoch manager which guards the lookups of the table
+     */
+    EpochManager& get_epoch_manager();
+
+    /**
+     * @brief hashfull Returns the fill level of the table in per mille based on a sample of the first buckets
+     */
+    size_t hashfull() const;
+};
+
+#endif // TRANSPOSITIONTABLE_H
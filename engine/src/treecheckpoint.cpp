@@ -0,0 +1,242 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: treecheckpoint.cpp
+ * Created on 18.10.2026
+ * @author: queensgambit
+ */
+
+#include "treecheckpoint.h"
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+#include "node.h"
+#include "util/communication.h"
+
+/**
+ * @brief is_stored_child Returns true if the given child node is part of a checkpoint.
+ * Child nodes which are still waiting for their neural network evaluation are skipped.
+ */
+inline bool is_stored_child(const Node* childNode)
+{
+    return childNode != nullptr && childNode->is_expanded() && (childNode->has_nn_results() || childNode->is_terminal());
+}
+
+bool save_tree_checkpoint(const Node* rootNode, const string& filename)
+{
+    // enumerate all nodes in breadth first order, every node is stored only once even if it has several parents
+    vector<const Node*> nodes;
+    unordered_map<const Node*, uint32_t> nodeIndices;
+    nodes.emplace_back(rootNode);
+    nodeIndices.emplace(rootNode, 0);
+    size_t numberMoves = 0;
+    for (size_t nodeIdx = 0; nodeIdx < nodes.size(); ++nodeIdx) {
+        const Node* node = nodes[nodeIdx];
+        numberMoves += node->get_number_child_nodes();
+        if (!node->is_playout_node()) {
+            continue;
+        }
+        for (ChildIdx childIdx = 0; childIdx < node->get_no_visit_idx(); ++childIdx) {
+            const Node* childNode = node->get_child_node(childIdx);
+            if (is_stored_child(childNode) && nodeIndices.emplace(childNode, nodes.size()).second) {
+                nodes.emplace_back(childNode);
+            }
+        }
+    }
+
+    ofstream outFile(filename, ios::binary);
+    if (!outFile) {
+        return false;
+    }
+    CheckpointHeader header = CheckpointHeader();
+    header.magic = TREE_CHECKPOINT_MAGIC;
+    header.version = TREE_CHECKPOINT_VERSION;
+    header.actionSize = sizeof(Action);
+    header.numberNodes = nodes.size();
+    header.numberMoves = numberMoves;
+    outFile.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // the moves are written in a second pass, so only the moves of a single node are kept in memory
+    vector<CheckpointMove> moves;
+    uint64_t firstMove = 0;
+    for (const Node* node : nodes) {
+        CheckpointNode record = CheckpointNode();
+        moves.assign(node->get_number_child_nodes(), CheckpointMove());
+        node->save_checkpoint(record, moves.data());
+        record.firstMove = firstMove;
+        firstMove += record.numberMoves;
+        outFile.write(reinterpret_cast<const char*>(&record), sizeof(record));
+    }
+    for (const Node* node : nodes) {
+        CheckpointNode record = CheckpointNode();
+        moves.assign(node->get_number_child_nodes(), CheckpointMove());
+        node->save_checkpoint(record, moves.data());
+        for (ChildIdx childIdx = 0; childIdx < record.noVisitIdx; ++childIdx) {
+            const Node* childNode = node->get_child_node(childIdx);
+            if (is_stored_child(childNode)) {
+                moves[childIdx].childNode = nodeIndices[childNode];
+            }
+        }
+        outFile.write(reinterpret_cast<const char*>(moves.data()), moves.size() * sizeof(CheckpointMove));
+    }
+    return bool(outFile);
+}
+
+/**
+ * @brief is_valid_record Checks if the moves and child node indices of a node record are within the bounds of the checkpoint
+ */
+bool is_valid_record(const CheckpointNode& record, const vector<CheckpointMove>& moves, size_t numberNodes)
+{
+    if (record.firstMove + record.numberMoves > moves.size() || record.noVisitIdx > record.numberMoves) {
+        return false;
+    }
+    for (size_t idx = record.firstMove; idx < record.firstMove + record.noVisitIdx; ++idx) {
+        if (moves[idx].childNode != NO_CHECKPOINT_CHILD && moves[idx].childNode >= numberNodes) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief has_legal_moves Checks if the moves of a node record are exactly the legal moves of the replayed state.
+ * The moves are stored in the order of their priors, so they are compared as sets. Terminal draws don't store any moves.
+ */
+bool has_legal_moves(const StateObj* state, const CheckpointNode& record, const vector<CheckpointMove>& moves)
+{
+    if (record.numberMoves == 0 && (record.flags & CHECKPOINT_TERMINAL)) {
+        return true;
+    }
+    vector<Action> legalActions = state->legal_actions();
+    if (legalActions.size() != record.numberMoves) {
+        return false;
+    }
+    vector<Action> recordActions(record.numberMoves);
+    for (size_t idx = 0; idx < record.numberMoves; ++idx) {
+        recordActions[idx] = moves[record.firstMove + idx].action;
+    }
+    sort(legalActions.begin(), legalActions.end());
+    sort(recordActions.begin(), recordActions.end());
+    return legalActions == recordActions;
+}
+
+/**
+ * @brief create_checkpoint_node Creates a node for the given state and restores its statistics from the checkpoint
+ * @param state State of the node, the ownership is handed over to the node if the states are stored in the nodes
+ * @param record Node record
+ * @param moves All move records of the checkpoint
+ * @return New node
+ */
+Node* create_checkpoint_node(unique_ptr<StateObj>& state, const CheckpointNode& record, const vector<CheckpointMove>& moves)
+{
+#ifdef MCTS_STORE_STATES
+    Node* node = new Node(state.release());
+    if (record.flags & CHECKPOINT_PLAYOUT_NODE) {
+        node->get_state()->prepare_action();
+    }
+#else
+    Node* node = new Node(state.get());
+#endif
+    node->load_checkpoint(record, moves.data() + record.firstMove);
+    return node;
+}
+
+Node* load_tree_checkpoint(const StateObj* rootState, const string& filename, TranspositionTable* transpositionTable, const SearchSettings* searchSettings)
+{
+    ifstream inFile(filename, ios::binary);
+    if (!inFile) {
+        info_string("tree checkpoint not found:", filename);
+        return nullptr;
+    }
+    CheckpointHeader header;
+    if (!inFile.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != TREE_CHECKPOINT_MAGIC ||
+            header.version != TREE_CHECKPOINT_VERSION || header.actionSize != sizeof(Action) || header.numberNodes == 0) {
+        info_string("incompatible tree checkpoint:", filename);
+        return nullptr;
+    }
+    vector<CheckpointNode> records(header.numberNodes);
+    vector<CheckpointMove> moves(header.numberMoves);
+    inFile.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(CheckpointNode));
+    inFile.read(reinterpret_cast<char*>(moves.data()), moves.size() * sizeof(CheckpointMove));
+    if (!inFile) {
+        info_string("truncated tree checkpoint:", filename);
+        return nullptr;
+    }
+    if (records[0].key != rootState->hash_key()) {
+        info_string("the tree checkpoint belongs to a different position");
+        return nullptr;
+    }
+
+    // the states are replayed depth first, every node is created by the first parent which reaches it
+    vector<Node*> nodes(records.size(), nullptr);
+    vector<pair<uint32_t, unique_ptr<StateObj>>> pendingNodes;
+    unique_ptr<StateObj> state = unique_ptr<StateObj>(rootState->clone());
+    if (!is_valid_record(records[0], moves, records.size()) || !has_legal_moves(state.get(), records[0], moves)) {
+        info_string("corrupted tree checkpoint:", filename);
+        return nullptr;
+    }
+    nodes[0] = create_checkpoint_node(state, records[0], moves);
+    pendingNodes.emplace_back(0, move(state));
+
+    while (!pendingNodes.empty()) {
+        const uint32_t nodeIdx = pendingNodes.back().first;
+        unique_ptr<StateObj> nodeState = move(pendingNodes.back().second);
+        pendingNodes.pop_back();
+        Node* node = nodes[nodeIdx];
+#ifdef MCTS_STORE_STATES
+        const StateObj* parentState = node->get_state();
+#else
+        const StateObj* parentState = nodeState.get();
+#endif
+        const CheckpointNode& record = records[nodeIdx];
+        for (ChildIdx childIdx = 0; childIdx < record.noVisitIdx; ++childIdx) {
+            const CheckpointMove& checkpointMove = moves[record.firstMove + childIdx];
+            if (checkpointMove.childNode == NO_CHECKPOINT_CHILD) {
+                continue;
+            }
+            Node* childNode = nodes[checkpointMove.childNode];
+            const CheckpointNode& childRecord = records[checkpointMove.childNode];
+            // the move is replayed for transpositions as well, so that every edge of the graph is validated
+            unique_ptr<StateObj> childState = unique_ptr<StateObj>(parentState->clone());
+            childState->do_action(checkpointMove.action);
+            if (childState->hash_key() != childRecord.key || (childNode == nullptr &&
+                    (!is_valid_record(childRecord, moves, records.size()) || !has_legal_moves(childState.get(), childRecord, moves)))) {
+                info_string("corrupted tree checkpoint:", filename);
+                release_node(nodes[0], transpositionTable);
+                return nullptr;
+            }
+            if (childNode != nullptr) {
+                // transposition to a node which has already been restored
+                childNode->acquire_reference();
+                childNode->add_transposition_parent_node();
+                node->set_child_node(childIdx, childNode);
+                continue;
+            }
+            childNode = create_checkpoint_node(childState, childRecord, moves);
+            nodes[checkpointMove.childNode] = childNode;
+            node->set_child_node(childIdx, childNode);
+            if (searchSettings->useMCGS) {
+                transpositionTable->insert(childNode->hash_key(), childNode);
+            }
+            pendingNodes.emplace_back(checkpointMove.childNode, move(childState));
+        }
+    }
+    return nodes[0];
+}
@@ -0,0 +1,116 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: treecheckpoint.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Binary snapshot of a search tree which allows to continue an analysis after a restart or to ship a pre-searched tree.
+ * The file consists of a header followed by a flat array of fixed size node records and a flat array of move records.
+ * The moves of each node are stored contiguously and the child nodes are referenced by their index in the node array,
+ * so transpositions of the search graph are preserved and the file can be memory-mapped as it is.
+ * All numbers are stored in the native byte order of the machine.
+ */
+
+#ifndef TREECHECKPOINT_H
+#define TREECHECKPOINT_H
+
+#include <string>
+#include "stateobj.h"
+
+class Node;
+class TranspositionTable;
+struct SearchSettings;
+
+#define TREE_CHECKPOINT_MAGIC 0x45455254415243ULL  // "CRATREE" in little endian
+#define TREE_CHECKPOINT_VERSION 1
+// index of a move which doesn't lead to a stored child node
+#define NO_CHECKPOINT_CHILD uint32_t(-1)
+
+enum CheckpointFlag : uint8_t {
+    CHECKPOINT_PLAYOUT_NODE = 1,
+    CHECKPOINT_TERMINAL = 2,
+    CHECKPOINT_TABLEBASE = 4,
+    CHECKPOINT_EVALUATED = 8,
+    CHECKPOINT_SORTED = 16,
+    CHECKPOINT_INSPECTED = 32
+};
+
+struct CheckpointHeader {
+    uint64_t magic;
+    uint32_t version;
+    // size of an action in bytes, it depends on the build and must match when loading
+    uint32_t actionSize;
+    uint64_t numberNodes;
+    uint64_t numberMoves;
+};
+
+struct CheckpointNode {
+    Key key;
+    double valueSum;
+    // index of the first move of this node in the move array
+    uint64_t firstMove;
+    uint32_t realVisitsSum;
+    uint32_t visitSum;
+    uint32_t freeVisits;
+    uint16_t numberMoves;
+    uint16_t noVisitIdx;
+    uint16_t sortedIdx;
+    uint16_t pliesFromNull;
+    uint16_t checkmateIdx;
+    uint16_t endInPly;
+    uint16_t numberUnsolvedChildNodes;
+    uint8_t nodeType;
+    uint8_t flags;
+};
+
+struct CheckpointMove {
+    Action action;
+    float prior;
+    float qValue;
+    uint32_t visits;
+    // index of the child node in the node array or NO_CHECKPOINT_CHILD
+    uint32_t childNode;
+    uint8_t nodeType;
+};
+
+/**
+ * @brief save_tree_checkpoint Writes the search tree below the given root node into a binary checkpoint file.
+ * Child nodes which are still waiting for their neural network evaluation aren't stored.
+ * Must not be called while a search is running.
+ * @param rootNode Root node of the tree
+ * @param filename Path of the checkpoint file
+ * @return true on success, false if the file couldn't be written
+ */
+bool save_tree_checkpoint(const Node* rootNode, const std::string& filename);
+
+/**
+ * @brief load_tree_checkpoint Restores a search tree from a binary checkpoint file.
+ * The states of all nodes are replayed from the given root state. Every edge, including the transpositions, is validated by the hash key
+ * of the reached position and the stored moves of every node must be the legal moves of its position.
+ * @param rootState State of the root position which must match the root of the checkpoint
+ * @param filename Path of the checkpoint file
+ * @param transpositionTable Transposition table in which all restored nodes are registered if MCGS is enabled
+ * @param searchSettings Search settings
+ * @return New root node which holds a single reference or nullptr if the file is missing, incompatible or belongs to a different position
+ */
+Node* load_tree_checkpoint(const StateObj* rootState, const std::string& filename, TranspositionTable* transpositionTable, const SearchSettings* searchSettings);
+
+#endif // TREECHECKPOINT_H
@@ -0,0 +1,184 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: treepruner.cpp
+ * Created on 18.10.2026
+ * @author: queensgambit
+ */
+
+#include "treepruner.h"
+#include <unordered_set>
+#include "util/communication.h"
+
+TreePruner::TreePruner(TranspositionTable* transpositionTable) :
+    activeThreads(0),
+    waitingThreads(0),
+    pruneRound(0),
+    transpositionTable(transpositionTable),
+    treeMemory(0),
+    memoryLimit(0)
+{
+}
+
+void TreePruner::set_active_threads(size_t numberThreads)
+{
+    lock_guard<mutex> lock(mtx);
+    activeThreads = numberThreads;
+    waitingThreads = 0;
+}
+
+void TreePruner::init_tree_memory(Node* rootNode, const SearchSettings* searchSettings)
+{
+    // the garbage collector may still free the old tree, but it never touches the nodes below the new root node
+    treeMemory = searchSettings->treeMemoryMB == 0 ? 0 : get_subtree_memory(rootNode);
+    memoryLimit = searchSettings->treeMemoryMB * 1024 * 1024;
+}
+
+void TreePruner::connect_thread()
+{
+    set_thread_tree_memory(&treeMemory);
+}
+
+void TreePruner::disconnect_thread()
+{
+    set_thread_tree_memory(nullptr);
+    lock_guard<mutex> lock(mtx);
+    --activeThreads;
+    // the remaining threads might be complete now
+    cv.notify_all();
+}
+
+size_t TreePruner::get_tree_memory() const
+{
+    return treeMemory.load(memory_order_relaxed);
+}
+
+bool TreePruner::is_prune_due(const SearchSettings* searchSettings) const
+{
+    return searchSettings->treeMemoryMB != 0 && get_tree_memory() > memoryLimit;
+}
+
+void TreePruner::sync_and_prune(Node* rootNode, const SearchSettings* searchSettings)
+{
+    unique_lock<mutex> lock(mtx);
+    const size_t round = pruneRound;
+    ++waitingThreads;
+    while (round == pruneRound) {
+        if (waitingThreads == activeThreads) {
+            // all search threads are outside of the tree
+            if (is_prune_due(searchSettings)) {
+                prune(rootNode, size_t(searchSettings->treeMemoryMB * 1024 * 1024 * PRUNE_TARGET_FRACTION));
+                if (get_tree_memory() > memoryLimit) {
+                    // the remaining nodes belong to the principal variation, solved or transposed subtrees
+                    memoryLimit = size_t(get_tree_memory() / PRUNE_TARGET_FRACTION);
+                    info_string("raised tree memory limit (MB):", memoryLimit / (1024 * 1024));
+                }
+            }
+            waitingThreads = 0;
+            ++pruneRound;
+            cv.notify_all();
+            return;
+        }
+        cv.wait(lock);
+    }
+}
+
+size_t TreePruner::collect_candidates(Node* rootNode, uint32_t maxVisits)
+{
+    size_t visitSum = 0;
+    vector<Node*> pendingNodes;
+    unordered_set<const Node*> visitedNodes;
+    pendingNodes.emplace_back(rootNode);
+    visitedNodes.insert(rootNode);
+    while (!pendingNodes.empty()) {
+        Node* node = pendingNodes.back();
+        pendingNodes.pop_back();
+        const ChildIdx bestIdx = node->max_visits_child();
+        for (ChildIdx childIdx = 0; childIdx < node->get_no_visit_idx(); ++childIdx) {
+            Node* childNode = node->get_child_node(childIdx);
+            if (childNode == nullptr || !childNode->is_playout_node()) {
+                continue;
+            }
+            const uint32_t childVisits = node->get_child_number_visits(childIdx);
+            if (childVisits <= maxVisits && node != rootNode && childIdx != bestIdx && is_prunable_node(childNode)) {
+                // a prunable node has a single parent, so it can't be collected twice
+                candidates.emplace_back(NodeAndIdx(node, childIdx));
+                visitSum += childVisits;
+            }
+            else if (visitedNodes.insert(childNode).second) {
+                pendingNodes.emplace_back(childNode);
+            }
+        }
+    }
+    return visitSum;
+}
+
+void TreePruner::prune(Node* rootNode, size_t memoryTarget)
+{
+    const size_t memory = get_tree_memory();
+    // the memory of a subtree is estimated by its share of the visits
+    const size_t visitsToFree = size_t(rootNode->get_node_count() * (1.0 - double(memoryTarget) / memory));
+    uint32_t maxVisits = PRUNE_MIN_VISITS;
+    size_t freedVisits = 0;
+    while (true) {
+        candidates.clear();
+        freedVisits = collect_candidates(rootNode, maxVisits);
+        if (freedVisits >= visitsToFree || maxVisits >= rootNode->get_visits()) {
+            break;
+        }
+        maxVisits *= 2;
+    }
+    for (const NodeAndIdx& candidate : candidates) {
+        // the subtree is freed right away because all search threads wait at the barrier
+        release_node(candidate.node->detach_child_node(candidate.childIdx), transpositionTable);
+    }
+    info_string("pruned subtrees:", candidates.size());
+    candidates.clear();
+    info_string("tree memory (MB):", get_tree_memory() / (1024 * 1024));
+}
+
+bool is_prunable_node(const Node* node)
+{
+    return !node->is_transposition() && !node->is_terminal() && node->get_node_type() == UNSOLVED;
+}
+
+size_t get_subtree_memory(const Node* rootNode)
+{
+    size_t memory = 0;
+    vector<const Node*> pendingNodes;
+    unordered_set<const Node*> visitedNodes;
+    pendingNodes.emplace_back(rootNode);
+    visitedNodes.insert(rootNode);
+    while (!pendingNodes.empty()) {
+        const Node* node = pendingNodes.back();
+        pendingNodes.pop_back();
+        memory += node->get_total_memory_size();
+        if (!node->is_playout_node()) {
+            continue;
+        }
+        for (auto it = node->get_node_it_begin(); it != node->get_node_it_end(); ++it) {
+            const Node* childNode = *it;
+            if (childNode != nullptr && visitedNodes.insert(childNode).second) {
+                pendingNodes.emplace_back(childNode);
+            }
+        }
+    }
+    return memory;
+}
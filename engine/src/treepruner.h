@@ -0,0 +1,143 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: treepruner.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Keeps the search tree within a memory budget by freeing subtrees with a low number of visits.
+ * The parent nodes keep the Q-values and visit counts of the pruned child nodes, so a pruned subtree
+ * continues to contribute to the selection and gets re-expanded if it's selected again.
+ * Pruning is only done while all search threads wait at a barrier, so that no thread holds a pointer into a freed subtree.
+ * The memory budget applies to the tree of the pruner alone: the allocations of its search threads are counted separately
+ * from the global node memory, which also contains the old tree that is freed by the garbage collector and the trees of other agents.
+ */
+
+#ifndef TREEPRUNER_H
+#define TREEPRUNER_H
+
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <vector>
+#include "node.h"
+
+using namespace std;
+
+// pruning starts when the memory budget is exceeded and frees subtrees until this fraction of the budget is reached
+#define PRUNE_TARGET_FRACTION 0.75
+// subtrees with at most this number of visits are considered in the first pruning pass, the number is doubled for each further pass
+#define PRUNE_MIN_VISITS 16
+
+class TreePruner
+{
+private:
+    mutex mtx;
+    condition_variable cv;
+    size_t activeThreads;
+    size_t waitingThreads;
+    size_t pruneRound;
+    vector<NodeAndIdx> candidates;
+    // the freed nodes are erased from the table
+    TranspositionTable* transpositionTable;
+    // estimated memory of the tree, the search threads add their allocations to it
+    atomic<size_t> treeMemory;
+    // the tree is pruned when its memory exceeds this limit, it's only changed while all search threads wait at the barrier
+    size_t memoryLimit;
+
+    /**
+     * @brief collect_candidates Collects all maximal subtrees with at most the given number of visits which can be pruned.
+     * The child nodes with the most visits are never pruned to keep the principal variation intact.
+     * Every node is visited once, also if it's reached by several transpositions.
+     * @param rootNode Root node of the search, its child nodes are never pruned
+     * @param maxVisits Maximum number of visits of a pruned subtree
+     * @return Sum of the visits of all collected subtrees
+     */
+    size_t collect_candidates(Node* rootNode, uint32_t maxVisits);
+
+    /**
+     * @brief prune Frees low-visit subtrees until the estimated memory is below the target
+     * @param rootNode Root node of the search
+     * @param memoryTarget Target memory in bytes
+     */
+    void prune(Node* rootNode, size_t memoryTarget);
+
+public:
+    TreePruner(TranspositionTable* transpositionTable);
+
+    /**
+     * @brief set_active_threads Sets the number of search threads which take part in the pruning barrier.
+     * Must be called before the search threads are started.
+     */
+    void set_active_threads(size_t numberThreads);
+
+    /**
+     * @brief init_tree_memory Measures the memory of the tree below the given root node and resets the memory limit to the budget of the search settings.
+     * The tree is only traversed if a memory budget is set. Must be called before the search threads are started.
+     * @param rootNode Root node of the search
+     * @param searchSettings Search settings which define the memory budget
+     */
+    void init_tree_memory(Node* rootNode, const SearchSettings* searchSettings);
+
+    /**
+     * @brief connect_thread Counts the node allocations of the calling search thread to the memory of this tree
+     */
+    void connect_thread();
+
+    /**
+     * @brief disconnect_thread Removes a finished search thread from the pruning barrier and stops counting its allocations
+     */
+    void disconnect_thread();
+
+    /**
+     * @brief get_tree_memory Returns the estimated memory of the tree in bytes
+     */
+    size_t get_tree_memory() const;
+
+    /**
+     * @brief is_prune_due Returns true if the tree exceeds the memory budget of the search settings.
+     * If pruning couldn't reach the target, the limit is raised to the memory after pruning divided by PRUNE_TARGET_FRACTION,
+     * so that the search threads don't stall at the barrier in every iteration.
+     */
+    bool is_prune_due(const SearchSettings* searchSettings) const;
+
+    /**
+     * @brief sync_and_prune Waits until all active search threads have arrived and lets the last one prune the tree.
+     * The calling thread must not hold any pointers into the tree.
+     * @param rootNode Root node of the search
+     * @param searchSettings Search settings which define the memory budget
+     */
+    void sync_and_prune(Node* rootNode, const SearchSettings* searchSettings);
+};
+
+/**
+ * @brief is_prunable_node Returns true if the given node can be detached from its single parent
+ */
+bool is_prunable_node(const Node* node);
+
+/**
+ * @brief get_subtree_memory Returns the estimated memory of all nodes which are reachable from the given node.
+ * Nodes which are reached by several transpositions are counted once.
+ * @param rootNode Root node of the subtree
+ * @return Number of bytes
+ */
+size_t get_subtree_memory(const Node* rootNode);
+
+#endif // TREEPRUNER_H
@@ -116,6 +116,7 @@ void CrazyAra::uci_loop(int argc, char* argv[])
         }
         else if (token == "setoption")  set_uci_option(is, *state.get());
         else if (token == "go")         go(state.get(), is, evalInfo);
+        else if (token == "ponderhit")  ponderhit();
         else if (token == "position")   position(state.get(), is);
         else if (token == "ucinewgame") ucinewgame();
         else if (token == "isready")    is_ready<true>();
@@ -124,6 +125,8 @@ void CrazyAra::uci_loop(int argc, char* argv[])
         else if (token == "benchmark")  benchmark(is);
         else if (token == "root")       mctsAgent->print_root_node();
         else if (token == "tree")      export_search_tree(is);
+        else if (token == "savetree")  save_search_tree(is);
+        else if (token == "loadtree")  load_search_tree(state.get(), is);
         else if (token == "flip")       state->flip();
         else if (token == "d")          cout << *(state.get()) << endl;
         else if (token == "activeuci") activeuci();
@@ -202,6 +205,7 @@ void CrazyAra::go(StateObj* state, istringstream& is, EvalInfo& evalInfo)
         else if (token == "nodes")     is >> searchLimits.nodes;
         else if (token == "movetime")  is >> searchLimits.movetime;
         else if (token == "infinite")  searchLimits.infinite = true;
+        else if (token == "ponder")    searchLimits.ponder = true;
     }
 
     if (useRawNetwork) {
@@ -241,6 +245,13 @@ void CrazyAra::wait_to_finish_last_search()
     }
 }
 
+void CrazyAra::ponderhit()
+{
+    if (mctsAgent != nullptr && !useRawNetwork) {
+        mctsAgent->ponderhit();
+    }
+}
+
 void CrazyAra::stop_search()
 {
     if (mctsAgent != nullptr) {
@@ -348,6 +359,31 @@ void CrazyAra::export_search_tree(istringstream& is)
     mctsAgent->export_search_tree(std::stoi(depth), filename);
 }
 
+void CrazyAra::save_search_tree(istringstream& is)
+{
+    // the tree must not be changed by a running search
+    wait_to_finish_last_search();
+    if (mctsAgent == nullptr) {
+        info_string("no search tree available, call isready first");
+        return;
+    }
+    string filename;
+    is >> filename;
+    mctsAgent->save_search_tree(filename == "" ? "tree.bin" : filename);
+}
+
+void CrazyAra::load_search_tree(const StateObj* state, istringstream& is)
+{
+    wait_to_finish_last_search();
+    if (mctsAgent == nullptr) {
+        info_string("no search agent available, call isready first");
+        return;
+    }
+    string filename;
+    is >> filename;
+    mctsAgent->load_search_tree(state, filename == "" ? "tree.bin" : filename);
+}
+
 void CrazyAra::activeuci()
 {
     for (const auto& it : Options)
@@ -546,7 +582,9 @@ void CrazyAra::init()
 #if defined(MODE_XIANGQI) || defined(MODE_BOARDGAMES)
     // This is a workaround for compatibility with Fairy-Stockfish
     // Option with key "Threads" is also removed. (See /3rdparty/Fairy-Stockfish/src/ucioption.cpp)
+    // The "Hash" option of Fairy-Stockfish is replaced by the one for the transposition table of the search.
     Options.erase("Hash");
+    Options["Hash"] << Option(DEFAULT_HASH_MB, 1, MAX_HASH_MB);
     Options.erase("Use NNUE");
 #endif
 }
@@ -627,14 +665,18 @@ vector<unique_ptr<NeuralNetAPI>> CrazyAra::create_new_net_batches(const string&
     const bool useTensorRT = false;
 #endif
 #endif
+    // when using inference servers, the search threads share a few network handles with a larger batch size
+    const bool useInferenceServers = searchSettings.inferenceServers != 0;
+    const size_t netsPerDevice = useInferenceServers ? searchSettings.inferenceServers : size_t(Options["Threads"]);
+    const unsigned int batchSize = useInferenceServers ? searchSettings.inferenceBatchSize : searchSettings.batchSize;
     for (int deviceId = int(Options["First_Device_ID"]); deviceId <= int(Options["Last_Device_ID"]); ++deviceId) {
-        for (size_t i = 0; i < size_t(Options["Threads"]); ++i) {
+        for (size_t i = 0; i < netsPerDevice; ++i) {
 #ifdef MXNET
-            netBatches.push_back(make_unique<MXNetAPI>(Options["Context"], deviceId, searchSettings.batchSize, modelDirectory, Options["Precision"], useTensorRT));
+            netBatches.push_back(make_unique<MXNetAPI>(Options["Context"], deviceId, batchSize, modelDirectory, Options["Precision"], useTensorRT));
 #elif defined TENSORRT
-            netBatches.push_back(make_unique<TensorrtAPI>(deviceId, searchSettings.batchSize, modelDirectory, Options["Precision"]));
+            netBatches.push_back(make_unique<TensorrtAPI>(deviceId, batchSize, modelDirectory, Options["Precision"]));
 #elif defined OPENVINO
-            netBatches.push_back(make_unique<OpenVinoAPI>(deviceId, searchSettings.batchSize, modelDirectory, Options["Threads_NN_Inference"]));
+            netBatches.push_back(make_unique<OpenVinoAPI>(deviceId, batchSize, modelDirectory, Options["Threads_NN_Inference"]));
 #endif
         }
     }
@@ -646,6 +688,8 @@ void CrazyAra::set_uci_option(istringstream& is, StateObj& state)
     // these three UCI-Options may trigger a network reload, keep an eye on them
     const string prevModelDir = Options["Model_Directory"];
     const int prevThreads = Options["Threads"];
+    const int prevInferenceServers = Options["Inference_Servers"];
+    const int prevInferenceBatchSize = Options["Inference_Batch_Size"];
     const string prevUciVariant = Options["UCI_Variant"];
     const int prevFirstDeviceID = Options["First_Device_ID"];
     const int prevLastDeviceID = Options["Last_Device_ID"];
@@ -664,7 +708,8 @@ void CrazyAra::set_uci_option(istringstream& is, StateObj& state)
     changedUCIoption = true;
     if (networkLoaded) {
         if (string(Options["Model_Directory"]) != prevModelDir || int(Options["Threads"]) != prevThreads || string(Options["UCI_Variant"]) != prevUciVariant ||
-            int(Options["First_Device_ID"]) != prevFirstDeviceID || int(Options["Last_Device_ID"] != prevLastDeviceID) || prevIs960 != curIs960) {
+            int(Options["First_Device_ID"]) != prevFirstDeviceID || int(Options["Last_Device_ID"] != prevLastDeviceID) || prevIs960 != curIs960 ||
+            int(Options["Inference_Servers"]) != prevInferenceServers || int(Options["Inference_Batch_Size"]) != prevInferenceBatchSize) {
             networkLoaded = false;
             is_ready<false>();
         }
@@ -760,6 +805,22 @@ void CrazyAra::init_search_settings()
         info_string_important("Unknown option", Options["Virtual_Style"], "for Virtual_Style");
     }
     searchSettings.virtualMixThreshold = Options["Virtual_Mix_Threshold"];
+    searchSettings.pipelineInference = Options["Pipeline_Inference"];
+    searchSettings.lockFreeUpdates = Options["Lock_Free_Updates"];
+    searchSettings.inferenceServers = Options["Inference_Servers"];
+    // the mini-batch of a single search thread must fit into the batch of the inference server
+    searchSettings.inferenceBatchSize = max(int(Options["Inference_Batch_Size"]), int(Options["Batch_Size"]));
+    searchSettings.inferenceLatencyUS = Options["Inference_Latency_US"];
+    searchSettings.hashSizeMB = Options["Hash"];
+    searchSettings.nnCacheSizeMB = Options["NNCache_MB"];
+    searchSettings.treeMemoryMB = Options["Tree_Memory_MB"];
+    searchSettings.gcThreads = Options["GC_Threads"];
+    searchSettings.gcThrottleUS = Options["GC_Throttle_US"];
+    searchSettings.budgetDescent = Options["Budget_Descent"];
+    searchSettings.reuseCollisions = Options["Reuse_Collisions"];
+    searchSettings.rootPartitions = Options["Root_Partitions"];
+    searchSettings.randomSeed = Options["Random_Seed"];
+    searchSettings.batchedBackup = Options["Batched_Backup"];
 }
 
 void CrazyAra::init_play_settings()
@@ -171,6 +171,19 @@ public:
      */
     void export_search_tree(istringstream& is);
 
+    /**
+     * @brief save_search_tree Writes the current search tree into a binary checkpoint file
+     * @param is Input stream. If no argument is given, the filename is set to "tree.bin"
+     */
+    void save_search_tree(istringstream& is);
+
+    /**
+     * @brief load_search_tree Loads a binary checkpoint file as the search tree for the current position
+     * @param state Current position
+     * @param is Input stream. If no argument is given, the filename is set to "tree.bin"
+     */
+    void load_search_tree(const StateObj* state, istringstream& is);
+
     /**
      * @brief activeuci Prints the currently UCI options currently active in the binary.
      * The output format is "name <uci-option> value <uci-option-value>" followed by "readyok" at the very end.
@@ -238,6 +251,11 @@ public:
      */
     void stop_search();
 
+    /**
+     * @brief ponderhit Informs the mcts agent that the opponent played the expected move of the running ponder search
+     */
+    void ponderhit();
+
     /**
      * @brief prepare_search_config_structs Prepare search configuration structs for new search
      */
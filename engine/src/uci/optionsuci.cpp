@@ -41,6 +41,7 @@
 #endif
 #include "../util/communication.h"
 #include "../nn/neuralnetapi.h"
+#include "../constants.h"
 
 using namespace std;
 
@@ -79,6 +80,8 @@ void OptionsUCI::init(OptionsMap& o)
 #endif
 #endif
 #endif
+    o["Batched_Backup"] << Option(false);
+    o["Budget_Descent"] << Option(false);
     o["Centi_CPuct_Init"] << Option(250, 1, 99999);
 #ifdef USE_RL
     o["Centi_Dirichlet_Epsilon"] << Option(25, 0, 99999);
@@ -124,7 +127,14 @@ void OptionsUCI::init(OptionsMap& o)
     //    o["Enhance_Captures"]              << Option(false);         currently disabled
     o["First_Device_ID"] << Option(0, 0, 99999);
     o["Fixed_Movetime"] << Option(0, 0, 99999999);
+    o["GC_Threads"] << Option(2, 1, 64);
+    o["GC_Throttle_US"] << Option(0, 0, 1000000);
+    o["Hash"] << Option(DEFAULT_HASH_MB, 1, MAX_HASH_MB);
+    o["Inference_Batch_Size"] << Option(64, 1, 8192);
+    o["Inference_Latency_US"] << Option(1000, 0, 99999999);
+    o["Inference_Servers"] << Option(0, 0, 64);
     o["Last_Device_ID"] << Option(0, 0, 99999);
+    o["Lock_Free_Updates"] << Option(false);
     o["Log_File"] << Option("", on_logger);
     o["MCTS_Solver"] << Option(true);
 #if defined(MODE_LICHESS) || defined(MODE_BOARDGAMES)
@@ -134,22 +144,29 @@ void OptionsUCI::init(OptionsMap& o)
 #endif
     o["Move_Overhead"] << Option(20, 0, 5000);
     o["MultiPV"] << Option(1, 1, 99999);
+    o["NNCache_MB"] << Option(0, 0, MAX_HASH_MB);
 #ifdef USE_RL
     o["Nodes"] << Option(800, 0, 99999999);
 #else
     o["Nodes"] << Option(0, 0, 99999999);
     o["Nodes_Limit"] << Option(0, 0, 999999999);
 #endif
+    o["Pipeline_Inference"] << Option(false);
+    // only announces the support of "go ponder" to the GUI
+    o["Ponder"] << Option(false);
 #ifdef TENSORRT
     o["Precision"] << Option("float16", { "float32", "float16", "int8" });
 #else
     o["Precision"] << Option("float32", { "float32", "int8" });
 #endif
+    o["Random_Seed"] << Option(0, 0, 999999999);
+    o["Reuse_Collisions"] << Option(true);
 #ifdef USE_RL
     o["Reuse_Tree"] << Option(false);
 #else
     o["Reuse_Tree"] << Option(true);
 #endif
+    o["Root_Partitions"] << Option(0, 0, 512);
 #ifdef USE_RL
     o["Temperature_Moves"] << Option(15, 0, 99999);
 #else
@@ -184,6 +201,7 @@ void OptionsUCI::init(OptionsMap& o)
     o["Threads_NN_Inference"] << Option(8, 1, 512);
 #endif
     o["Timeout_MS"] << Option(0, 0, 99999999);
+    o["Tree_Memory_MB"] << Option(0, 0, MAX_HASH_MB);
 #ifdef MODE_LICHESS
     o["UCI_Variant"] << Option(get_first_variant_with_model().c_str(), StateConstants::available_variants());
 #else
@@ -0,0 +1,102 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: atomicutil.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Helper functions to atomically update plain scalar members and array entries (e.g. the per-child statistics)
+ * without changing their type. All operations use relaxed memory ordering because the statistics
+ * don't guard any other memory.
+ */
+
+#ifndef ATOMICUTIL_H
+#define ATOMICUTIL_H
+
+#include <atomic>
+
+/**
+ * @brief as_atomic Reinterprets a plain scalar as an atomic object of the same type
+ * @param value Naturally aligned scalar
+ * @return Atomic reference to the same memory
+ */
+template <typename T>
+inline std::atomic<T>& as_atomic(T& value)
+{
+    static_assert(sizeof(std::atomic<T>) == sizeof(T), "std::atomic<T> must have the same size as T");
+    return *reinterpret_cast<std::atomic<T>*>(&value);
+}
+
+/**
+ * @brief atomic_load Loads the given scalar atomically
+ */
+template <typename T>
+inline T atomic_load(const T& value)
+{
+    return as_atomic(const_cast<T&>(value)).load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief atomic_increment Atomically adds the given amount to an integer and returns the previous value
+ */
+template <typename T>
+inline T atomic_increment(T& value, T amount = 1)
+{
+    return as_atomic(value).fetch_add(amount, std::memory_order_relaxed);
+}
+
+/**
+ * @brief atomic_decrement Atomically subtracts the given amount from an integer and returns the previous value
+ */
+template <typename T>
+inline T atomic_decrement(T& value, T amount = 1)
+{
+    return as_atomic(value).fetch_sub(amount, std::memory_order_relaxed);
+}
+
+/**
+ * @brief atomic_update Atomically replaces a value by update(oldValue) using a compare-and-swap loop.
+ * The update function may be called several times and must not have side effects.
+ * @param value Value to update
+ * @param update Function which returns the new value given the current one
+ * @return The new value
+ */
+template <typename T, typename Function>
+inline T atomic_update(T& value, Function update)
+{
+    std::atomic<T>& target = as_atomic(value);
+    T expected = target.load(std::memory_order_relaxed);
+    T desired = update(expected);
+    while (!target.compare_exchange_weak(expected, desired, std::memory_order_relaxed)) {
+        desired = update(expected);
+    }
+    return desired;
+}
+
+/**
+ * @brief atomic_add Atomically adds a floating point number by a compare-and-swap loop
+ */
+template <typename T>
+inline T atomic_add(T& value, T amount)
+{
+    return atomic_update(value, [amount](T cur) { return cur + amount; });
+}
+
+#endif // ATOMICUTIL_H
@@ -66,7 +66,7 @@ size_t random_choice(const DynamicVector<T>& distribution)
 {
     const T* prob = distribution.data();
     discrete_distribution<> d(prob, prob+distribution.size());
-    return size_t(d(generator));
+    return size_t(d(get_generator()));
 }
 
 /**
@@ -117,7 +117,7 @@ DynamicVector<T> get_dirichlet_noise(size_t length, T alpha)
 
     for (size_t i = 0; i < length; ++i) {
         std::gamma_distribution<T> distribution(alpha, 1.0f);
-        dirichletNoise[i] = distribution(generator);
+        dirichletNoise[i] = distribution(get_generator());
     }
     dirichletNoise /= sum(dirichletNoise);
     return  dirichletNoise;
@@ -0,0 +1,97 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: epochmanager.cpp
+ * Created on 18.10.2026
+ * @author: queensgambit
+ */
+
+#include "epochmanager.h"
+#include <thread>
+#include <stdexcept>
+
+EpochManager::EpochManager() :
+    globalEpoch(1),
+    numberSlots(0)
+{
+    for (Slot& slot : slots) {
+        slot.epoch.store(0, std::memory_order_relaxed);
+        slot.registered.store(false, std::memory_order_relaxed);
+    }
+}
+
+size_t EpochManager::register_thread()
+{
+    for (size_t slotIdx = 0; slotIdx < EPOCH_MAX_THREADS; ++slotIdx) {
+        bool expected = false;
+        if (!slots[slotIdx].registered.load(std::memory_order_relaxed) &&
+                slots[slotIdx].registered.compare_exchange_strong(expected, true)) {
+            size_t curNumberSlots = numberSlots.load();
+            while (curNumberSlots < slotIdx + 1 && !numberSlots.compare_exchange_weak(curNumberSlots, slotIdx + 1)) {
+            }
+            return slotIdx;
+        }
+    }
+    throw std::runtime_error("EpochManager: too many registered threads");
+}
+
+void EpochManager::unregister_thread(size_t slotIdx)
+{
+    slots[slotIdx].epoch.store(0, std::memory_order_release);
+    slots[slotIdx].registered.store(false, std::memory_order_release);
+}
+
+void EpochManager::enter(size_t slotIdx)
+{
+    slots[slotIdx].epoch.store(globalEpoch.load(std::memory_order_acquire), std::memory_order_relaxed);
+    // the store must be visible to synchronize() before the reader loads any shared pointer
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void EpochManager::exit(size_t slotIdx)
+{
+    slots[slotIdx].epoch.store(0, std::memory_order_release);
+}
+
+void EpochManager::synchronize()
+{
+    const uint64_t targetEpoch = globalEpoch.fetch_add(1) + 1;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const size_t curNumberSlots = numberSlots.load();
+    for (size_t slotIdx = 0; slotIdx < curNumberSlots; ++slotIdx) {
+        uint64_t epoch = slots[slotIdx].epoch.load();
+        while (epoch != 0 && epoch < targetEpoch) {
+            std::this_thread::yield();
+            epoch = slots[slotIdx].epoch.load();
+        }
+    }
+}
+
+EpochGuard::EpochGuard(EpochManager& epochManager, size_t slotIdx) :
+    epochManager(epochManager),
+    slotIdx(slotIdx)
+{
+    epochManager.enter(slotIdx);
+}
+
+EpochGuard::~EpochGuard()
+{
+    epochManager.exit(slotIdx);
+}
@@ -0,0 +1,105 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: epochmanager.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Epoch based reclamation for objects which are read without a lock or a reference count.
+ * A reader announces the start and end of each critical section by a single store to its own slot.
+ * A writer unlinks an object first and calls synchronize() before freeing it.
+ * Afterwards, no reader can still hold a pointer which it obtained before the object was unlinked.
+ */
+
+#ifndef EPOCHMANAGER_H
+#define EPOCHMANAGER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// maximum number of reader threads which can be registered at once
+#define EPOCH_MAX_THREADS 1024
+
+class EpochManager
+{
+private:
+    // each slot is padded to a full cache line, so that the readers don't share cache lines
+    struct alignas(64) Slot {
+        // epoch in which the current critical section started, 0 if the thread is outside of a critical section
+        std::atomic<uint64_t> epoch;
+        std::atomic<bool> registered;
+    };
+    Slot slots[EPOCH_MAX_THREADS];
+    std::atomic<uint64_t> globalEpoch;
+    // upper bound of all slot indices which have been registered so far
+    std::atomic<size_t> numberSlots;
+
+public:
+    EpochManager();
+    EpochManager(const EpochManager&) = delete;
+    EpochManager& operator=(const EpochManager&) = delete;
+
+    /**
+     * @brief register_thread Reserves a slot for a reader thread
+     * @return Slot index
+     */
+    size_t register_thread();
+
+    /**
+     * @brief unregister_thread Releases the given slot. The thread must be outside of a critical section.
+     * @param slotIdx Slot index
+     */
+    void unregister_thread(size_t slotIdx);
+
+    /**
+     * @brief enter Marks the start of a critical section in which the reader may dereference unlinked objects
+     * @param slotIdx Slot index of the reader
+     */
+    void enter(size_t slotIdx);
+
+    /**
+     * @brief exit Marks the end of a critical section. The reader must not keep any pointers which it obtained inside of it.
+     * @param slotIdx Slot index of the reader
+     */
+    void exit(size_t slotIdx);
+
+    /**
+     * @brief synchronize Waits until all critical sections which started before this call have ended
+     */
+    void synchronize();
+};
+
+/**
+ * @brief The EpochGuard class is a scoped critical section of an epoch manager
+ */
+class EpochGuard
+{
+private:
+    EpochManager& epochManager;
+    size_t slotIdx;
+public:
+    EpochGuard(EpochManager& epochManager, size_t slotIdx);
+    ~EpochGuard();
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+};
+
+#endif // EPOCHMANAGER_H
@@ -109,6 +109,15 @@ public:
         return data[idx];
     }
 
+    /**
+     * @brief capacity Returns the maximum number of elements
+     * @return capacity
+     */
+    size_t capacity() const
+    {
+        return maxCapacity;
+    }
+
     /**
      * @brief size Returns the size of the array
      * @return size
@@ -0,0 +1,225 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+
+/*
+ * @file: poolallocator.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Slab based memory pool for objects of a fixed size and a matching allocator which can be used with std::allocate_shared().
+ * Every thread keeps a small cache of free blocks which is refilled from and returned to a global free list in chunks.
+ * This way, node expansions don't require a malloc() call and freeing a tree only pushes the blocks back onto a list.
+ * The slabs are kept for the lifetime of the program and are reused by later searches.
+ */
+
+#ifndef POOLALLOCATOR_H
+#define POOLALLOCATOR_H
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+#include <new>
+
+/**
+ * @brief pool_block_size Returns the size of a pool block for an object of the given size.
+ * The block size is a multiple of the maximum fundamental alignment.
+ * @param objectSize Size of the object in bytes
+ * @return Block size in bytes
+ */
+constexpr size_t pool_block_size(size_t objectSize)
+{
+    return (objectSize + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+}
+
+template <size_t blockSize>
+/**
+ * @brief The FixedSizePool class hands out memory blocks of size blockSize from large slabs.
+ * There is a single instance for every block size which is shared by all threads.
+ */
+class FixedSizePool
+{
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    struct FreeChunk {
+        FreeBlock* head;
+        size_t count;
+    };
+    struct ThreadCache {
+        FreeBlock* head = nullptr;
+        size_t count = 0;
+        ~ThreadCache() {
+            // return the remaining blocks of a finished thread to the global free list
+            if (head != nullptr) {
+                FixedSizePool::instance().push_chunk(head, count);
+            }
+        }
+    };
+
+    // number of blocks which are moved between the thread caches and the global free list at once
+    static constexpr size_t CHUNK_SIZE = 256;
+    // number of blocks of a single slab
+    static constexpr size_t SLAB_BLOCKS = CHUNK_SIZE * 16;
+    static_assert(blockSize >= sizeof(FreeBlock), "The block size must be able to hold a free list pointer");
+
+    std::mutex mtx;
+    std::vector<FreeChunk> freeChunks;
+    std::vector<char*> slabs;
+
+    FixedSizePool() = default;
+
+    static ThreadCache& thread_cache() {
+        static thread_local ThreadCache cache;
+        return cache;
+    }
+
+    void push_chunk(FreeBlock* head, size_t count) {
+        std::lock_guard<std::mutex> lock(mtx);
+        freeChunks.push_back({head, count});
+    }
+
+    /**
+     * @brief refill Refills an empty thread cache with a chunk of the global free list or a newly allocated slab
+     * @param cache Thread cache
+     */
+    void refill(ThreadCache& cache) {
+        std::lock_guard<std::mutex> lock(mtx);
+        if (freeChunks.empty()) {
+            char* slab = static_cast<char*>(::operator new(SLAB_BLOCKS * blockSize));
+            slabs.push_back(slab);
+            // link all blocks of the new slab and split them into chunks
+            for (size_t chunkStart = 0; chunkStart < SLAB_BLOCKS; chunkStart += CHUNK_SIZE) {
+                for (size_t idx = chunkStart; idx < chunkStart + CHUNK_SIZE; ++idx) {
+                    FreeBlock* block = reinterpret_cast<FreeBlock*>(slab + idx * blockSize);
+                    block->next = idx + 1 < chunkStart + CHUNK_SIZE ? reinterpret_cast<FreeBlock*>(slab + (idx + 1) * blockSize) : nullptr;
+                }
+                freeChunks.push_back({reinterpret_cast<FreeBlock*>(slab + chunkStart * blockSize), CHUNK_SIZE});
+            }
+        }
+        cache.head = freeChunks.back().head;
+        cache.count = freeChunks.back().count;
+        freeChunks.pop_back();
+    }
+
+    /**
+     * @brief release Moves CHUNK_SIZE blocks of a full thread cache to the global free list
+     * @param cache Thread cache
+     */
+    void release(ThreadCache& cache) {
+        FreeBlock* head = cache.head;
+        FreeBlock* tail = head;
+        for (size_t idx = 1; idx < CHUNK_SIZE; ++idx) {
+            tail = tail->next;
+        }
+        cache.head = tail->next;
+        cache.count -= CHUNK_SIZE;
+        tail->next = nullptr;
+        push_chunk(head, CHUNK_SIZE);
+    }
+
+public:
+    FixedSizePool(const FixedSizePool&) = delete;
+    FixedSizePool& operator=(const FixedSizePool&) = delete;
+
+    /**
+     * @brief instance Returns the pool for the given block size
+     * @return Pool reference
+     */
+    static FixedSizePool& instance() {
+        // the pool is intentionally never destroyed because objects might still be alive during static destruction
+        static FixedSizePool* pool = new FixedSizePool();
+        return *pool;
+    }
+
+    /**
+     * @brief allocate Returns a free block of blockSize bytes
+     * @return Pointer to the block
+     */
+    void* allocate() {
+        ThreadCache& cache = thread_cache();
+        if (cache.head == nullptr) {
+            refill(cache);
+        }
+        FreeBlock* block = cache.head;
+        cache.head = block->next;
+        --cache.count;
+        return block;
+    }
+
+    /**
+     * @brief deallocate Returns a block to the pool. The block may have been allocated by a different thread.
+     * @param ptr Pointer to the block
+     */
+    void deallocate(void* ptr) {
+        ThreadCache& cache = thread_cache();
+        FreeBlock* block = static_cast<FreeBlock*>(ptr);
+        block->next = cache.head;
+        cache.head = block;
+        if (++cache.count >= 2 * CHUNK_SIZE) {
+            release(cache);
+        }
+    }
+
+    /**
+     * @brief get_reserved_bytes Returns the total number of bytes which are reserved by the slabs of this pool
+     * @return Number of bytes
+     */
+    size_t get_reserved_bytes() {
+        std::lock_guard<std::mutex> lock(mtx);
+        return slabs.size() * SLAB_BLOCKS * blockSize;
+    }
+};
+
+template <typename T>
+/**
+ * @brief The PoolAllocator struct is a standard conforming allocator which serves single objects from a FixedSizePool.
+ * Requests for multiple objects are forwarded to the global operator new.
+ */
+struct PoolAllocator
+{
+    using value_type = T;
+
+    PoolAllocator() noexcept = default;
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>&) noexcept {}
+
+    T* allocate(size_t n) {
+        if (n == 1) {
+            return static_cast<T*>(FixedSizePool<pool_block_size(sizeof(T))>::instance().allocate());
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T* ptr, size_t n) noexcept {
+        if (n == 1) {
+            FixedSizePool<pool_block_size(sizeof(T))>::instance().deallocate(ptr);
+            return;
+        }
+        ::operator delete(ptr);
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const PoolAllocator<T>&, const PoolAllocator<U>&) { return true; }
+template <typename T, typename U>
+bool operator!=(const PoolAllocator<T>&, const PoolAllocator<U>&) { return false; }
+
+#endif // POOLALLOCATOR_H
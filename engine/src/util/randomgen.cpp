@@ -24,3 +24,19 @@
  */
 
 #include "randomgen.h"
+
+uint64_t derive_seed(uint64_t masterSeed, uint64_t stream)
+{
+    if (masterSeed == 0) {
+        std::random_device device;
+        return (uint64_t(device()) << 32) | device();
+    }
+    // the generator seeds itself by splitmix64, so distinct streams lead to uncorrelated states
+    return masterSeed + stream * 0xD1B54A32D192ED03ULL;
+}
+
+Xoshiro256& get_generator()
+{
+    thread_local Xoshiro256 generator(derive_seed(0, 0));
+    return generator;
+}
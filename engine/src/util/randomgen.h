@@ -29,10 +29,91 @@
 #define RANDOMGEN_H
 
 #include <random>
+#include <cstdint>
+#include <limits>
 
-// random generator used for all sort of distributions
-static std::random_device r;
-static std::default_random_engine generator(r());
+/**
+ * @brief The Xoshiro256 class implements the xoshiro256** generator by Blackman and Vigna (https://prng.di.unimi.it/).
+ * It's much faster than rand() and the standard engines and holds no shared state, so every thread can own its own generator.
+ * It fulfills the UniformRandomBitGenerator requirements and can be used with all distributions of <random>.
+ */
+class Xoshiro256
+{
+private:
+    uint64_t s[4];
+
+    static inline uint64_t rotl(uint64_t x, int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+public:
+    using result_type = uint64_t;
+
+    explicit Xoshiro256(uint64_t seed = 0) {
+        this->seed(seed);
+    }
+
+    /**
+     * @brief seed Initializes the state by the splitmix64 sequence of the given seed
+     */
+    void seed(uint64_t seed) {
+        for (uint64_t& word : s) {
+            seed += 0x9E3779B97F4A7C15ULL;
+            uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    result_type operator()() {
+        const uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const uint64_t t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return result;
+    }
+
+    /**
+     * @brief below Returns a random integer in [0, bound) by a multiply-shift of the upper 32 bits
+     */
+    uint32_t below(uint32_t bound) {
+        return uint32_t(((*this)() >> 32) * bound >> 32);
+    }
+
+    /**
+     * @brief uniform Returns a random number in [0, 1)
+     */
+    double uniform() {
+        return ((*this)() >> 11) * (1.0 / 9007199254740992.0);
+    }
+};
+
+/**
+ * @brief derive_seed Derives the seed of an individual generator from a master seed
+ * @param masterSeed Master seed, 0 returns a new random seed on every call
+ * @param stream Index of the generator, e.g. the search thread index
+ * @return Seed for the generator
+ */
+uint64_t derive_seed(uint64_t masterSeed, uint64_t stream);
+
+/**
+ * @brief get_generator Returns the random generator of the calling thread which is used for all sort of distributions.
+ * It's seeded randomly on its first use.
+ */
+Xoshiro256& get_generator();
 
 /**
  * @brief random_exponential Generates a random sample from a exponential distribution with a given mean.
@@ -42,7 +123,7 @@ static std::default_random_engine generator(r());
 template<typename T>
 T random_exponential(T lambda) {
     std::exponential_distribution<T> distribution(lambda);
-    return distribution(generator);
+    return distribution(get_generator());
 }
 
 #endif // RANDOMGEN_H
@@ -0,0 +1,302 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: selectionkernel.cpp
+ * Created on 18.10.2026
+ * @author: queensgambit
+ */
+
+#include "selectionkernel.h"
+#include <cfloat>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SELECTION_KERNEL_SIMD
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief The TopTwo struct keeps track of the two best scores and their indices
+ */
+struct TopTwo {
+    float firstMax = -FLT_MAX;
+    float secondMax = -FLT_MAX;
+    size_t firstArg = 0;
+    size_t secondArg = 0;
+
+    /**
+     * @brief update Adds a new candidate. Candidates must be added in increasing index order
+     * unless the scores differ, so that ties are resolved in favour of the lower index.
+     */
+    inline void update(float score, size_t idx) {
+        if (score > firstMax || (score == firstMax && idx < firstArg)) {
+            secondMax = firstMax;
+            secondArg = firstArg;
+            firstMax = score;
+            firstArg = idx;
+        }
+        else if (score > secondMax || (score == secondMax && idx < secondArg)) {
+            secondMax = score;
+            secondArg = idx;
+        }
+    }
+};
+
+inline float q_plus_u(const float* qValues, const float* policy, const uint32_t* visits, size_t idx, float uFactor)
+{
+    return qValues[idx] + uFactor * policy[idx] / (float(visits[idx]) + 1.0f);
+}
+
+size_t argmax_q_plus_u_scalar(const float* qValues, const float* policy, const uint32_t* visits, size_t size, float uFactor)
+{
+    size_t bestIdx = 0;
+    float bestScore = q_plus_u(qValues, policy, visits, 0, uFactor);
+    for (size_t idx = 1; idx < size; ++idx) {
+        const float score = q_plus_u(qValues, policy, visits, idx, uFactor);
+        if (score > bestScore) {
+            bestScore = score;
+            bestIdx = idx;
+        }
+    }
+    return bestIdx;
+}
+
+void first_and_second_argmax_q_plus_u_scalar(const float* qValues, const float* policy, const uint32_t* visits, size_t size, float uFactor, TopTwo& topTwo)
+{
+    for (size_t idx = 0; idx < size; ++idx) {
+        topTwo.update(q_plus_u(qValues, policy, visits, idx, uFactor), idx);
+    }
+}
+
+#ifdef SELECTION_KERNEL_SIMD
+__attribute__((target("avx2")))
+size_t argmax_q_plus_u_avx2(const float* qValues, const float* policy, const uint32_t* visits, size_t size, float uFactor)
+{
+    const __m256 factor = _mm256_set1_ps(uFactor);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i curIdx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i bestIdx = _mm256_setzero_si256();
+    __m256 bestScore = _mm256_set1_ps(-FLT_MAX);
+
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+        const __m256 childVisits = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(visits + idx)));
+        const __m256 u = _mm256_div_ps(_mm256_mul_ps(factor, _mm256_loadu_ps(policy + idx)), _mm256_add_ps(childVisits, one));
+        const __m256 score = _mm256_add_ps(_mm256_loadu_ps(qValues + idx), u);
+        const __m256 greater = _mm256_cmp_ps(score, bestScore, _CMP_GT_OQ);
+        bestScore = _mm256_blendv_ps(bestScore, score, greater);
+        bestIdx = _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(bestIdx), _mm256_castsi256_ps(curIdx), greater));
+        curIdx = _mm256_add_epi32(curIdx, step);
+    }
+
+    alignas(32) float laneScores[8];
+    alignas(32) int32_t laneIndices[8];
+    _mm256_store_ps(laneScores, bestScore);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndices), bestIdx);
+    TopTwo best;
+    for (size_t lane = 0; lane < 8 && lane < idx; ++lane) {
+        best.update(laneScores[lane], size_t(laneIndices[lane]));
+    }
+    for (; idx < size; ++idx) {
+        best.update(q_plus_u(qValues, policy, visits, idx, uFactor), idx);
+    }
+    return best.firstArg;
+}
+
+__attribute__((target("avx2")))
+void first_and_second_argmax_q_plus_u_avx2(const float* qValues, const float* policy, const uint32_t* visits, size_t size, float uFactor, TopTwo& topTwo)
+{
+    const __m256 factor = _mm256_set1_ps(uFactor);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i curIdx = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256 firstScore = _mm256_set1_ps(-FLT_MAX);
+    __m256 secondScore = _mm256_set1_ps(-FLT_MAX);
+    __m256 firstIdx = _mm256_setzero_ps();
+    __m256 secondIdx = _mm256_setzero_ps();
+
+    size_t idx = 0;
+    for (; idx + 8 <= size; idx += 8) {
+        const __m256 childVisits = _mm256_cvtepi32_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(visits + idx)));
+        const __m256 u = _mm256_div_ps(_mm256_mul_ps(factor, _mm256_loadu_ps(policy + idx)), _mm256_add_ps(childVisits, one));
+        const __m256 score = _mm256_add_ps(_mm256_loadu_ps(qValues + idx), u);
+        const __m256 scoreIdx = _mm256_castsi256_ps(curIdx);
+        const __m256 greaterFirst = _mm256_cmp_ps(score, firstScore, _CMP_GT_OQ);
+        const __m256 greaterSecond = _mm256_cmp_ps(score, secondScore, _CMP_GT_OQ);
+        // the second best becomes either the former first best, the new score or stays the same
+        secondScore = _mm256_blendv_ps(_mm256_blendv_ps(secondScore, score, greaterSecond), firstScore, greaterFirst);
+        secondIdx = _mm256_blendv_ps(_mm256_blendv_ps(secondIdx, scoreIdx, greaterSecond), firstIdx, greaterFirst);
+        firstScore = _mm256_blendv_ps(firstScore, score, greaterFirst);
+        firstIdx = _mm256_blendv_ps(firstIdx, scoreIdx, greaterFirst);
+        curIdx = _mm256_add_epi32(curIdx, step);
+    }
+
+    alignas(32) float laneScores[16];
+    alignas(32) int32_t laneIndices[16];
+    _mm256_store_ps(laneScores, firstScore);
+    _mm256_store_ps(laneScores + 8, secondScore);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndices), _mm256_castps_si256(firstIdx));
+    _mm256_store_si256(reinterpret_cast<__m256i*>(laneIndices + 8), _mm256_castps_si256(secondIdx));
+    for (size_t lane = 0; lane < 8 && lane < idx; ++lane) {
+        topTwo.update(laneScores[lane], size_t(laneIndices[lane]));
+        if (lane + 8 < idx) {
+            topTwo.update(laneScores[lane + 8], size_t(laneIndices[lane + 8]));
+        }
+    }
+    for (; idx < size; ++idx) {
+        topTwo.update(q_plus_u(qValues, policy, visits, idx, uFactor), idx);
+    }
+}
+
+__attribute__((target("avx512f")))
+size_t argmax_q_plus_u_avx512(const float* qValues, const float* policy, const uint32_t* visits, size_t size, float uFactor)
+{
+    const __m512 factor = _mm512_set1_ps(uFactor);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512i step = _mm512_set1_epi32(16);
+    __m512i curIdx = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512i bestIdx = _mm512_setzero_si512();
+    __m512 bestScore = _mm512_set1_ps(-FLT_MAX);
+
+    size_t idx = 0;
+    for (; idx + 16 <= size; idx += 16) {
+        const __m512 childVisits = _mm512_cvtepi32_ps(_mm512_loadu_si512(visits + idx));
+        const __m512 u = _mm512_div_ps(_mm512_mul_ps(factor, _mm512_loadu_ps(policy + idx)), _mm512_add_ps(childVisits, one));
+        const __m512 score = _mm512_add_ps(_mm512_loadu_ps(qValues + idx), u);
+        const __mmask16 greater = _mm512_cmp_ps_mask(score, bestScore, _CMP_GT_OQ);
+        bestScore = _mm512_mask_blend_ps(greater, bestScore, score);
+        bestIdx = _mm512_mask_blend_epi32(greater, bestIdx, curIdx);
+        curIdx = _mm512_add_epi32(curIdx, step);
+    }
+
+    alignas(64) float laneScores[16];
+    alignas(64) int32_t laneIndices[16];
+    _mm512_store_ps(laneScores, bestScore);
+    _mm512_store_si512(laneIndices, bestIdx);
+    TopTwo best;
+    for (size_t lane = 0; lane < 16 && lane < idx; ++lane) {
+        best.update(laneScores[lane], size_t(laneIndices[lane]));
+    }
+    for (; idx < size; ++idx) {
+        best.update(q_plus_u(qValues, policy, visits, idx, uFactor), idx);
+    }
+    return best.firstArg;
+}
+
+__attribute__((target("avx512f")))
+void first_and_second_argmax_q_plus_u_avx512(const float* qValues, const float* policy, const uint32_t* visits, size_t size, float uFactor, TopTwo& topTwo)
+{
+    const __m512 factor = _mm512_set1_ps(uFactor);
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512i step = _mm512_set1_epi32(16);
+    __m512i curIdx = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    __m512 firstScore = _mm512_set1_ps(-FLT_MAX);
+    __m512 secondScore = _mm512_set1_ps(-FLT_MAX);
+    __m512i firstIdx = _mm512_setzero_si512();
+    __m512i secondIdx = _mm512_setzero_si512();
+
+    size_t idx = 0;
+    for (; idx + 16 <= size; idx += 16) {
+        const __m512 childVisits = _mm512_cvtepi32_ps(_mm512_loadu_si512(visits + idx));
+        const __m512 u = _mm512_div_ps(_mm512_mul_ps(factor, _mm512_loadu_ps(policy + idx)), _mm512_add_ps(childVisits, one));
+        const __m512 score = _mm512_add_ps(_mm512_loadu_ps(qValues + idx), u);
+        const __mmask16 greaterFirst = _mm512_cmp_ps_mask(score, firstScore, _CMP_GT_OQ);
+        const __mmask16 greaterSecond = _mm512_cmp_ps_mask(score, secondScore, _CMP_GT_OQ);
+        // the second best becomes either the former first best, the new score or stays the same
+        secondScore = _mm512_mask_blend_ps(greaterFirst, _mm512_mask_blend_ps(greaterSecond, secondScore, score), firstScore);
+        secondIdx = _mm512_mask_blend_epi32(greaterFirst, _mm512_mask_blend_epi32(greaterSecond, secondIdx, curIdx), firstIdx);
+        firstScore = _mm512_mask_blend_ps(greaterFirst, firstScore, score);
+        firstIdx = _mm512_mask_blend_epi32(greaterFirst, firstIdx, curIdx);
+        curIdx = _mm512_add_epi32(curIdx, step);
+    }
+
+    alignas(64) float laneScores[32];
+    alignas(64) int32_t laneIndices[32];
+    _mm512_store_ps(laneScores, firstScore);
+    _mm512_store_ps(laneScores + 16, secondScore);
+    _mm512_store_si512(laneIndices, firstIdx);
+    _mm512_store_si512(laneIndices + 16, secondIdx);
+    for (size_t lane = 0; lane < 16 && lane < idx; ++lane) {
+        topTwo.update(laneScores[lane], size_t(laneIndices[lane]));
+        if (lane + 16 < idx) {
+            topTwo.update(laneScores[lane + 16], size_t(laneIndices[lane + 16]));
+        }
+    }
+    for (; idx < size; ++idx) {
+        topTwo.update(q_plus_u(qValues, policy, visits, idx, uFactor), idx);
+    }
+}
+#endif
+
+using ArgmaxKernel = size_t (*)(const float*, const float*, const uint32_t*, size_t, float);
+using TopTwoKernel = void (*)(const float*, const float*, const uint32_t*, size_t, float, TopTwo&);
+
+/**
+ * @brief The SelectionKernels struct holds the kernel versions for the instruction set of the current CPU
+ */
+struct SelectionKernels {
+    ArgmaxKernel argmax;
+    TopTwoKernel topTwo;
+    const char* name;
+
+    SelectionKernels() :
+        argmax(argmax_q_plus_u_scalar),
+        topTwo(first_and_second_argmax_q_plus_u_scalar),
+        name("scalar")
+    {
+#ifdef SELECTION_KERNEL_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            argmax = argmax_q_plus_u_avx512;
+            topTwo = first_and_second_argmax_q_plus_u_avx512;
+            name = "avx512";
+        }
+        else if (__builtin_cpu_supports("avx2")) {
+            argmax = argmax_q_plus_u_avx2;
+            topTwo = first_and_second_argmax_q_plus_u_avx2;
+            name = "avx2";
+        }
+#endif
+    }
+};
+
+// the CPU features are detected once at program start
+static const SelectionKernels selectionKernels;
+
+size_t argmax_q_plus_u(const float* qValues, const float* policy, const uint32_t* visits, size_t size, float uFactor)
+{
+    return selectionKernels.argmax(qValues, policy, visits, size, uFactor);
+}
+
+void first_and_second_argmax_q_plus_u(const float* qValues, const float* policy, const uint32_t* visits, size_t size, float uFactor,
+                                      float& firstMax, float& secondMax, size_t& firstArg, size_t& secondArg)
+{
+    TopTwo topTwo;
+    selectionKernels.topTwo(qValues, policy, visits, size, uFactor, topTwo);
+    firstMax = topTwo.firstMax;
+    secondMax = topTwo.secondMax;
+    firstArg = topTwo.firstArg;
+    secondArg = topTwo.secondArg;
+}
+
+const char* selection_kernel_name()
+{
+    return selectionKernels.name;
+}
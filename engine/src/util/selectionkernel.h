@@ -0,0 +1,69 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: selectionkernel.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Fused kernels for the PUCT child node selection which compute Q + U and the running maximum in a single pass
+ * without allocating temporary vectors. AVX2 and AVX-512 versions are selected at program start based on the CPU
+ * features, otherwise a scalar version is used.
+ * The score of a child node is defined as: qValues[i] + uFactor * policy[i] / (visits[i] + 1)
+ */
+
+#ifndef SELECTIONKERNEL_H
+#define SELECTIONKERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief argmax_q_plus_u Returns the index of the child node with the highest PUCT score.
+ * On equal scores the lower index is returned.
+ * @param qValues Q-values of the child nodes
+ * @param policy Prior probabilities of the child nodes
+ * @param visits Number of visits of the child nodes
+ * @param size Number of child nodes, must be > 0
+ * @param uFactor Factor for the exploration term (cpuct * sqrt(parent visits))
+ * @return Index of the best child node
+ */
+size_t argmax_q_plus_u(const float* qValues, const float* policy, const uint32_t* visits, size_t size, float uFactor);
+
+/**
+ * @brief first_and_second_argmax_q_plus_u Finds the child nodes with the highest and second highest PUCT score
+ * @param qValues Q-values of the child nodes
+ * @param policy Prior probabilities of the child nodes
+ * @param visits Number of visits of the child nodes
+ * @param size Number of child nodes, must be > 1
+ * @param uFactor Factor for the exploration term (cpuct * sqrt(parent visits))
+ * @param firstMax Return value for the highest score
+ * @param secondMax Return value for the second highest score
+ * @param firstArg Return value for the index of the highest score
+ * @param secondArg Return value for the index of the second highest score
+ */
+void first_and_second_argmax_q_plus_u(const float* qValues, const float* policy, const uint32_t* visits, size_t size, float uFactor,
+                                      float& firstMax, float& secondMax, size_t& firstArg, size_t& secondArg);
+
+/**
+ * @brief selection_kernel_name Returns the name of the instruction set which is used by the selection kernels
+ */
+const char* selection_kernel_name();
+
+#endif // SELECTIONKERNEL_H
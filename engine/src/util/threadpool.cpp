@@ -0,0 +1,93 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: threadpool.cpp
+ * Created on 18.10.2026
+ * @author: queensgambit
+ */
+
+#include "threadpool.h"
+
+ThreadPool::ThreadPool() :
+    idleWorkers(0),
+    terminate(false)
+{
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        unique_lock<mutex> lock(mtx);
+        terminate = true;
+        cv.notify_all();
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::run_worker()
+{
+    unique_lock<mutex> lock(mtx);
+    while (true) {
+        ++idleWorkers;
+        cv.wait(lock, [&]{return terminate || !tasks.empty();});
+        --idleWorkers;
+        if (tasks.empty()) {
+            return;
+        }
+        packaged_task<void()> task = move(tasks.front());
+        tasks.pop_front();
+        lock.unlock();
+        task();
+        lock.lock();
+    }
+}
+
+future<void> ThreadPool::submit(function<void()> task)
+{
+    packaged_task<void()> packagedTask(move(task));
+    future<void> result = packagedTask.get_future();
+    unique_lock<mutex> lock(mtx);
+    tasks.emplace_back(move(packagedTask));
+    if (tasks.size() > idleWorkers) {
+        workers.emplace_back(&ThreadPool::run_worker, this);
+    }
+    else {
+        cv.notify_one();
+    }
+    return result;
+}
+
+size_t ThreadPool::size()
+{
+    unique_lock<mutex> lock(mtx);
+    return workers.size();
+}
+
+void wait_for_tasks(vector<future<void>>& tasks)
+{
+    for (future<void>& task : tasks) {
+        task.wait();
+    }
+    for (future<void>& task : tasks) {
+        task.get();
+    }
+}
@@ -0,0 +1,85 @@
+/*
+  CrazyAra, a deep learning chess variant engine
+  Copyright (C) 2018       Johannes Czech, Moritz Willig, Alena Beyer
+  Copyright (C) 2019-2020  Johannes Czech
+
+  This program is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+*/
+
+/*
+ * @file: threadpool.h
+ * Created on 18.10.2026
+ * @author: queensgambit
+ *
+ * Pool of long-lived worker threads which are parked on a condition variable between their tasks.
+ * It replaces the creation of new threads for every move. The pool grows whenever a task is submitted
+ * while no worker is idle, so tasks which block on each other (e.g. the search threads and the thread manager)
+ * never wait for a free worker.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <deque>
+#include <vector>
+
+using namespace std;
+
+class ThreadPool
+{
+private:
+    vector<thread> workers;
+    deque<packaged_task<void()>> tasks;
+    mutex mtx;
+    condition_variable cv;
+    size_t idleWorkers;
+    bool terminate;
+
+    /**
+     * @brief run_worker Main loop of a worker which runs the submitted tasks until the pool is destroyed
+     */
+    void run_worker();
+
+public:
+    ThreadPool();
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief submit Runs the given task on a parked worker or on a new worker if all workers are busy
+     * @param task Task to run
+     * @return Future which becomes ready when the task has finished
+     */
+    future<void> submit(function<void()> task);
+
+    /**
+     * @brief size Returns the number of worker threads
+     */
+    size_t size();
+};
+
+/**
+ * @brief wait_for_tasks Waits until all given tasks have finished and rethrows the first exception of a failed task.
+ * All tasks are awaited before an exception is rethrown, so no task can still access state of the caller afterwards.
+ * @param tasks Futures returned by ThreadPool::submit()
+ */
+void wait_for_tasks(vector<future<void>>& tasks);
+
+#endif // THREADPOOL_H
@@ -31,6 +31,9 @@
 using namespace Catch::literals;
 using namespace std;
 #include <string>
+#include <fstream>
+#include <cstring>
+#include <unordered_map>
 #ifndef MODE_STRATEGO
 #if !defined(MODE_XIANGQI) && !defined(MODE_BOARDGAMES)
 #ifdef SF_DEPENDENCY
@@ -43,6 +46,16 @@ using namespace std;
 #include "environments/chess_related/inputrepresentation.h"
 #include "legacyconstants.h"
 #include "util/blazeutil.h"
+#include "util/poolallocator.h"
+#include "util/selectionkernel.h"
+#include "nncache.h"
+#include "util/threadpool.h"
+#include "util/randomgen.h"
+#include "backuptree.h"
+#include "transpositiontable.h"
+#include "treecheckpoint.h"
+#include "treepruner.h"
+#include "rootpartitioner.h"
 #include "environments/chess_related/boardstate.h"
 using namespace OptionsUCI;
 
@@ -645,6 +658,863 @@ TEST_CASE("Blaze: first_and_second_max()"){
     REQUIRE(secondArg == 4);
 }
 
+// ==========================================================================================================
+// ||                                         Util Tests                                                   ||
+// ==========================================================================================================
+
+TEST_CASE("PoolAllocator: reuse of freed blocks"){
+    PoolAllocator<double> allocator;
+    double* first = allocator.allocate(1);
+    allocator.deallocate(first, 1);
+    // the most recently freed block is handed out first
+    double* second = allocator.allocate(1);
+    REQUIRE(first == second);
+    allocator.deallocate(second, 1);
+
+    vector<shared_ptr<int>> values;
+    for (int idx = 0; idx < 10000; ++idx) {
+        values.emplace_back(allocate_shared<int>(PoolAllocator<int>(), idx));
+    }
+    for (int idx = 0; idx < 10000; ++idx) {
+        REQUIRE(*values[idx] == idx);
+    }
+}
+
+TEST_CASE("SelectionKernel: argmax of Q + U"){
+    // more entries than a single SIMD register to cover the vector loop and the remainder
+    const size_t size = 37;
+    vector<float> qValues(size, -0.5f);
+    vector<float> policy(size, 0.01f);
+    vector<uint32_t> visits(size, 10);
+    qValues[5] = 0.2f;
+    qValues[21] = 0.1f;
+    REQUIRE(argmax_q_plus_u(qValues.data(), policy.data(), visits.data(), size, 1.0f) == 5);
+
+    // an unvisited child node with a high prior wins by exploration
+    policy[33] = 0.9f;
+    visits[33] = 0;
+    REQUIRE(argmax_q_plus_u(qValues.data(), policy.data(), visits.data(), size, 2.0f) == 33);
+
+    float firstMax;
+    float secondMax;
+    size_t firstArg;
+    size_t secondArg;
+    first_and_second_argmax_q_plus_u(qValues.data(), policy.data(), visits.data(), size, 2.0f, firstMax, secondMax, firstArg, secondArg);
+    REQUIRE(firstArg == 33);
+    REQUIRE(secondArg == 5);
+    REQUIRE(firstMax == Catch::Approx(-0.5f + 2.0f * 0.9f));
+    REQUIRE(secondMax == Catch::Approx(0.2f + 2.0f * 0.01f / 11));
+
+    // ties are resolved in favour of the lower index
+    vector<float> equalQValues(size, 0.0f);
+    vector<uint32_t> equalVisits(size, 0);
+    vector<float> equalPolicy(size, 0.0f);
+    REQUIRE(argmax_q_plus_u(equalQValues.data(), equalPolicy.data(), equalVisits.data(), size, 1.0f) == 0);
+}
+
+TEST_CASE("NNCache: probe() and store()"){
+    NNCache nnCache(1);
+    REQUIRE(nnCache.is_enabled());
+    DynamicVector<float> policy = {0.5f, 0.25f, 0.125f, 0.125f};
+    nnCache.store(42, 0, 0.75f, policy);
+
+    float value = 0;
+    DynamicVector<float> cachedPolicy(policy.size());
+    REQUIRE(nnCache.probe(42, 0, value, cachedPolicy));
+    REQUIRE(value == 0.75f);
+    for (size_t idx = 0; idx < policy.size(); ++idx) {
+        REQUIRE(cachedPolicy[idx] == Catch::Approx(policy[idx]).epsilon(0.01));
+    }
+    // the side to move and the number of moves are part of the key
+    REQUIRE(!nnCache.probe(42, 1, value, cachedPolicy));
+    DynamicVector<float> otherPolicy(policy.size() + 1);
+    REQUIRE(!nnCache.probe(42, 0, value, otherPolicy));
+
+    nnCache.resize(0);
+    REQUIRE(!nnCache.is_enabled());
+    REQUIRE(!nnCache.probe(42, 0, value, cachedPolicy));
+}
+
+TEST_CASE("ThreadPool: submit()"){
+    ThreadPool threadPool;
+    atomic<int> counter(0);
+    threadPool.submit([&]() { ++counter; }).wait();
+    threadPool.submit([&]() { ++counter; }).wait();
+    REQUIRE(counter == 2);
+
+    // a task which waits for a later task must not block it
+    promise<void> signal;
+    shared_future<void> signalFuture = signal.get_future().share();
+    future<void> waitingTask = threadPool.submit([signalFuture]() { signalFuture.wait(); });
+    future<void> signalingTask = threadPool.submit([&]() { signal.set_value(); });
+    signalingTask.wait();
+    waitingTask.wait();
+    REQUIRE(threadPool.size() >= 2);
+}
+
+TEST_CASE("RandomGen: Xoshiro256"){
+    // the same master seed and stream lead to the same sequence
+    Xoshiro256 first(derive_seed(42, 1));
+    Xoshiro256 second(derive_seed(42, 1));
+    Xoshiro256 otherStream(derive_seed(42, 2));
+    bool differentStream = false;
+    for (size_t idx = 0; idx < 100; ++idx) {
+        const uint64_t value = first();
+        REQUIRE(value == second());
+        differentStream |= value != otherStream();
+    }
+    REQUIRE(differentStream);
+
+    for (size_t idx = 0; idx < 1000; ++idx) {
+        REQUIRE(first.below(7) < 7);
+        const double uniform = first.uniform();
+        REQUIRE(uniform >= 0.0);
+        REQUIRE(uniform < 1.0);
+    }
+}
+
+// ==========================================================================================================
+// ||                                         Search Tests                                                 ||
+// ==========================================================================================================
+
+// the nodes of the search tests don't own their states
+#ifndef MCTS_STORE_STATES
+// small tree with the nodes root(0) -> a(1), b(2), c(3) and the transposition node t(4) which is reached from a and b
+struct BackupTestTree {
+    vector<unique_ptr<Node>> nodes;
+    BackupTestTree(StateObj* state, const SearchSettings* searchSettings) {
+        for (size_t idx = 0; idx < 5; ++idx) {
+            nodes.emplace_back(make_unique<Node>(state));
+            nodes.back()->expand(state, searchSettings);
+            nodes.back()->init_node_data();
+            // reveal the first three child nodes
+            nodes.back()->increment_no_visit_idx();
+            nodes.back()->increment_no_visit_idx();
+        }
+        nodes[4]->add_transposition_parent_node();
+    }
+    Trajectory get_trajectory(const vector<pair<size_t, ChildIdx>>& steps, const SearchSettings* searchSettings) {
+        Trajectory trajectory;
+        for (const pair<size_t, ChildIdx>& step : steps) {
+            nodes[step.first]->apply_virtual_loss_to_child(step.second, searchSettings);
+            trajectory.emplace_back(nodes[step.first].get(), step.second);
+        }
+        return trajectory;
+    }
+};
+
+TEST_CASE("BackupTree: same statistics as backup_value()"){
+    init();
+    BoardState state;
+    state.init(get_default_variant(), false);
+    const vector<vector<pair<size_t, ChildIdx>>> warmUpSteps = {{{0, 0}, {1, 1}, {4, 0}}, {{0, 1}, {2, 0}, {4, 1}}, {{0, 0}, {1, 0}}};
+    const vector<float> warmUpValues = {0.4f, -0.2f, 0.1f};
+    // shared prefixes, a trajectory which ends on the inner edge root -> a and trajectories through the transposition node t
+    const vector<vector<pair<size_t, ChildIdx>>> batchSteps = {{{0, 0}, {1, 0}}, {{0, 0}}, {{0, 2}, {3, 0}}, {{0, 0}, {1, 1}, {4, 0}},
+                                                                {{0, 0}, {1, 0}}, {{0, 1}, {2, 0}, {4, 1}}, {{0, 0}, {1, 1}}, {{0, 2}, {3, 0}}};
+    const vector<float> batchValues = {0.3f, -0.5f, 0.7f, 0.2f, -0.1f, 0.6f, 0.25f, -0.4f};
+
+    for (VirtualStyle virtualStyle : {VIRTUAL_VISIT, VIRTUAL_LOSS, VIRTUAL_OFFSET}) {
+        SearchSettings searchSettings;
+        searchSettings.virtualStyle = virtualStyle;
+        BackupTestTree sequentialTree(&state, &searchSettings);
+        BackupTestTree batchedTree(&state, &searchSettings);
+        for (size_t idx = 0; idx < warmUpSteps.size(); ++idx) {
+            backup_value<false>(warmUpValues[idx], &searchSettings, sequentialTree.get_trajectory(warmUpSteps[idx], &searchSettings), false);
+            backup_value<false>(warmUpValues[idx], &searchSettings, batchedTree.get_trajectory(warmUpSteps[idx], &searchSettings), false);
+        }
+
+        // the virtual losses of the whole mini-batch are applied before the first backup
+        vector<Trajectory> sequentialTrajectories;
+        vector<Trajectory> batchedTrajectories;
+        for (const vector<pair<size_t, ChildIdx>>& steps : batchSteps) {
+            sequentialTrajectories.emplace_back(sequentialTree.get_trajectory(steps, &searchSettings));
+            batchedTrajectories.emplace_back(batchedTree.get_trajectory(steps, &searchSettings));
+        }
+        BackupTree backupTree;
+        for (size_t idx = 0; idx < batchSteps.size(); ++idx) {
+            backup_value<false>(batchValues[idx], &searchSettings, sequentialTrajectories[idx], false);
+            backupTree.add_trajectory<false>(batchValues[idx], &searchSettings, batchedTrajectories[idx], false);
+        }
+        backupTree.backup<false>(&searchSettings);
+
+        for (size_t nodeIdx = 0; nodeIdx < sequentialTree.nodes.size(); ++nodeIdx) {
+            const Node* sequentialNode = sequentialTree.nodes[nodeIdx].get();
+            const Node* batchedNode = batchedTree.nodes[nodeIdx].get();
+            REQUIRE(batchedNode->get_real_visits() == sequentialNode->get_real_visits());
+            REQUIRE(batchedNode->get_value_sum() == Catch::Approx(sequentialNode->get_value_sum()).margin(1e-5));
+            for (ChildIdx childIdx = 0; childIdx < 3; ++childIdx) {
+                REQUIRE(batchedNode->get_child_number_visits(childIdx) == sequentialNode->get_child_number_visits(childIdx));
+                REQUIRE(batchedNode->get_real_visits(childIdx) == sequentialNode->get_real_visits(childIdx));
+                REQUIRE(batchedNode->get_q_value(childIdx) == Catch::Approx(sequentialNode->get_q_value(childIdx)).margin(1e-5));
+            }
+        }
+    }
+}
+
+TEST_CASE("Lock-free updates: same statistics and selection as the locked updates"){
+    init();
+    BoardState state;
+    state.init(get_default_variant(), false);
+    const vector<vector<pair<size_t, ChildIdx>>> batchSteps = {{{0, 0}, {1, 1}, {4, 0}}, {{0, 1}, {2, 0}, {4, 1}}, {{0, 0}, {1, 0}},
+                                                                {{0, 2}, {3, 0}}, {{0, 0}}, {{0, 0}, {1, 1}, {4, 0}}};
+    const vector<float> batchValues = {0.4f, -0.2f, 0.1f, 0.7f, -0.5f, 0.3f};
+
+    for (VirtualStyle virtualStyle : {VIRTUAL_VISIT, VIRTUAL_LOSS, VIRTUAL_OFFSET}) {
+        SearchSettings lockedSettings;
+        lockedSettings.virtualStyle = virtualStyle;
+        SearchSettings lockFreeSettings = lockedSettings;
+        lockFreeSettings.lockFreeUpdates = true;
+        BackupTestTree lockedTree(&state, &lockedSettings);
+        BackupTestTree lockFreeTree(&state, &lockFreeSettings);
+        for (size_t nodeIdx = 0; nodeIdx < lockedTree.nodes.size(); ++nodeIdx) {
+            // the first selection sorts the revealed moves
+            REQUIRE(lockFreeTree.nodes[nodeIdx]->select_child_node(&lockFreeSettings) == lockedTree.nodes[nodeIdx]->select_child_node(&lockedSettings));
+        }
+        size_t lockFreeSelections = 0;
+        for (size_t round = 0; round < 3; ++round) {
+            // the virtual losses of the whole mini-batch are applied before the first backup
+            vector<Trajectory> lockedTrajectories;
+            vector<Trajectory> lockFreeTrajectories;
+            for (const vector<pair<size_t, ChildIdx>>& steps : batchSteps) {
+                lockedTrajectories.emplace_back(lockedTree.get_trajectory(steps, &lockedSettings));
+                lockFreeTrajectories.emplace_back(lockFreeTree.get_trajectory(steps, &lockFreeSettings));
+            }
+            for (size_t idx = 0; idx < batchSteps.size(); ++idx) {
+                backup_value<false>(batchValues[idx], &lockedSettings, lockedTrajectories[idx], false);
+                backup_value<false>(batchValues[idx], &lockFreeSettings, lockFreeTrajectories[idx], false);
+            }
+
+            for (size_t nodeIdx = 0; nodeIdx < lockedTree.nodes.size(); ++nodeIdx) {
+                Node* lockedNode = lockedTree.nodes[nodeIdx].get();
+                Node* lockFreeNode = lockFreeTree.nodes[nodeIdx].get();
+                REQUIRE(lockFreeNode->get_real_visits() == lockedNode->get_real_visits());
+                REQUIRE(lockFreeNode->get_visits() == lockedNode->get_visits());
+                REQUIRE(lockFreeNode->get_value_sum() == Catch::Approx(lockedNode->get_value_sum()).margin(1e-5));
+                for (ChildIdx childIdx = 0; childIdx < 3; ++childIdx) {
+                    REQUIRE(lockFreeNode->get_child_number_visits(childIdx) == lockedNode->get_child_number_visits(childIdx));
+                    REQUIRE(lockFreeNode->get_virtual_loss_counter(childIdx) == 0);
+                    REQUIRE(lockFreeNode->get_q_value(childIdx) == Catch::Approx(lockedNode->get_q_value(childIdx)).margin(1e-5));
+                }
+                // the lock-free selection only fails if it would reveal a new child node
+                const ChildIdx lockedIdx = lockedNode->select_child_node(&lockedSettings);
+                ChildIdx lockFreeIdx;
+                if (lockFreeNode->select_child_node_lock_free(&lockFreeSettings, lockFreeIdx)) {
+                    REQUIRE(lockFreeIdx == lockedIdx);
+                    ++lockFreeSelections;
+                }
+                else {
+                    REQUIRE(lockedIdx + 1 == lockedNode->get_no_visit_idx());
+                }
+                REQUIRE(lockFreeNode->select_child_node(&lockFreeSettings) == lockedIdx);
+            }
+        }
+        REQUIRE(lockFreeSelections != 0);
+    }
+}
+
+TEST_CASE("Lock-free updates: concurrent selections and backups"){
+    init();
+    BoardState state;
+    state.init(get_default_variant(), false);
+    SearchSettings searchSettings;
+    searchSettings.lockFreeUpdates = true;
+    BackupTestTree tree(&state, &searchSettings);
+    Node* node = tree.nodes[0].get();
+    // a uniform policy makes the selection reveal new child nodes
+    node->get_policy_prob_small() = 1.0f / node->get_number_child_nodes();
+    node->select_child_node(&searchSettings);
+    // the first virtual loss is applied while holding the lock and enables the lock-free selection
+    backup_value<false>(0.5f, &searchSettings, tree.get_trajectory({{0, 0}}, &searchSettings), false);
+
+    const size_t numberThreads = 4;
+    const size_t numberBackups = 2000;
+    vector<thread> threads;
+    for (size_t threadIdx = 0; threadIdx < numberThreads; ++threadIdx) {
+        threads.emplace_back([&]() {
+            for (size_t idx = 0; idx < numberBackups; ++idx) {
+                ChildIdx childIdx;
+                if (node->select_child_node_lock_free(&searchSettings, childIdx)) {
+                    node->apply_virtual_loss_to_child(childIdx, &searchSettings);
+                }
+                else {
+                    node->lock();
+                    childIdx = node->select_child_node(&searchSettings);
+                    if (childIdx + 1 == node->get_no_visit_idx()) {
+                        node->increment_no_visit_idx();
+                    }
+                    node->apply_virtual_loss_to_child(childIdx, &searchSettings);
+                    node->unlock();
+                }
+                backup_value<false>(0.5f, &searchSettings, {NodeAndIdx(node, childIdx)}, false);
+            }
+        });
+    }
+    for (thread& searchThread : threads) {
+        searchThread.join();
+    }
+
+    const uint32_t visits = numberThreads * numberBackups + 1;
+    REQUIRE(node->get_real_visits() == visits);
+    REQUIRE(node->get_visits() == visits);
+    REQUIRE(node->get_value_sum() == Catch::Approx(-0.5 * visits).margin(1e-3));
+    REQUIRE(node->get_no_visit_idx() > 3);
+    uint32_t childVisits = 0;
+    for (ChildIdx childIdx = 0; childIdx < node->get_no_visit_idx(); ++childIdx) {
+        childVisits += node->get_child_number_visits(childIdx);
+        REQUIRE(node->get_virtual_loss_counter(childIdx) == 0);
+        if (node->get_child_number_visits(childIdx) != 0) {
+            REQUIRE(node->get_q_value(childIdx) == Catch::Approx(-0.5).margin(1e-4));
+        }
+    }
+    REQUIRE(childVisits == visits);
+}
+
+/**
+ * @brief expand_test_node Expands the given node with all of its child nodes in the order of the legal actions and marks it as evaluated
+ */
+void expand_test_node(Node* node, StateObj* state, const SearchSettings* searchSettings)
+{
+    node->expand(state, searchSettings);
+    node->init_node_data();
+    node->fully_expand_node();
+    node->enable_has_nn_results();
+}
+
+/**
+ * @brief get_test_child_idx Returns the child index of the given move
+ */
+ChildIdx get_test_child_idx(const Node* node, const StateObj* state, string uciMove)
+{
+    const Action action = state->uci_to_action(uciMove);
+    ChildIdx childIdx = 0;
+    while (node->get_action(childIdx) != action) {
+        ++childIdx;
+    }
+    return childIdx;
+}
+
+/**
+ * @brief add_test_child_node Adds the child node for the given move to the tree and advances the state by the move
+ */
+Node* add_test_child_node(Node* node, StateObj* state, const string& uciMove, TranspositionTable* transpositionTable, const SearchSettings* searchSettings, bool& transposition)
+{
+    const ChildIdx childIdx = get_test_child_idx(node, state, uciMove);
+    state->do_action(node->get_action(childIdx));
+    Node* childNode = node->add_new_node_to_tree(transpositionTable, state, childIdx, searchSettings, transposition);
+    if (!transposition) {
+        expand_test_node(childNode, state, searchSettings);
+    }
+    return childNode;
+}
+
+TEST_CASE("TranspositionTable: transposed position reuses the node"){
+    init();
+    SearchSettings searchSettings;
+    TranspositionTable transpositionTable(1);
+    BoardState rootState;
+    rootState.init(get_default_variant(), false);
+    Node* rootNode = new Node(&rootState);
+    expand_test_node(rootNode, &rootState, &searchSettings);
+
+    bool transposition;
+    unique_ptr<StateObj> state = unique_ptr<StateObj>(rootState.clone());
+    Node* node = add_test_child_node(rootNode, state.get(), "g1f3", &transpositionTable, &searchSettings, transposition);
+    node = add_test_child_node(node, state.get(), "g8f6", &transpositionTable, &searchSettings, transposition);
+    Node* transpositionNode = add_test_child_node(node, state.get(), "b1c3", &transpositionTable, &searchSettings, transposition);
+    REQUIRE(!transposition);
+    REQUIRE(!transpositionNode->is_transposition());
+
+    state = unique_ptr<StateObj>(rootState.clone());
+    node = add_test_child_node(rootNode, state.get(), "b1c3", &transpositionTable, &searchSettings, transposition);
+    REQUIRE(!transposition);
+    node = add_test_child_node(node, state.get(), "g8f6", &transpositionTable, &searchSettings, transposition);
+    REQUIRE(!transposition);
+    REQUIRE(add_test_child_node(node, state.get(), "g1f3", &transpositionTable, &searchSettings, transposition) == transpositionNode);
+    REQUIRE(transposition);
+    REQUIRE(transpositionNode->is_transposition());
+    release_node(rootNode, &transpositionTable);
+    REQUIRE(transpositionTable.hashfull() == 0);
+}
+
+TEST_CASE("TranspositionTable: concurrent insert() and find()"){
+    init();
+    BoardState rootState;
+    rootState.init(get_default_variant(), false);
+    // all positions after two plies
+    vector<unique_ptr<Node>> nodes;
+    for (Action firstAction : rootState.legal_actions()) {
+        unique_ptr<StateObj> state = unique_ptr<StateObj>(rootState.clone());
+        state->do_action(firstAction);
+        for (Action secondAction : state->legal_actions()) {
+            unique_ptr<StateObj> childState = unique_ptr<StateObj>(state->clone());
+            childState->do_action(secondAction);
+            nodes.emplace_back(make_unique<Node>(childState.get()));
+        }
+    }
+
+    TranspositionTable transpositionTable(8);
+    const size_t numberThreads = 4;
+    atomic<size_t> misses(0);
+    vector<thread> threads;
+    for (size_t threadIdx = 0; threadIdx < numberThreads; ++threadIdx) {
+        threads.emplace_back([&, threadIdx]() {
+            for (size_t idx = threadIdx; idx < nodes.size(); idx += numberThreads) {
+                transpositionTable.insert(nodes[idx]->hash_key(), nodes[idx].get());
+                misses += transpositionTable.find(nodes[idx]->hash_key()) != nodes[idx].get();
+            }
+        });
+    }
+    for (thread& workerThread : threads) {
+        workerThread.join();
+    }
+    REQUIRE(misses == 0);
+    for (const unique_ptr<Node>& node : nodes) {
+        REQUIRE(transpositionTable.find(node->hash_key()) == node.get());
+    }
+}
+
+TEST_CASE("TranspositionTable: replacement within a bucket"){
+    init();
+    BoardState rootState;
+    rootState.init(get_default_variant(), false);
+    // positions after a single move with the given number of visits
+    const vector<uint32_t> visits = {5, 1, 3, 2, 4};
+    vector<unique_ptr<Node>> nodes;
+    for (size_t idx = 0; idx < visits.size(); ++idx) {
+        unique_ptr<StateObj> state = unique_ptr<StateObj>(rootState.clone());
+        state->do_action(rootState.legal_actions()[idx]);
+        nodes.emplace_back(make_unique<Node>(state.get()));
+        for (uint32_t visit = 0; visit < visits[idx]; ++visit) {
+            nodes.back()->set_value(0.0f);
+        }
+    }
+
+    // a table which is smaller than a bucket consists of a single bucket, so all keys compete for its entries
+    TranspositionTable transpositionTable(0);
+    REQUIRE(transpositionTable.hashfull() == 0);
+    transpositionTable.insert(nodes[0]->hash_key(), nodes[0].get());
+    REQUIRE(transpositionTable.hashfull() == 1000 / TT_BUCKET_SIZE);
+    transpositionTable.insert(nodes[1]->hash_key(), nodes[1].get());
+    transpositionTable.insert(nodes[2]->hash_key(), nodes[2].get());
+    REQUIRE(transpositionTable.hashfull() == 1000);
+
+    // the entry with the fewest visits is replaced
+    transpositionTable.insert(nodes[3]->hash_key(), nodes[3].get());
+    REQUIRE(transpositionTable.find(nodes[1]->hash_key()) == nullptr);
+    REQUIRE(transpositionTable.find(nodes[0]->hash_key()) == nodes[0].get());
+    REQUIRE(transpositionTable.find(nodes[2]->hash_key()) == nodes[2].get());
+    REQUIRE(transpositionTable.find(nodes[3]->hash_key()) == nodes[3].get());
+
+    // the visits are divided by the age, a lookup renews the entry
+    transpositionTable.new_search();
+    transpositionTable.new_search();
+    REQUIRE(transpositionTable.find(nodes[3]->hash_key()) == nodes[3].get());
+    transpositionTable.insert(nodes[4]->hash_key(), nodes[4].get());
+    REQUIRE(transpositionTable.find(nodes[2]->hash_key()) == nullptr);
+    REQUIRE(transpositionTable.find(nodes[0]->hash_key()) == nodes[0].get());
+    REQUIRE(transpositionTable.find(nodes[3]->hash_key()) == nodes[3].get());
+    REQUIRE(transpositionTable.find(nodes[4]->hash_key()) == nodes[4].get());
+
+    // empty entries are used first
+    REQUIRE(transpositionTable.erase(nodes[0]->hash_key(), nodes[0].get()));
+    REQUIRE(transpositionTable.find(nodes[0]->hash_key()) == nullptr);
+    REQUIRE(transpositionTable.hashfull() == 2 * 1000 / TT_BUCKET_SIZE);
+    transpositionTable.insert(nodes[1]->hash_key(), nodes[1].get());
+    REQUIRE(transpositionTable.hashfull() == 1000);
+    REQUIRE(transpositionTable.find(nodes[1]->hash_key()) == nodes[1].get());
+    REQUIRE(transpositionTable.find(nodes[3]->hash_key()) == nodes[3].get());
+    REQUIRE(transpositionTable.find(nodes[4]->hash_key()) == nodes[4].get());
+}
+
+TEST_CASE("release_node(): deep line and shared transpositions"){
+    init();
+    BoardState state;
+    state.init(get_default_variant(), false);
+    SearchSettings searchSettings;
+    const size_t treeMemory = get_tree_memory();
+
+    // a line which is too deep to be freed recursively
+    searchSettings.useMCGS = false;
+    bool transposition;
+    Node* rootNode = new Node(&state);
+    Node* node = rootNode;
+    for (size_t depth = 0; depth < 100000; ++depth) {
+        node->init_node_data(1);
+        node = node->add_new_node_to_tree(nullptr, &state, 0, &searchSettings, transposition);
+    }
+    REQUIRE(get_tree_memory() > treeMemory);
+    release_node(rootNode, nullptr);
+    REQUIRE(get_tree_memory() == treeMemory);
+
+    // a node which is still referenced outside of the released tree stays in the table
+    searchSettings.useMCGS = true;
+    TranspositionTable transpositionTable(1);
+    rootNode = new Node(&state);
+    expand_test_node(rootNode, &state, &searchSettings);
+    unique_ptr<StateObj> childState = unique_ptr<StateObj>(state.clone());
+    node = add_test_child_node(rootNode, childState.get(), "g1f3", &transpositionTable, &searchSettings, transposition);
+    node = add_test_child_node(node, childState.get(), "g8f6", &transpositionTable, &searchSettings, transposition);
+    Node* transpositionNode = add_test_child_node(node, childState.get(), "b1c3", &transpositionTable, &searchSettings, transposition);
+    childState = unique_ptr<StateObj>(state.clone());
+    node = add_test_child_node(rootNode, childState.get(), "b1c3", &transpositionTable, &searchSettings, transposition);
+    node = add_test_child_node(node, childState.get(), "g8f6", &transpositionTable, &searchSettings, transposition);
+    REQUIRE(add_test_child_node(node, childState.get(), "g1f3", &transpositionTable, &searchSettings, transposition) == transpositionNode);
+    const ChildIdx childIdx = get_test_child_idx(transpositionNode, childState.get(), "e7e5");
+    Node* grandChildNode = add_test_child_node(transpositionNode, childState.get(), "e7e5", &transpositionTable, &searchSettings, transposition);
+    const Key rootKey = rootNode->hash_key();
+
+    REQUIRE(transpositionNode->try_acquire_reference());
+    release_node(rootNode, &transpositionTable);
+    REQUIRE(transpositionTable.find(transpositionNode->hash_key()) == transpositionNode);
+    REQUIRE(transpositionTable.find(grandChildNode->hash_key()) == grandChildNode);
+    REQUIRE(transpositionTable.find(rootKey) == nullptr);
+    REQUIRE(transpositionNode->get_child_node(childIdx) == grandChildNode);
+    release_node(transpositionNode, &transpositionTable);
+    REQUIRE(transpositionTable.hashfull() == 0);
+    REQUIRE(get_tree_memory() == treeMemory);
+}
+
+TEST_CASE("TreePruner: pruned subtrees keep their statistics in the parent nodes"){
+    init();
+    BoardState rootState;
+    rootState.init(get_default_variant(), false);
+    SearchSettings searchSettings;
+    searchSettings.useMCGS = false;
+    searchSettings.treeMemoryMB = 4;
+    bool transposition;
+
+    // tree of depth three, the first child node of every node gets the most visits
+    Node* rootNode = new Node(&rootState);
+    expand_test_node(rootNode, &rootState, &searchSettings);
+    for (ChildIdx childIdx = 0; childIdx < rootNode->get_number_child_nodes(); ++childIdx) {
+        unique_ptr<StateObj> state = unique_ptr<StateObj>(rootState.clone());
+        state->do_action(rootNode->get_action(childIdx));
+        Node* childNode = rootNode->add_new_node_to_tree(nullptr, state.get(), childIdx, &searchSettings, transposition);
+        expand_test_node(childNode, state.get(), &searchSettings);
+        for (ChildIdx grandChildIdx = 0; grandChildIdx < childNode->get_number_child_nodes(); ++grandChildIdx) {
+            unique_ptr<StateObj> grandChildState = unique_ptr<StateObj>(state->clone());
+            grandChildState->do_action(childNode->get_action(grandChildIdx));
+            Node* grandChildNode = childNode->add_new_node_to_tree(nullptr, grandChildState.get(), grandChildIdx, &searchSettings, transposition);
+            expand_test_node(grandChildNode, grandChildState.get(), &searchSettings);
+            for (ChildIdx leafIdx = 0; leafIdx < grandChildNode->get_number_child_nodes(); ++leafIdx) {
+                unique_ptr<StateObj> leafState = unique_ptr<StateObj>(grandChildState->clone());
+                leafState->do_action(grandChildNode->get_action(leafIdx));
+                Node* leafNode = grandChildNode->add_new_node_to_tree(nullptr, leafState.get(), leafIdx, &searchSettings, transposition);
+                expand_test_node(leafNode, leafState.get(), &searchSettings);
+                const size_t visits = childIdx == 0 && grandChildIdx == 0 && leafIdx == 0 ? 1000 : (leafIdx == 0 ? 3 : 1);
+                for (size_t visit = 0; visit < visits; ++visit) {
+                    rootNode->apply_virtual_loss_to_child(childIdx, &searchSettings);
+                    childNode->apply_virtual_loss_to_child(grandChildIdx, &searchSettings);
+                    grandChildNode->apply_virtual_loss_to_child(leafIdx, &searchSettings);
+                    Trajectory trajectory = {NodeAndIdx(rootNode, childIdx), NodeAndIdx(childNode, grandChildIdx), NodeAndIdx(grandChildNode, leafIdx)};
+                    backup_value<false>(float(leafIdx % 3) * 0.3f - 0.3f, &searchSettings, trajectory, false);
+                }
+            }
+        }
+    }
+    vector<Node*> principalVariation;
+    for (Node* node = rootNode; node != nullptr; node = node->get_child_node(node->max_visits_child())) {
+        principalVariation.emplace_back(node);
+    }
+    REQUIRE(principalVariation.size() == 4);
+
+    // child statistics of all inner nodes
+    unordered_map<const Node*, vector<pair<uint32_t, float>>> childStatistics;
+    vector<const Node*> pendingNodes = {rootNode};
+    while (!pendingNodes.empty()) {
+        const Node* node = pendingNodes.back();
+        pendingNodes.pop_back();
+        for (ChildIdx childIdx = 0; childIdx < node->get_number_child_nodes(); ++childIdx) {
+            childStatistics[node].emplace_back(node->get_child_number_visits(childIdx), node->get_q_value(childIdx));
+            if (node->get_child_node(childIdx) != nullptr) {
+                pendingNodes.emplace_back(node->get_child_node(childIdx));
+            }
+        }
+    }
+
+    TreePruner treePruner(nullptr);
+    treePruner.set_active_threads(1);
+    treePruner.init_tree_memory(rootNode, &searchSettings);
+    REQUIRE(treePruner.get_tree_memory() == get_subtree_memory(rootNode));
+    REQUIRE(treePruner.is_prune_due(&searchSettings));
+    treePruner.connect_thread();
+    treePruner.sync_and_prune(rootNode, &searchSettings);
+    treePruner.disconnect_thread();
+    REQUIRE(!treePruner.is_prune_due(&searchSettings));
+    REQUIRE(treePruner.get_tree_memory() == get_subtree_memory(rootNode));
+    REQUIRE(treePruner.get_tree_memory() <= searchSettings.treeMemoryMB * 1024 * 1024 * PRUNE_TARGET_FRACTION);
+
+    // the parent nodes keep the statistics of the pruned child nodes
+    size_t prunedNodes = 0;
+    pendingNodes = {rootNode};
+    while (!pendingNodes.empty()) {
+        const Node* node = pendingNodes.back();
+        pendingNodes.pop_back();
+        for (ChildIdx childIdx = 0; childIdx < node->get_number_child_nodes(); ++childIdx) {
+            REQUIRE(node->get_child_number_visits(childIdx) == childStatistics[node][childIdx].first);
+            REQUIRE(node->get_q_value(childIdx) == Catch::Approx(childStatistics[node][childIdx].second));
+            if (node->get_child_node(childIdx) == nullptr) {
+                // the child nodes of the root node are never pruned
+                REQUIRE(node != rootNode);
+                ++prunedNodes;
+            }
+            else {
+                pendingNodes.emplace_back(node->get_child_node(childIdx));
+            }
+        }
+    }
+    REQUIRE(prunedNodes != 0);
+    // the principal variation and the best child node of every node are kept
+    for (size_t depth = 0; depth + 1 < principalVariation.size(); ++depth) {
+        REQUIRE(principalVariation[depth]->get_child_node(principalVariation[depth]->max_visits_child()) == principalVariation[depth + 1]);
+    }
+    for (ChildIdx childIdx = 0; childIdx < rootNode->get_number_child_nodes(); ++childIdx) {
+        const Node* childNode = rootNode->get_child_node(childIdx);
+        REQUIRE(childNode->get_child_node(childNode->max_visits_child()) != nullptr);
+    }
+    release_node(rootNode, nullptr);
+}
+
+TEST_CASE("Node: sort_moves_up_to() reveals the moves in descending prior order"){
+    init();
+    BoardState state;
+    state.init(get_default_variant(), false);
+    SearchSettings searchSettings;
+    Node node(&state);
+    node.expand(&state, &searchSettings);
+    node.init_node_data();
+    // the moves are revealed in chunks of PRESERVED_ITEMS, 2 * PRESERVED_ITEMS, ... moves
+    REQUIRE(node.get_number_child_nodes() > 2 * PRESERVED_ITEMS);
+
+    // distinct priors in an order which differs from the order of the legal actions
+    unordered_map<Action, float> priors;
+    for (ChildIdx childIdx = 0; childIdx < node.get_number_child_nodes(); ++childIdx) {
+        const float prior = float((childIdx * 7) % node.get_number_child_nodes() + 1);
+        node.get_policy_prob_small()[childIdx] = prior;
+        priors[node.get_action(childIdx)] = prior;
+    }
+    node.prepare_node_for_visits();
+    while (true) {
+        const ChildIdx noVisitIdx = node.get_no_visit_idx();
+        for (ChildIdx childIdx = 0; childIdx < node.get_number_child_nodes(); ++childIdx) {
+            // every prior still belongs to its move
+            REQUIRE(node.get_policy_prob_small()[childIdx] == priors[node.get_action(childIdx)]);
+            if (childIdx > 0 && childIdx < noVisitIdx) {
+                REQUIRE(node.get_policy_prob_small()[childIdx - 1] > node.get_policy_prob_small()[childIdx]);
+            }
+            // the revealed moves have a higher prior than all remaining moves
+            if (childIdx >= noVisitIdx) {
+                REQUIRE(node.get_policy_prob_small()[noVisitIdx - 1] > node.get_policy_prob_small()[childIdx]);
+            }
+        }
+        if (noVisitIdx == node.get_number_child_nodes()) {
+            break;
+        }
+        node.increment_no_visit_idx();
+    }
+    REQUIRE(node.get_policy_prob_small()[0] == float(node.get_number_child_nodes()));
+    REQUIRE(node.get_policy_prob_small()[node.get_number_child_nodes() - 1] == 1.0f);
+}
+
+TEST_CASE("RootPartitioner: finish() merges the backups of all partitions"){
+    init();
+    BoardState state;
+    state.init(get_default_variant(), false);
+    SearchSettings searchSettings;
+    Node rootNode(&state);
+    rootNode.expand(&state, &searchSettings);
+    rootNode.init_node_data();
+    rootNode.enable_has_nn_results();
+    rootNode.set_value(0.1f);
+    const uint32_t rootVisits = rootNode.get_visits();
+    const uint32_t rootRealVisits = rootNode.get_real_visits();
+    const double rootValueSum = rootNode.get_value_sum();
+    const uint32_t rootFreeVisits = rootNode.get_free_visits();
+
+    const size_t numberPartitions = 3;
+    // the number of backups isn't a multiple of the merge interval, so statistics are still pending when the search ends
+    const size_t numberBackups = 5 * ROOT_PARTITION_MERGE_INTERVAL + 7;
+    RootPartitioner rootPartitioner(&searchSettings);
+    rootPartitioner.start(&rootNode, numberPartitions);
+    REQUIRE(rootPartitioner.is_active());
+    REQUIRE(rootPartitioner.get_number_partitions() == numberPartitions);
+    vector<double> valueSums(numberPartitions, 0.0);
+    vector<size_t> freeBackups(numberPartitions, 0);
+    vector<thread> threads;
+    for (size_t partitionIdx = 0; partitionIdx < numberPartitions; ++partitionIdx) {
+        threads.emplace_back([&, partitionIdx]() {
+            for (size_t backupIdx = 0; backupIdx < numberBackups; ++backupIdx) {
+                // a collision only reverts the virtual loss
+                rootPartitioner.revert_virtual_loss(rootPartitioner.select_child_node(partitionIdx));
+                const ChildIdx childIdx = rootPartitioner.select_child_node(partitionIdx);
+                const float value = float(int(backupIdx % 5) - 2) * 0.25f + float(partitionIdx) * 0.1f;
+                const bool freeBackup = backupIdx % 4 == 0;
+                rootPartitioner.revert_virtual_loss_and_update(childIdx, value, freeBackup);
+                valueSums[partitionIdx] += value;
+                freeBackups[partitionIdx] += freeBackup;
+            }
+        });
+    }
+    for (thread& workerThread : threads) {
+        workerThread.join();
+    }
+    rootPartitioner.finish();
+    REQUIRE(!rootPartitioner.is_active());
+
+    double valueSum = 0;
+    size_t freeVisits = 0;
+    for (size_t partitionIdx = 0; partitionIdx < numberPartitions; ++partitionIdx) {
+        valueSum += valueSums[partitionIdx];
+        freeVisits += freeBackups[partitionIdx];
+    }
+    REQUIRE(rootNode.get_visits() == rootVisits + numberPartitions * numberBackups);
+    REQUIRE(rootNode.get_real_visits() == rootRealVisits + numberPartitions * numberBackups);
+    REQUIRE(rootNode.get_value_sum() == Catch::Approx(rootValueSum + valueSum).margin(1e-4));
+    REQUIRE(rootNode.get_free_visits() == rootFreeVisits + freeVisits);
+    uint32_t childVisits = 0;
+    for (ChildIdx childIdx = 0; childIdx < rootNode.get_number_child_nodes(); ++childIdx) {
+        childVisits += rootNode.get_child_number_visits(childIdx);
+    }
+    REQUIRE(childVisits == numberPartitions * numberBackups);
+}
+
+/**
+ * @brief require_equal_trees Compares the statistics of both trees, every node of the first tree must correspond to a single node of the second tree
+ */
+void require_equal_trees(const Node* node, const Node* loadedNode, unordered_map<const Node*, const Node*>& loadedNodes)
+{
+    const auto it = loadedNodes.find(node);
+    if (it != loadedNodes.end()) {
+        // a transposition must lead to the same restored node
+        REQUIRE(it->second == loadedNode);
+        return;
+    }
+    loadedNodes.emplace(node, loadedNode);
+    REQUIRE(loadedNode->hash_key() == node->hash_key());
+    REQUIRE(loadedNode->get_visits() == node->get_visits());
+    REQUIRE(loadedNode->get_real_visits() == node->get_real_visits());
+    REQUIRE(loadedNode->get_value_sum() == node->get_value_sum());
+    REQUIRE(loadedNode->get_no_visit_idx() == node->get_no_visit_idx());
+    REQUIRE(loadedNode->is_transposition() == node->is_transposition());
+    for (ChildIdx childIdx = 0; childIdx < node->get_no_visit_idx(); ++childIdx) {
+        REQUIRE(loadedNode->get_action(childIdx) == node->get_action(childIdx));
+        REQUIRE(loadedNode->get_q_value(childIdx) == node->get_q_value(childIdx));
+        REQUIRE(loadedNode->get_child_number_visits(childIdx) == node->get_child_number_visits(childIdx));
+        const Node* childNode = node->get_child_node(childIdx);
+        REQUIRE((loadedNode->get_child_node(childIdx) == nullptr) == (childNode == nullptr));
+        if (childNode != nullptr) {
+            require_equal_trees(childNode, loadedNode->get_child_node(childIdx), loadedNodes);
+        }
+    }
+}
+
+TEST_CASE("TreeCheckpoint: save and load"){
+    init();
+    SearchSettings searchSettings;
+    TranspositionTable transpositionTable(1);
+    BoardState rootState;
+    rootState.init(get_default_variant(), false);
+    Node* rootNode = new Node(&rootState);
+    expand_test_node(rootNode, &rootState, &searchSettings);
+
+    // both paths lead to the same position
+    const vector<vector<string>> paths = {{"g1f3", "g8f6", "b1c3"}, {"b1c3", "g8f6", "g1f3"}, {"e2e4"}};
+    vector<Trajectory> trajectories;
+    for (const vector<string>& path : paths) {
+        Trajectory trajectory;
+        unique_ptr<StateObj> state = unique_ptr<StateObj>(rootState.clone());
+        Node* node = rootNode;
+        bool transposition;
+        for (const string& uciMove : path) {
+            trajectory.emplace_back(node, get_test_child_idx(node, state.get(), uciMove));
+            node = add_test_child_node(node, state.get(), uciMove, &transpositionTable, &searchSettings, transposition);
+        }
+        trajectories.emplace_back(trajectory);
+    }
+    for (size_t idx = 0; idx < 7; ++idx) {
+        const Trajectory& trajectory = trajectories[idx % trajectories.size()];
+        for (const NodeAndIdx& step : trajectory) {
+            step.node->apply_virtual_loss_to_child(step.childIdx, &searchSettings);
+        }
+        backup_value<false>(0.1f * idx - 0.3f, &searchSettings, trajectory, false);
+    }
+
+    const string filename = "tree_checkpoint_test.bin";
+    REQUIRE(save_tree_checkpoint(rootNode, filename));
+    TranspositionTable loadedTranspositionTable(1);
+    Node* loadedRootNode = load_tree_checkpoint(&rootState, filename, &loadedTranspositionTable, &searchSettings);
+    REQUIRE(loadedRootNode != nullptr);
+    unordered_map<const Node*, const Node*> loadedNodes;
+    require_equal_trees(rootNode, loadedRootNode, loadedNodes);
+    // root, the three nodes of the first path, two nodes of the second path and the node of the last path
+    REQUIRE(loadedNodes.size() == 7);
+    release_node(loadedRootNode, &loadedTranspositionTable);
+
+    ifstream inFile(filename, ios::binary);
+    const string content = string(istreambuf_iterator<char>(inFile), istreambuf_iterator<char>());
+    inFile.close();
+
+    // truncated file
+    ofstream(filename, ios::binary) << content.substr(0, content.size() - 1);
+    REQUIRE(load_tree_checkpoint(&rootState, filename, &loadedTranspositionTable, &searchSettings) == nullptr);
+
+    // the child index of the last stored child node is out of range
+    CheckpointHeader header;
+    memcpy(&header, content.data(), sizeof(header));
+    string corruptedContent = content;
+    const size_t firstMoveOffset = sizeof(CheckpointHeader) + header.numberNodes * sizeof(CheckpointNode);
+    size_t moveIdx = header.numberMoves;
+    CheckpointMove checkpointMove;
+    do {
+        --moveIdx;
+        memcpy(&checkpointMove, corruptedContent.data() + firstMoveOffset + moveIdx * sizeof(CheckpointMove), sizeof(checkpointMove));
+    } while (checkpointMove.childNode == NO_CHECKPOINT_CHILD);
+    checkpointMove.childNode = uint32_t(header.numberNodes);
+    memcpy(&corruptedContent[firstMoveOffset + moveIdx * sizeof(CheckpointMove)], &checkpointMove, sizeof(checkpointMove));
+    ofstream(filename, ios::binary) << corruptedContent;
+    REQUIRE(load_tree_checkpoint(&rootState, filename, &loadedTranspositionTable, &searchSettings) == nullptr);
+    REQUIRE(loadedTranspositionTable.hashfull() == 0);
+    // the first and the last stored root child are the same node, so the edge of the last one leads to a position with a different key
+    const size_t rootMoveOffset = firstMoveOffset;
+    CheckpointNode rootRecord;
+    memcpy(&rootRecord, content.data() + sizeof(CheckpointHeader), sizeof(rootRecord));
+    vector<CheckpointMove> rootMoves(rootRecord.numberMoves);
+    memcpy(rootMoves.data(), content.data() + rootMoveOffset, rootMoves.size() * sizeof(CheckpointMove));
+    size_t firstChildIdx = 0;
+    while (rootMoves[firstChildIdx].childNode == NO_CHECKPOINT_CHILD) {
+        ++firstChildIdx;
+    }
+    size_t lastChildIdx = rootMoves.size() - 1;
+    while (rootMoves[lastChildIdx].childNode == NO_CHECKPOINT_CHILD) {
+        --lastChildIdx;
+    }
+    REQUIRE(firstChildIdx < lastChildIdx);
+    corruptedContent = content;
+    checkpointMove = rootMoves[lastChildIdx];
+    checkpointMove.childNode = rootMoves[firstChildIdx].childNode;
+    memcpy(&corruptedContent[rootMoveOffset + lastChildIdx * sizeof(CheckpointMove)], &checkpointMove, sizeof(checkpointMove));
+    ofstream(filename, ios::binary) << corruptedContent;
+    REQUIRE(load_tree_checkpoint(&rootState, filename, &loadedTranspositionTable, &searchSettings) == nullptr);
+
+    // a move of the root node is replaced by another legal move, so the number of moves matches but the set of moves doesn't
+    size_t unexpandedIdx = rootMoves.size() - 1;
+    while (rootMoves[unexpandedIdx].childNode != NO_CHECKPOINT_CHILD) {
+        --unexpandedIdx;
+    }
+    corruptedContent = content;
+    checkpointMove = rootMoves[unexpandedIdx];
+    checkpointMove.action = rootMoves[unexpandedIdx == 0 ? 1 : 0].action;
+    memcpy(&corruptedContent[rootMoveOffset + unexpandedIdx * sizeof(CheckpointMove)], &checkpointMove, sizeof(checkpointMove));
+    ofstream(filename, ios::binary) << corruptedContent;
+    REQUIRE(load_tree_checkpoint(&rootState, filename, &loadedTranspositionTable, &searchSettings) == nullptr);
+    REQUIRE(loadedTranspositionTable.hashfull() == 0);
+
+    remove(filename.c_str());
+    release_node(rootNode, &transpositionTable);
+}
+#endif
+
 // ==========================================================================================================
 // ||                                   State Environment Tests                                            ||
 // ==========================================================================================================
@@ -738,6 +1608,37 @@ TEST_CASE("State: clone()"){
     unique_ptr<StateObj> state2 = unique_ptr<StateObj>(state.clone());
     REQUIRE(state2->fen() == state.fen());
 }
+
+TEST_CASE("State: undo_action()"){
+    srand(543);
+    StateObj state;
+    state.init(0, false);
+    apply_random_moves(state, 5);
+    unique_ptr<StateObj> stateBefore = unique_ptr<StateObj>(state.clone());
+
+    // apply more moves than the number of last moves in the input representation and undo them again
+    vector<Action> appliedActions;
+    for (uint idx = 0; idx < 20; ++idx) {
+        vector<Action> actions = state.legal_actions();
+        float dummy;
+        if (state.is_terminal(actions.size(), dummy) != TERMINAL_NONE)  {
+            break;
+        }
+        appliedActions.emplace_back(actions[random() % actions.size()]);
+        state.do_action(appliedActions.back());
+    }
+    for (auto it = appliedActions.rbegin(); it != appliedActions.rend(); ++it) {
+        state.undo_action(*it);
+    }
+
+    REQUIRE(state.fen() == stateBefore->fen());
+    REQUIRE(state.steps_from_null() == stateBefore->steps_from_null());
+    vector<float> inputPlanes(StateConstants::NB_VALUES_TOTAL());
+    vector<float> inputPlanesBefore(StateConstants::NB_VALUES_TOTAL());
+    state.get_state_planes(true, inputPlanes.data(), StateConstants::CURRENT_VERSION());
+    stateBefore->get_state_planes(true, inputPlanesBefore.data(), StateConstants::CURRENT_VERSION());
+    REQUIRE(inputPlanes == inputPlanesBefore);
+}
 #elif defined(MODE_XIANGQI) || defined(MODE_BOARDGAMES)
 #include "piece.h"
 #include "thread.h"